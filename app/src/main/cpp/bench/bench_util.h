@@ -0,0 +1,60 @@
+#pragma once
+
+// Timing helpers shared by the host benchmarks
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+const Resolution kResolutions[] = {
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4K", 3840, 2160},
+};
+
+struct Timing {
+    double medianMs;
+    double p99Ms;
+    double meanMs;
+};
+
+// Returns the value at the given percentile (0..100) using nearest rank
+inline double percentile(std::vector<double> samples, double pct) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(pct / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+inline Timing summarize(const std::vector<double>& samplesMs) {
+    double sum = 0.0;
+    for (double s : samplesMs) {
+        sum += s;
+    }
+    return {percentile(samplesMs, 50.0), percentile(samplesMs, 99.0),
+            samplesMs.empty() ? 0.0 : sum / samplesMs.size()};
+}
+
+// Runs `frame` warmup + frames times and summarizes the timed iterations
+inline Timing timeFrames(int frames, int warmup, const std::function<void()>& frame) {
+    std::vector<double> samplesMs;
+    samplesMs.reserve(frames);
+    for (int i = 0; i < warmup + frames; i++) {
+        auto start = std::chrono::steady_clock::now();
+        frame();
+        auto end = std::chrono::steady_clock::now();
+        if (i >= warmup) {
+            samplesMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    return summarize(samplesMs);
+}
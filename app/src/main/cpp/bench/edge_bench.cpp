@@ -0,0 +1,910 @@
+// Host benchmark for the edge core library.
+//
+// Runs the same CPU pipeline the renderer uses on synthetic RGBA frames and
+// reports per-resolution throughput with median and p99 frame times, so
+// regressions can be caught without a device. Every optimized path is also
+// checked bit-for-bit against the reference; the exit code is non-zero on
+// any mismatch, including orientUpright disagreeing with the display shader.
+//
+// The renderer's worker loop is also replayed with its Mats drawing from a
+// FramePool while every operator new is counted; after warm-up a frame must
+// not touch the heap. Buffers submitted from Java are swapped into its slots
+// without a copy, rejected when passed back with the wrong size, and never
+// freed while Java still holds them.
+//
+// The still-image path (NativeBridge.processImage) is checked against the
+// reference on caller-owned buffers with padded rows, and must not touch the
+// heap once its workspace has grown.
+//
+// Batches of thumbnails go through the ImagePool behind
+// NativeBridge.processImages at increasing thread counts, reported as
+// images/sec against spawning a thread per image, and checked against the
+// still-image path.
+//
+// The reduced processing scales (EdgeParams::downscale 2 and 4) are timed
+// against full resolution, and their edges, magnified back the way the GPU
+// shows them, are scored against the full-resolution edges (F1). The SIMD
+// area downscale must agree with cv::resize(INTER_AREA) to within 1.
+//
+// The motion gate must skip a static scene under sensor noise down to its
+// refresh interval, and let every frame of a moving object through.
+//
+// A stage breakdown times the kernel's phases through the renderer's
+// StageStats histograms and checks their percentiles against exact ones.
+//
+// Usage: edge_bench [--frames N] [--warmup N] [--max-threads N]
+//                   [--yuv FILE --size WxH] [--trace FILE]
+//
+// --yuv replays a recorded file of concatenated NV21/I420 frames through the
+// luma-plane path in addition to the synthetic YUV frames.
+//
+// --trace measures what tracing adds to a frame, then records the whole run
+// and writes it to FILE as Chrome trace JSON (open in ui.perfetto.dev).
+
+#include "bench_util.h"
+#include "edge_pipeline.h"
+#include "frame_pool.h"
+#include "fused_canny.h"
+#include "image_pool.h"
+#include "motion_gate.h"
+#include "stage_stats.h"
+#include "synthetic_frame.h"
+#include "trace.h"
+#include "triple_buffer.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Every heap allocation made through operator new, from any thread
+static std::atomic<long> g_heapAllocations{0};
+
+void* operator new(size_t size) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct BenchOptions {
+    int frames = 200;
+    int warmup = 20;
+    int maxThreads = 0;  // 0 = cv::getNumThreads()
+    std::string yuvFile;  // Recorded NV21/I420 frames
+    int yuvWidth = 0;
+    int yuvHeight = 0;
+    std::string tracePath;  // Chrome trace output
+};
+
+// Pre-fusion pipeline: flip, cvtColor, Canny, cvtColor, flip
+void referenceReadbackFrame(const cv::Mat& readback, cv::Mat& output, const EdgeParams& params) {
+    cv::Mat flipped;
+    cv::flip(readback, flipped, 0);
+    cv::flip(processFrameWithCanny(flipped, params), output, 0);
+}
+
+Timing benchLoop(const BenchOptions& options, const std::function<void()>& frame) {
+    return timeFrames(options.frames, options.warmup, frame);
+}
+
+// Number of pixels where two 8-bit images differ in any channel
+int countMismatches(const cv::Mat& a, const cv::Mat& b) {
+    cv::Mat diff;
+    cv::absdiff(a, b, diff);
+    return cv::countNonZero(diff.reshape(1, diff.rows * diff.channels()));
+}
+
+void printHeader() {
+    std::printf("%-8s %-10s %10s %10s %10s %10s %10s\n",
+                "res", "pipeline", "median_ms", "p99_ms", "mean_ms", "fps", "MPix/s");
+}
+
+void printRow(const Resolution& res, const char* pipeline, const Timing& t) {
+    double fps = t.medianMs > 0.0 ? 1000.0 / t.medianMs : 0.0;
+    double mpix = fps * res.width * res.height / 1e6;
+    std::printf("%-8s %-10s %10.3f %10.3f %10.3f %10.1f %10.1f\n",
+                res.name, pipeline, t.medianMs, t.p99Ms, t.meanMs, fps, mpix);
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--max-threads") == 0 && hasValue) {
+            options.maxThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--yuv") == 0 && hasValue) {
+            options.yuvFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            std::sscanf(argv[++i], "%dx%d", &options.yuvWidth, &options.yuvHeight);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--frames N] [--warmup N] [--max-threads N] "
+                         "[--yuv FILE --size WxH] [--trace FILE]\n", argv[0]);
+            return false;
+        }
+    }
+    if (!options.yuvFile.empty() && (options.yuvWidth <= 0 || options.yuvHeight <= 0)) {
+        std::fprintf(stderr, "--yuv needs --size WxH\n");
+        return false;
+    }
+    return true;
+}
+
+bool matchesReference(const Resolution& res, const char* pipeline,
+                      const cv::Mat& reference, const cv::Mat& output) {
+    int diff = countMismatches(reference, output);
+    if (diff != 0) {
+        std::fprintf(stderr, "%s: %s output differs from reference in %d pixels\n",
+                     res.name, pipeline, diff);
+    }
+    return diff == 0;
+}
+
+// Thread counts for scaling sweeps: powers of two up to and including max
+std::vector<int> threadSweep(int maxThreads) {
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// Old multi-pass pipeline against the fused kernel, single stripe
+int benchPipelines(const BenchOptions& options) {
+    int mismatched = 0;
+    printHeader();
+    for (const Resolution& res : kResolutions) {
+        cv::Mat readback = makeSyntheticFrame(res.width, res.height);
+        cv::Mat reference(res.height, res.width, CV_8UC4);
+        cv::Mat fused(res.height, res.width, CV_8UC4);
+        EdgeParams params;
+        params.stripes = 1;
+        CannyWorkspace workspace;
+
+        printRow(res, "reference", benchLoop(options, [&] {
+            referenceReadbackFrame(readback, reference, params);
+        }));
+        printRow(res, "fused", benchLoop(options, [&] {
+            processReadbackFrame(readback, fused, params, &workspace);
+        }));
+
+        if (!matchesReference(res, "fused", reference, fused)) {
+            mismatched++;
+        }
+    }
+    return mismatched;
+}
+
+// Stripe-parallel kernel with one stripe per OpenCV thread
+int benchStripeScaling(const BenchOptions& options) {
+    const int initialThreads = cv::getNumThreads();
+    int maxThreads = options.maxThreads > 0 ? options.maxThreads : initialThreads;
+    int mismatched = 0;
+
+    std::printf("\nstripe scaling (1..%d threads)\n", maxThreads);
+    std::printf("%-8s %8s %8s %10s %10s %8s\n",
+                "res", "threads", "stripes", "median_ms", "p99_ms", "speedup");
+    for (const Resolution& res : kResolutions) {
+        cv::Mat readback = makeSyntheticFrame(res.width, res.height);
+        cv::Mat reference(res.height, res.width, CV_8UC4);
+        cv::Mat striped(res.height, res.width, CV_8UC4);
+        referenceReadbackFrame(readback, reference, EdgeParams());
+
+        double baseMs = 0.0;
+        for (int threads : threadSweep(maxThreads)) {
+            cv::setNumThreads(threads);
+            EdgeParams params;
+            params.stripes = threads;
+            CannyWorkspace workspace;
+            Timing t = benchLoop(options, [&] {
+                processReadbackFrame(readback, striped, params, &workspace);
+            });
+            if (threads == 1) {
+                baseMs = t.medianMs;
+            }
+            std::printf("%-8s %8d %8d %10.3f %10.3f %7.2fx\n", res.name, threads,
+                        cannyStripeCount(params, res.height), t.medianMs, t.p99Ms,
+                        t.medianMs > 0.0 ? baseMs / t.medianMs : 0.0);
+            if (!matchesReference(res, "striped", reference, striped)) {
+                mismatched++;
+            }
+        }
+    }
+    cv::setNumThreads(initialThreads);
+    return mismatched;
+}
+
+// Reference for the luma path: Canny on the upright plane, flipped for GL
+void referenceLumaEdges(const cv::Mat& luma, cv::Mat& edges, const EdgeParams& params) {
+    cv::Mat upright;
+    cv::Canny(luma, upright, params.lowThreshold, params.highThreshold);
+    cv::flip(upright, edges, 0);
+}
+
+// Canny straight on the Y plane of synthetic NV21 frames, with packed and
+// interleaved (pixel stride 2) luma samples
+int benchLumaPlane(const BenchOptions& options) {
+    int mismatched = 0;
+    std::printf("\nluma plane (YUV input)\n");
+    printHeader();
+    for (const Resolution& res : kResolutions) {
+        cv::Mat yuv;
+        cv::cvtColor(makeSyntheticFrame(res.width, res.height), yuv, cv::COLOR_RGBA2YUV_YV12);
+        cv::Mat luma = yuv.rowRange(0, res.height);
+
+        // Same samples two bytes apart, as in a semi-planar or YUYV layout
+        cv::Mat interleaved(res.height, res.width, CV_8UC2, cv::Scalar::all(128));
+        int fromTo[] = {0, 0};
+        cv::mixChannels(&luma, 1, &interleaved, 1, fromTo, 1);
+
+        cv::Mat reference, packedEdges, strideEdges;
+        EdgeParams params;
+        CannyWorkspace workspace;
+        referenceLumaEdges(luma, reference, params);
+
+        printRow(res, "luma", benchLoop(options, [&] {
+            processLumaPlane(luma.data, res.width, res.height, static_cast<int>(luma.step), 1,
+                             packedEdges, params, &workspace);
+        }));
+        printRow(res, "luma-ps2", benchLoop(options, [&] {
+            processLumaPlane(interleaved.data, res.width, res.height, static_cast<int>(interleaved.step), 2,
+                             strideEdges, params, &workspace);
+        }));
+
+        if (!matchesReference(res, "luma", reference, packedEdges)) {
+            mismatched++;
+        }
+        if (!matchesReference(res, "luma-ps2", reference, strideEdges)) {
+            mismatched++;
+        }
+    }
+    return mismatched;
+}
+
+// Replays every frame of a recorded NV21/I420 file through the luma path
+int benchRecordedYuv(const BenchOptions& options) {
+    std::ifstream file(options.yuvFile, std::ios::binary);
+    std::vector<uchar> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const size_t frameBytes = static_cast<size_t>(options.yuvWidth) * options.yuvHeight * 3 / 2;
+    const size_t frameCount = data.size() / frameBytes;
+    if (frameCount == 0) {
+        std::fprintf(stderr, "%s: no complete %dx%d frames\n",
+                     options.yuvFile.c_str(), options.yuvWidth, options.yuvHeight);
+        return 1;
+    }
+
+    Resolution res = {"file", options.yuvWidth, options.yuvHeight};
+    std::printf("\nrecorded YUV: %s, %zu frames\n", options.yuvFile.c_str(), frameCount);
+    printHeader();
+
+    int mismatched = 0;
+    EdgeParams params;
+    CannyWorkspace workspace;
+    cv::Mat edges, reference;
+    size_t index = 0;
+    printRow(res, "luma", benchLoop(options, [&] {
+        const uchar* y = data.data() + (index++ % frameCount) * frameBytes;
+        processLumaPlane(y, res.width, res.height, res.width, 1, edges, params, &workspace);
+    }));
+
+    for (size_t i = 0; i < frameCount; i++) {
+        cv::Mat luma(res.height, res.width, CV_8UC1, data.data() + i * frameBytes);
+        processLumaPlane(luma.data, res.width, res.height, res.width, 1, edges, params, &workspace);
+        referenceLumaEdges(luma, reference, params);
+        if (!matchesReference(res, "recorded luma", reference, edges)) {
+            mismatched++;
+        }
+    }
+    return mismatched;
+}
+
+// What the renderer's vertex shader shows at top-down pixel (x, y) of the
+// upright image: rotate the sample point counterclockwise, mirror, then map
+// into the stored rows
+uchar displayedPixel(const cv::Mat& src, const FrameOrientation& orientation, int x, int y,
+                     int width, int height) {
+    const double kPi = 3.14159265358979323846;
+    double angle = orientation.rotation * kPi / 180.0;
+    double c = std::round(std::cos(angle));
+    double s = std::round(std::sin(angle));
+    double u = (x + 0.5) / width - 0.5;
+    double v = 0.5 - (y + 0.5) / height;
+    double a = u * c - v * s;
+    double b = u * s + v * c;
+    if (orientation.mirrored) {
+        a = -a;
+    }
+    int col = static_cast<int>(std::lround((a + 0.5) * src.cols - 0.5));
+    int rowUp = static_cast<int>(std::lround((b + 0.5) * src.rows - 0.5));
+    return src.at<uchar>(orientation.bottomUp ? rowUp : src.rows - 1 - rowUp, col);
+}
+
+// Checks orientUpright against the display shader's math for every orientation
+int checkOrientation() {
+    cv::Mat src(3, 5, CV_8UC1);
+    for (int i = 0; i < static_cast<int>(src.total()); i++) {
+        src.data[i] = static_cast<uchar>(i);
+    }
+
+    int mismatched = 0;
+    for (int rotation = 0; rotation < 360; rotation += 90) {
+        for (int flags = 0; flags < 4; flags++) {
+            FrameOrientation orientation;
+            orientation.rotation = rotation;
+            orientation.mirrored = (flags & 1) != 0;
+            orientation.bottomUp = (flags & 2) != 0;
+
+            cv::Mat upright;
+            orientUpright(src, orientation, upright);
+            bool quarter = rotation == 90 || rotation == 270;
+            bool ok = upright.rows == (quarter ? src.cols : src.rows);
+            for (int y = 0; ok && y < upright.rows; y++) {
+                for (int x = 0; ok && x < upright.cols; x++) {
+                    ok = upright.at<uchar>(y, x) == displayedPixel(src, orientation, x, y, upright.cols, upright.rows);
+                }
+            }
+            if (!ok) {
+                std::printf("orientUpright MISMATCH: rotation %d, mirrored %d, bottomUp %d\n",
+                            rotation, orientation.mirrored ? 1 : 0, orientation.bottomUp ? 1 : 0);
+                mismatched++;
+            }
+        }
+    }
+    return mismatched;
+}
+
+// Replays the render thread -> worker -> render thread hand-off for one
+// resolution, switching edge format every frame, and returns the pool
+// allocations and operator new calls per frame after warm-up
+void countFrameAllocations(const Resolution& res, const BenchOptions& options, const EdgeParams& params,
+                           double& poolPerFrame, double& heapPerFrame) {
+    FramePool pool;
+    TripleBuffer<cv::Mat> inputFrames;
+    TripleBuffer<cv::Mat> edgeFrames;
+    for (int i = 0; i < 3; i++) {
+        useFramePool(inputFrames.slots[i], pool);
+        useFramePool(edgeFrames.slots[i], pool);
+    }
+    CannyWorkspace workspace;
+    cv::Mat camera = makeSyntheticFrame(res.width, res.height);
+    const EdgeFormat formats[] = {EDGE_FORMAT_RGBA, EDGE_FORMAT_GRAY, EDGE_FORMAT_PACKED};
+
+    int frame = 0;
+    auto step = [&] {
+        camera.copyTo(inputFrames.back());
+        inputFrames.publish();
+        inputFrames.update();
+        processReadbackFrame(inputFrames.front(), edgeFrames.back(), params, &workspace, formats[frame++ % 3]);
+        edgeFrames.publish();
+        edgeFrames.update();
+    };
+
+    // Warm up until every slot has seen every format
+    for (int i = 0; i < std::max(options.warmup, 12); i++) {
+        step();
+    }
+    int poolBefore = pool.allocations();
+    long heapBefore = g_heapAllocations.load();
+    for (int i = 0; i < options.frames; i++) {
+        step();
+    }
+    poolPerFrame = static_cast<double>(pool.allocations() - poolBefore) / options.frames;
+    heapPerFrame = static_cast<double>(g_heapAllocations.load() - heapBefore) / options.frames;
+}
+
+// Fails if the single-stripe worker loop allocates after warm-up. With one
+// stripe per thread the count is reported only: cv::parallel_for_ allocates
+// a job object per call inside OpenCV, which no pool can reach.
+int checkSteadyStateAllocations(const BenchOptions& options) {
+    std::printf("\nsteady-state allocations per frame (formats cycling)\n");
+    std::printf("%-8s %-10s %10s %10s\n", "res", "stripes", "pool", "heap");
+    int failures = 0;
+    for (const Resolution& res : kResolutions) {
+        double pool = 0.0;
+        double heap = 0.0;
+        EdgeParams params;
+        params.stripes = 1;
+        countFrameAllocations(res, options, params, pool, heap);
+        bool ok = pool == 0.0 && heap == 0.0;
+        std::printf("%-8s %-10s %10.2f %10.2f%s\n", res.name, "1", pool, heap, ok ? "" : "  FAIL");
+        failures += ok ? 0 : 1;
+
+        params.stripes = 0;
+        countFrameAllocations(res, options, params, pool, heap);
+        std::printf("%-8s %-10s %10.2f %10.2f\n", res.name, "per thread", pool, heap);
+    }
+    return failures;
+}
+
+// Buffer swapping of submitted frames (nativeProcessFrameBuffer): a slot's
+// own buffer passed back at its size is taken without a copy or allocation,
+// passed at any other size it is rejected before the slot is recreated under
+// it, and a foreign buffer is copied in at its own size. A lent buffer must
+// stay allocated while the slot is recreated for frames of another size
+// (foreign buffers, arrays, or an acquire at new dimensions), be copied in
+// when it comes back, and only then return to the pool.
+int checkFrameSwap() {
+    std::printf("\nsubmitted frame buffer swap\n");
+    int failures = 0;
+    auto expect = [&failures](bool ok, const char* what) {
+        std::printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    FramePool pool;
+    LentFrames lent;
+    cv::Mat slot;
+    useFramePool(slot, pool);
+    slot.create(480, 640, CV_8UC4);
+    const cv::Scalar pattern(1, 2, 3, 4);
+    slot.setTo(pattern);
+    lendFrame(lent, slot);
+    uchar* acquired = slot.data;
+    int allocations = pool.allocations();
+
+    expect(fillFrame(slot, acquired, 480, 640, CV_8UC4) && slot.data == acquired &&
+               pool.allocations() == allocations,
+           "own buffer, same size: swapped in place");
+    expect(!fillFrame(slot, acquired, 240, 320, CV_8UC4) && slot.data == acquired && slot.rows == 480 &&
+               slot.cols == 640,
+           "own buffer, smaller size: rejected");
+    expect(!fillFrame(slot, acquired, 640, 480, CV_8UC4) && slot.data == acquired,
+           "own buffer, transposed size: rejected");
+    expect(!fillFrame(slot, acquired + slot.step, 240, 320, CV_8UC4) && slot.data == acquired,
+           "inside own buffer: rejected");
+
+    // While `acquired` is lent, any 640x480 buffer the pool hands out must be another one
+    auto stillLent = [&pool, acquired] {
+        cv::Mat probe;
+        useFramePool(probe, pool);
+        probe.create(480, 640, CV_8UC4);
+        return probe.data != acquired;
+    };
+    cv::Mat foreign(240, 320, CV_8UC4, cv::Scalar(5, 6, 7, 8));
+    expect(fillFrame(slot, foreign.data, 240, 320, CV_8UC4) && slot.rows == 240 && slot.cols == 320 &&
+               cv::norm(slot, foreign, cv::NORM_INF) == 0,
+           "foreign buffer, other size: copied");
+    expect(stillLent(), "lent buffer kept after a foreign submit resized");
+    slot.create(720, 1280, CV_8UC4);  // An array submit or acquire at new dimensions
+    expect(stillLent(), "lent buffer kept after an acquire resized");
+
+    cv::Mat handedBack(480, 640, CV_8UC4, acquired);
+    expect(cv::norm(handedBack, pattern, cv::NORM_INF) == 0 && fillFrame(slot, acquired, 480, 640, CV_8UC4) &&
+               slot.data != acquired && cv::norm(slot, pattern, cv::NORM_INF) == 0,
+           "lent buffer handed back after a resize: copied");
+    returnFrame(lent, acquired);
+    expect(lent.frames.empty() && !stillLent(), "returned buffer back in the pool");
+    return failures;
+}
+
+// True when a histogram percentile is the bucket bound just above the exact
+// one: no lower, and at most 1/8 octave higher (bucket 0 ends at 1024 ns)
+bool percentileInBucket(int64_t histogram, int64_t exact) {
+    return histogram >= exact && histogram <= std::max<int64_t>(exact + exact / 8, 1024);
+}
+
+// Per-phase kernel times
+int benchStageBreakdown(const BenchOptions& options) {
+    const Stage stages[] = {STAGE_CANNY, STAGE_CANNY_GRADIENT, STAGE_CANNY_HYSTERESIS, STAGE_CANNY_OUTPUT};
+    int failures = 0;
+
+    std::printf("\nstage breakdown (one stripe per thread)\n");
+    std::printf("%-8s %-18s %10s %10s %10s %10s\n", "res", "stage", "p50_ms", "p90_ms", "p99_ms", "max_ms");
+    for (const Resolution& res : kResolutions) {
+        std::unique_ptr<StageStats> stats(new StageStats());
+        stageStatsInit(*stats);
+        cv::Mat readback = makeSyntheticFrame(res.width, res.height);
+        cv::Mat edges;
+        EdgeParams params;
+        CannyWorkspace workspace;
+        std::vector<int64_t> totals;
+
+        for (int i = 0; i < options.warmup + options.frames; i++) {
+            int64_t start = monotonicNanos();
+            processReadbackFrame(readback, edges, params, &workspace, EDGE_FORMAT_GRAY);
+            int64_t end = monotonicNanos();
+            if (i < options.warmup) {
+                continue;
+            }
+            stageRecordKernel(*stats, STAGE_CANNY, workspace, start, end);
+            totals.push_back(end - start);
+        }
+
+        for (Stage stage : stages) {
+            StageSummary s = stageSummary(*stats, stage);
+            std::printf("%-8s %-18s %10.3f %10.3f %10.3f %10.3f\n", res.name, kStageNames[stage],
+                        s.p50Nanos / 1e6, s.p90Nanos / 1e6, s.p99Nanos / 1e6, s.maxNanos / 1e6);
+        }
+
+        std::sort(totals.begin(), totals.end());
+        auto exact = [&](double fraction) {
+            return totals[static_cast<size_t>(std::ceil(fraction * totals.size())) - 1];
+        };
+        StageSummary total = stageSummary(*stats, STAGE_CANNY);
+        bool ok = total.count == options.frames && total.maxNanos == totals.back() &&
+                  percentileInBucket(total.p50Nanos, exact(0.50)) &&
+                  percentileInBucket(total.p90Nanos, exact(0.90)) &&
+                  percentileInBucket(total.p99Nanos, exact(0.99));
+        if (!ok) {
+            std::printf("%-8s canny histogram disagrees with exact percentiles  FAIL\n", res.name);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Worker frame time with tracing off and on. Reported only: the difference
+// is within run-to-run noise on a busy machine.
+void benchTraceOverhead(const BenchOptions& options) {
+    std::printf("\ntracing overhead (worker loop, one stripe per thread)\n");
+    std::printf("%-8s %12s %12s %10s\n", "res", "off_ms", "on_ms", "overhead");
+    for (const Resolution& res : kResolutions) {
+        std::unique_ptr<StageStats> stats(new StageStats());
+        stageStatsInit(*stats);
+        cv::Mat readback = makeSyntheticFrame(res.width, res.height);
+        cv::Mat edges;
+        EdgeParams params;
+        CannyWorkspace workspace;
+        auto frame = [&] {
+            int64_t start = monotonicNanos();
+            processReadbackFrame(readback, edges, params, &workspace, EDGE_FORMAT_GRAY);
+            stageRecordKernel(*stats, STAGE_CANNY, workspace, start, monotonicNanos());
+        };
+
+        traceDisable();
+        Timing off = benchLoop(options, frame);
+        traceEnable();
+        Timing on = benchLoop(options, frame);
+        traceDisable();
+        std::printf("%-8s %12.3f %12.3f %9.2f%%\n", res.name, off.medianMs, on.medianMs,
+                    off.medianMs > 0.0 ? (on.medianMs / off.medianMs - 1.0) * 100.0 : 0.0);
+    }
+}
+
+// Still images processed between caller-owned buffers, as NativeBridge does
+// for gallery images: output must match the reference and, single stripe,
+// no frame after the first may allocate
+int checkStillImage(const BenchOptions& options) {
+    std::printf("\nstill image (caller-owned buffers, 1 stripe)\n");
+    printHeader();
+    int failures = 0;
+    for (const Resolution& res : kResolutions) {
+        // Padded input rows, as a Bitmap's may be
+        cv::Mat padded = makeSyntheticFrame(res.width + 16, res.height);
+        cv::Mat input = padded.colRange(0, res.width);
+        std::vector<uchar> output(static_cast<size_t>(res.width) * res.height * 4);
+        EdgeParams params;
+        params.stripes = 1;
+        CannyWorkspace workspace;
+        auto step = [&] {
+            processStillImage(input.data, res.width, res.height, static_cast<int>(input.step),
+                              output.data(), res.width * 4, params, &workspace);
+        };
+
+        printRow(res, "still", benchLoop(options, step));
+        long heapBefore = g_heapAllocations.load();
+        for (int i = 0; i < options.frames; i++) {
+            step();
+        }
+        long heap = g_heapAllocations.load() - heapBefore;
+
+        cv::Mat reference = processFrameWithCanny(input, params);
+        cv::Mat edges(res.height, res.width, CV_8UC4, output.data());
+        if (!matchesReference(res, "still", reference, edges)) {
+            failures++;
+        }
+        if (heap != 0) {
+            std::fprintf(stderr, "%s: still image path allocated %ld times\n", res.name, heap);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Precision, recall and F1 of `edges` against `truth`, both 0/255 CV_8UC1 of
+// the same size, counting an edge pixel as found within `tolerance` pixels
+struct EdgeScore {
+    double precision;
+    double recall;
+    double f1;
+};
+
+EdgeScore scoreEdges(const cv::Mat& edges, const cv::Mat& truth, int tolerance) {
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * tolerance + 1, 2 * tolerance + 1));
+    cv::Mat nearTruth, nearEdges;
+    cv::dilate(truth, nearTruth, kernel);
+    cv::dilate(edges, nearEdges, kernel);
+    int found = cv::countNonZero(edges);
+    int expected = cv::countNonZero(truth);
+    EdgeScore score;
+    score.precision = found > 0 ? static_cast<double>(cv::countNonZero(edges & nearTruth)) / found : 0.0;
+    score.recall = expected > 0 ? static_cast<double>(cv::countNonZero(truth & nearEdges)) / expected : 0.0;
+    double sum = score.precision + score.recall;
+    score.f1 = sum > 0.0 ? 2.0 * score.precision * score.recall / sum : 0.0;
+    return score;
+}
+
+// Canny at 1/2 and 1/4 scale against full resolution. The small edge maps
+// are magnified with nearest sampling, as the display quad does, and an edge
+// counts as found within one source pixel of the small map.
+int benchProcessingScale(const BenchOptions& options) {
+    std::printf("\nprocessing scale (edges magnified back, F1 vs full resolution within 1 scaled pixel)\n");
+    std::printf("%-8s %6s %10s %10s %8s %10s %8s %8s %9s\n", "res", "scale", "median_ms", "p99_ms", "speedup",
+                "precision", "recall", "F1", "resize_d");
+    int failures = 0;
+    for (const Resolution& res : kResolutions) {
+        cv::Mat rgba = makeSyntheticFrame(res.width, res.height);
+        FrameView frame;
+        frame.data = rgba.data;
+        frame.width = res.width;
+        frame.height = res.height;
+        frame.rowStride = static_cast<int>(rgba.step);
+        frame.pixelStride = 4;
+        cv::Mat luma;
+        cv::cvtColor(rgba, luma, cv::COLOR_RGBA2GRAY);
+
+        cv::Mat fullEdges;
+        double fullMs = 0.0;
+        for (int scale : {1, 2, 4}) {
+            EdgeParams params;
+            params.downscale = scale;
+            CannyWorkspace workspace;
+            cv::Mat edges;
+            FrameOrientation orientation;
+            Timing t = benchLoop(options, [&] {
+                processFrameView(frame, edges, orientation, params, &workspace, EDGE_FORMAT_GRAY);
+            });
+            if (scale == 1) {
+                fullMs = t.medianMs;
+                fullEdges = edges.clone();
+                std::printf("%-8s %6s %10.3f %10.3f %7.2fx\n", res.name, "1", t.medianMs, t.p99Ms, 1.0);
+                continue;
+            }
+
+            // Blocks that didn't fit are dropped from the bottom and right
+            cv::Rect covered(0, 0, edges.cols * scale, edges.rows * scale);
+            cv::Mat magnified;
+            cv::resize(edges, magnified, covered.size(), 0, 0, cv::INTER_NEAREST);
+            EdgeScore score = scoreEdges(magnified, fullEdges(covered), scale);
+
+            // The kernel's area average against OpenCV's
+            cv::Mat reference, small, diff;
+            cv::resize(luma(covered), reference, edges.size(), 0, 0, cv::INTER_AREA);
+            downscaleLuma(rgba.data, 4, res.width, res.height, rgba.step, 4, scale, small, params, &workspace);
+            cv::absdiff(reference, small, diff);
+            double maxDiff = 0.0;
+            cv::minMaxLoc(diff, nullptr, &maxDiff);
+
+            char label[8];
+            std::snprintf(label, sizeof(label), "1/%d", scale);
+            std::printf("%-8s %6s %10.3f %10.3f %7.2fx %10.3f %8.3f %8.3f %9.0f\n", res.name, label, t.medianMs,
+                        t.p99Ms, t.medianMs > 0.0 ? fullMs / t.medianMs : 0.0, score.precision, score.recall,
+                        score.f1, maxDiff);
+            if (maxDiff > 1.0) {
+                std::fprintf(stderr, "%s: 1/%d area downscale differs from cv::resize by %.0f\n", res.name, scale,
+                             maxDiff);
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+// Motion gating at 30 fps: a static scene with fresh sensor noise every frame
+// may only be processed at the refresh interval, a moving square must be
+// processed every frame, and a check must cost far less than the kernel
+int checkMotionGate(const BenchOptions& options) {
+    const int frames = 90;
+    const int64_t frameNanos = 1000000000 / 30;
+    MotionGateConfig config;
+    config.blockThreshold = 4;
+    // The first frame, then one per refresh interval
+    const int maxStaticProcessed = 1 + static_cast<int>(frames * frameNanos / config.refreshNanos);
+
+    std::printf("\nmotion gate (threshold %d, refresh %.1f s, %d frames at 30 fps)\n", config.blockThreshold,
+                config.refreshNanos / 1e9, frames);
+    std::printf("%-8s %10s %10s %10s %10s\n", "res", "static", "moving", "check_ms", "canny_ms");
+    int failures = 0;
+    for (const Resolution& res : kResolutions) {
+        cv::Mat scene = makeSyntheticFrame(res.width, res.height);
+        std::vector<cv::Mat> noisy(4);
+        for (cv::Mat& frame : noisy) {
+            cv::Mat noise(scene.size(), CV_16SC4);
+            cv::randn(noise, 0, 3);
+            cv::add(scene, noise, frame, cv::noArray(), CV_8UC4);
+        }
+
+        MotionGate gate;
+        motionGateInit(gate, config);
+        int staticProcessed = 0;
+        for (int i = 0; i < frames; i++) {
+            const cv::Mat& frame = noisy[i % noisy.size()];
+            staticProcessed += motionGateCheck(gate, frame.data, 4, res.width, res.height, static_cast<int>(frame.step),
+                                               4, i * frameNanos) ? 1 : 0;
+        }
+
+        int movingProcessed = 0;
+        cv::Mat moving;
+        for (int i = 0; i < frames; i++) {
+            // White over dark background, black over light, so it stands out anywhere
+            noisy[i % noisy.size()].copyTo(moving);
+            cv::Rect square(64 + i * 4, res.height / 2, 64, 64);
+            cv::Scalar background = cv::mean(moving(square));
+            bool dark = background[0] + background[1] + background[2] < 3 * 128;
+            moving(square).setTo(dark ? cv::Scalar::all(255) : cv::Scalar(0, 0, 0, 255));
+            movingProcessed += motionGateCheck(gate, moving.data, 4, res.width, res.height,
+                                               static_cast<int>(moving.step), 4, (frames + i) * frameNanos) ? 1 : 0;
+        }
+
+        Timing check = benchLoop(options, [&] {
+            motionGateCheck(gate, scene.data, 4, res.width, res.height, static_cast<int>(scene.step), 4, 0);
+        });
+        cv::Mat edges;
+        FrameOrientation orientation;
+        FrameView view;
+        view.data = scene.data;
+        view.width = res.width;
+        view.height = res.height;
+        view.rowStride = static_cast<int>(scene.step);
+        view.pixelStride = 4;
+        CannyWorkspace workspace;
+        Timing canny = benchLoop(options, [&] {
+            processFrameView(view, edges, orientation, EdgeParams(), &workspace);
+        });
+
+        bool ok = staticProcessed <= maxStaticProcessed && movingProcessed == frames &&
+                  check.medianMs < canny.medianMs / 4;
+        std::printf("%-8s %7d/%-2d %7d/%-2d %10.3f %10.3f%s\n", res.name, staticProcessed, frames, movingProcessed,
+                    frames, check.medianMs, canny.medianMs, ok ? "" : "  FAIL");
+        failures += ok ? 0 : 1;
+    }
+    return failures;
+}
+
+// Thumbnail batches on the image pool, images/sec by pool size
+int benchImageBatch(const BenchOptions& options) {
+    const Resolution thumbnails[] = {{"256x256", 256, 256}, {"640x480", 640, 480}};
+    const int batchSize = 64;
+    const int rounds = std::max(1, options.frames / 20);
+    int maxThreads = options.maxThreads > 0 ? options.maxThreads
+                                            : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int mismatched = 0;
+
+    std::printf("\nimage batches (%d images, pool of 1..%d threads; %d big cores)\n", batchSize, maxThreads,
+                bigCoreCount());
+    std::printf("%-8s %-10s %8s %10s %10s %8s\n", "res", "pipeline", "threads", "batch_ms", "images/s", "speedup");
+    for (const Resolution& res : thumbnails) {
+        std::vector<cv::Mat> inputs;
+        std::vector<cv::Mat> outputs;
+        std::vector<ImageJob> jobs;
+        for (int i = 0; i < batchSize; i++) {
+            inputs.push_back(makeSyntheticFrame(res.width, res.height, 0x5eed + i));
+            outputs.emplace_back(res.height, res.width, CV_8UC4);
+            ImageJob job;
+            job.input = inputs.back().data;
+            job.width = res.width;
+            job.height = res.height;
+            job.inputStride = static_cast<int>(inputs.back().step);
+            job.output = outputs.back().data;
+            job.outputStride = static_cast<int>(outputs.back().step);
+            jobs.push_back(job);
+        }
+        auto printBatch = [&](const char* pipeline, int threads, const Timing& t, double baseMs) {
+            std::printf("%-8s %-10s %8d %10.3f %10.1f %7.2fx\n", res.name, pipeline, threads, t.medianMs,
+                        t.medianMs > 0.0 ? batchSize * 1000.0 / t.medianMs : 0.0,
+                        t.medianMs > 0.0 ? baseMs / t.medianMs : 0.0);
+        };
+
+        // What the pool replaces: a new thread and workspace per image
+        Timing spawn = timeFrames(rounds, 1, [&] {
+            std::vector<std::thread> threads;
+            for (const ImageJob& job : jobs) {
+                threads.emplace_back([&job] {
+                    EdgeParams params;
+                    params.stripes = 1;
+                    CannyWorkspace workspace;
+                    processStillImage(job.input, job.width, job.height, job.inputStride, job.output,
+                                      job.outputStride, params, &workspace);
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        });
+        printBatch("spawn", batchSize, spawn, spawn.medianMs);
+
+        for (int threads : threadSweep(maxThreads)) {
+            ImagePool pool(threads);
+            for (cv::Mat& output : outputs) {
+                output.setTo(cv::Scalar::all(0x55));
+            }
+            Timing t = timeFrames(rounds, 1, [&] {
+                pool.submit(jobs)->wait();
+            });
+            printBatch("pool", threads, t, spawn.medianMs);
+
+            for (int i = 0; i < batchSize; i++) {
+                cv::Mat reference(res.height, res.width, CV_8UC4);
+                processStillImage(inputs[i].data, res.width, res.height, static_cast<int>(inputs[i].step),
+                                  reference.data, static_cast<int>(reference.step));
+                if (!matchesReference(res, "pool", reference, outputs[i])) {
+                    mismatched++;
+                    break;
+                }
+            }
+        }
+    }
+    return mismatched;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::printf("OpenCV %s, %d threads, %d frames (+%d warmup)\n",
+                CV_VERSION, cv::getNumThreads(), options.frames, options.warmup);
+    if (!options.tracePath.empty()) {
+        benchTraceOverhead(options);
+        traceSetThreadName("main");
+        traceEnable();
+    }
+    int mismatched = 0;
+    mismatched += benchPipelines(options);
+    mismatched += benchStripeScaling(options);
+    mismatched += benchLumaPlane(options);
+    mismatched += checkOrientation();
+    mismatched += checkSteadyStateAllocations(options);
+    mismatched += checkFrameSwap();
+    mismatched += checkStillImage(options);
+    mismatched += benchImageBatch(options);
+    mismatched += benchProcessingScale(options);
+    mismatched += checkMotionGate(options);
+    mismatched += benchStageBreakdown(options);
+    if (!options.yuvFile.empty()) {
+        mismatched += benchRecordedYuv(options);
+    }
+    if (!options.tracePath.empty()) {
+        traceDisable();
+        if (!traceWriteChromeJson(options.tracePath.c_str())) {
+            std::fprintf(stderr, "can't write %s\n", options.tracePath.c_str());
+            return 1;
+        }
+        std::printf("\ntrace: %zu spans (%zu dropped) written to %s\n", traceEventCount(),
+                    traceDroppedCount(), options.tracePath.c_str());
+    }
+    return mismatched == 0 ? 0 : 1;
+}
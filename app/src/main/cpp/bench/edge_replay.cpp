@@ -0,0 +1,377 @@
+// Replays a frame recording through the renderer's CPU pipeline.
+//
+// Frames come from a FileFrameSource and go through processFrameView, the
+// same entry point the renderer's worker (read-back RGBA frames) and camera
+// thread (NV21/YUV luma planes) use, with the same stage histograms. A
+// problematic scene can then be reproduced on a workstation as often as
+// needed. Output is deterministic: the edge pixel count and checksum printed
+// at the end only change when the processing does.
+//
+// Usage: edge_replay FILE [--realtime] [--start N] [--loops N]
+//                         [--format rgba|gray|packed] [--stripes N] [--trace OUT]
+//                         [--budget MS] [--load THREADS] [--load-from N] [--load-to N]
+//                         [--motion THRESHOLD]
+//        edge_replay --synthesize FILE [--size WxH] [--count N] [--fps N] [--nv21]
+//
+// Without --realtime frames are processed as fast as possible; with it they
+// are paced at their recorded timestamps. --start skips straight to frame N
+// through the recording's index. --synthesize writes a recording of
+// synthetic frames to try the harness without a device.
+//
+// --budget runs the quality governor as the renderer does, with that many
+// milliseconds per frame, and prints the frames spent at each level and the
+// level changes. --load adds busy threads competing for the CPU while frames
+// [--load-from, --load-to) are processed, to stand in for a throttled device:
+//   edge_replay rec.bin --realtime --loops 20 --budget 25 --load 4 --load-from 300 --load-to 900
+//
+// --motion gates frames through the motion gate with that block threshold,
+// refreshing by the recorded timestamps, and prints how many were static.
+
+#include "edge_pipeline.h"
+#include "frame_file.h"
+#include "frame_source.h"
+#include "fused_canny.h"
+#include "motion_gate.h"
+#include "quality_governor.h"
+#include "stage_stats.h"
+#include "synthetic_frame.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct ReplayOptions {
+    std::string path;
+    bool realtime = false;
+    int startFrame = 0;
+    int loops = 1;
+    EdgeFormat format = EDGE_FORMAT_GRAY;
+    int stripes = 0;
+    std::string tracePath;
+    double budgetMs = 0.0;
+    int loadThreads = 0;
+    int loadFrom = 0;
+    int loadTo = INT_MAX;
+    int motionThreshold = 0;
+
+    bool synthesize = false;
+    int width = 1280;
+    int height = 720;
+    int count = 60;
+    int fps = 30;
+    bool nv21 = false;
+};
+
+bool parseOptions(int argc, char** argv, ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--realtime") == 0) {
+            options.realtime = true;
+        } else if (std::strcmp(argv[i], "--start") == 0 && hasValue) {
+            options.startFrame = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--loops") == 0 && hasValue) {
+            options.loops = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--format") == 0 && hasValue) {
+            const char* format = argv[++i];
+            if (std::strcmp(format, "rgba") == 0) {
+                options.format = EDGE_FORMAT_RGBA;
+            } else if (std::strcmp(format, "packed") == 0) {
+                options.format = EDGE_FORMAT_PACKED;
+            } else {
+                options.format = EDGE_FORMAT_GRAY;
+            }
+        } else if (std::strcmp(argv[i], "--stripes") == 0 && hasValue) {
+            options.stripes = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--budget") == 0 && hasValue) {
+            options.budgetMs = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--load") == 0 && hasValue) {
+            options.loadThreads = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--load-from") == 0 && hasValue) {
+            options.loadFrom = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--load-to") == 0 && hasValue) {
+            options.loadTo = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--motion") == 0 && hasValue) {
+            options.motionThreshold = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--synthesize") == 0 && hasValue) {
+            options.synthesize = true;
+            options.path = argv[++i];
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        } else if (std::strcmp(argv[i], "--count") == 0 && hasValue) {
+            options.count = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--fps") == 0 && hasValue) {
+            options.fps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--nv21") == 0) {
+            options.nv21 = true;
+        } else if (argv[i][0] != '-' && options.path.empty()) {
+            options.path = argv[i];
+        } else {
+            options.path.clear();
+            break;
+        }
+    }
+    if (options.path.empty() || options.width <= 0 || options.height <= 0) {
+        std::fprintf(stderr,
+                     "usage: %s FILE [--realtime] [--start N] [--loops N] [--format rgba|gray|packed] "
+                     "[--stripes N] [--trace OUT]\n"
+                     "       [--budget MS] [--load THREADS] [--load-from N] [--load-to N] [--motion THRESHOLD]\n"
+                     "       %s --synthesize FILE [--size WxH] [--count N] [--fps N] [--nv21]\n",
+                     argv[0], argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// Writes synthetic frames the way the app would record them: RGBA frames as
+// read back (bottom-up rows), NV21 frames as the camera delivers them
+int synthesize(const ReplayOptions& options) {
+    FrameFileWriter writer;
+    if (!frameFileCreate(writer, options.path.c_str(), options.count)) {
+        std::fprintf(stderr, "can't create %s\n", options.path.c_str());
+        return 1;
+    }
+    const int width = options.width;
+    const int height = options.height;
+    cv::Mat pixels;
+    for (int i = 0; i < options.count; i++) {
+        cv::Mat rgba = makeSyntheticFrame(width, height, 0x5eed + i);
+        FrameView frame;
+        frame.width = width;
+        frame.height = height;
+        frame.timestampNanos = static_cast<int64_t>(i) * 1000000000 / options.fps;
+        if (options.nv21) {
+            // YV12 (Y, V, U planes) to NV21 (Y, interleaved VU)
+            cv::Mat yv12;
+            cv::cvtColor(rgba, yv12, cv::COLOR_RGBA2YUV_YV12);
+            pixels.create(height + height / 2, width, CV_8UC1);
+            std::memcpy(pixels.data, yv12.data, static_cast<size_t>(width) * height);
+            const uchar* v = yv12.data + width * height;
+            const uchar* u = v + (width / 2) * (height / 2);
+            uchar* vu = pixels.data + width * height;
+            for (int j = 0; j < (width / 2) * (height / 2); j++) {
+                vu[2 * j] = v[j];
+                vu[2 * j + 1] = u[j];
+            }
+            frame.format = FRAME_PIXEL_NV21;
+            frame.rowStride = width;
+        } else {
+            cv::flip(rgba, pixels, 0);
+            frame.format = FRAME_PIXEL_RGBA;
+            frame.rowStride = static_cast<int>(pixels.step);
+            frame.orientation.bottomUp = true;
+        }
+        frame.data = pixels.data;
+        if (!frameFileAppend(writer, frame)) {
+            std::fprintf(stderr, "can't write %s\n", options.path.c_str());
+            frameFileClose(writer);
+            return 1;
+        }
+    }
+    std::printf("%s: %d %dx%d %s frames at %d fps\n", options.path.c_str(), writer.frames, width, height,
+                options.nv21 ? "NV21" : "RGBA", options.fps);
+    frameFileClose(writer);
+    return 0;
+}
+
+// Busy threads that compete for the CPU while `active` is set, like the rest
+// of a thermally throttled or busy device
+class CpuLoad {
+public:
+    explicit CpuLoad(int threads) {
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back([this] { spin(); });
+        }
+    }
+
+    ~CpuLoad() {
+        stop.store(true);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void setActive(bool on) {
+        active.store(on, std::memory_order_relaxed);
+    }
+
+private:
+    void spin() {
+        volatile uint64_t sink = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (!active.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            for (int i = 0; i < 100000; i++) {
+                sink = sink * 6364136223846793005ULL + 1442695040888963407ULL;
+            }
+        }
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> active{false};
+    std::vector<std::thread> workers;
+};
+
+void printStage(const StageStats& stats, Stage stage) {
+    StageSummary s = stageSummary(stats, stage);
+    if (s.count == 0) {
+        return;
+    }
+    std::printf("%-18s %8lld %10.3f %10.3f %10.3f %10.3f\n", kStageNames[stage], static_cast<long long>(s.count),
+                s.p50Nanos / 1e6, s.p90Nanos / 1e6, s.p99Nanos / 1e6, s.maxNanos / 1e6);
+}
+
+int replay(const ReplayOptions& options) {
+    FileFrameSource file;
+    if (!file.open(options.path, options.loops > 1)) {
+        std::fprintf(stderr, "%s: not a frame recording, or empty\n", options.path.c_str());
+        return 1;
+    }
+    PacedFrameSource paced(file);
+    FrameSource& source = options.realtime ? static_cast<FrameSource&>(paced) : file;
+    const int frames = file.frameCount() * options.loops - std::min(options.startFrame, file.frameCount());
+    file.seek(options.startFrame);
+
+    std::unique_ptr<StageStats> stats(new StageStats());
+    stageStatsInit(*stats);
+    if (!options.tracePath.empty()) {
+        traceSetThreadName("replay");
+        traceEnable();
+    }
+
+    EdgeParams baseParams;
+    baseParams.stripes = options.stripes;
+    CannyWorkspace workspace;
+
+    // Quality governor (holds the default level without --budget) and extra load
+    GovernorConfig governorConfig;
+    governorConfig.budgetNanos = static_cast<int64_t>(options.budgetMs * 1e6);
+    QualityGovernor governor;
+    governorInit(governor, governorConfig);
+    int framesAtLevel[kQualityLevelCount] = {};
+    CpuLoad load(options.loadThreads);
+    MotionGateConfig motionConfig;
+    motionConfig.blockThreshold = options.motionThreshold;
+    MotionGate motionGate;
+    motionGateInit(motionGate, motionConfig);
+    // Recorded timestamps restart with every loop; the gate needs a steady clock
+    int64_t replayNanos = 0;
+    int64_t lastTimestamp = 0;
+
+    cv::Mat edges;
+    FrameOrientation orientation;
+    uint64_t edgePixels = 0;
+    uint64_t checksum = 0;
+    FrameView frame;
+    int64_t start = monotonicNanos();
+    for (int i = 0; i < frames && source.next(frame); i++) {
+        load.setActive(i >= options.loadFrom && i < options.loadTo);
+        if (i > 0 && frame.timestampNanos > lastTimestamp) {
+            replayNanos += frame.timestampNanos - lastTimestamp;
+        }
+        lastTimestamp = frame.timestampNanos;
+        if (!governorAdmitFrame(governor)) {
+            continue;
+        }
+        if (!motionGateCheck(motionGate, frame.data, frame.format == FRAME_PIXEL_RGBA ? 4 : 1, frame.width,
+                             frame.height, frame.rowStride, frame.pixelStride, replayNanos)) {
+            continue;
+        }
+        int level = governor.level;
+        EdgeParams params = baseParams;
+        applyQualityLevel(kQualityLevels[level], params);
+
+        // Read-back frames are the worker's, camera planes the camera thread's
+        Stage stage = frame.format == FRAME_PIXEL_RGBA ? STAGE_CANNY : STAGE_LUMA_CANNY;
+        int64_t frameStart = monotonicNanos();
+        processFrameView(frame, edges, orientation, params, &workspace, options.format);
+        int64_t frameEnd = monotonicNanos();
+        stageRecordKernel(*stats, stage, workspace, frameStart, frameEnd);
+        stageRecord(*stats, STAGE_FRAME, frameStart, frameEnd);
+        governorRecord(governor, level, frameEnd - frameStart, frameEnd);
+        framesAtLevel[level]++;
+
+        const size_t pixelBytes = options.format == EDGE_FORMAT_RGBA ? 4 : 1;
+        for (int y = 0; y < edges.rows; y++) {
+            const uchar* row = edges.ptr(y);
+            size_t bytes = edges.cols * edges.elemSize();
+            for (size_t x = 0; x < bytes; x++) {
+                if (options.format == EDGE_FORMAT_PACKED) {
+                    edgePixels += __builtin_popcount(row[x]);
+                } else if (x % pixelBytes == 0) {
+                    edgePixels += row[x] != 0;
+                }
+                checksum = checksum * 31 + row[x];
+            }
+        }
+    }
+    double seconds = (monotonicNanos() - start) / 1e9;
+
+    int processed = static_cast<int>(stageSummary(*stats, STAGE_FRAME).count);
+    std::printf("%s: %d frames in %.2f s (%.1f fps, %s)\n", options.path.c_str(), processed, seconds,
+                seconds > 0.0 ? processed / seconds : 0.0, options.realtime ? "real time" : "as fast as possible");
+    std::printf("%-18s %8s %10s %10s %10s %10s\n", "stage", "count", "p50_ms", "p90_ms", "p99_ms", "max_ms");
+    const Stage stages[] = {STAGE_FRAME, STAGE_CANNY, STAGE_LUMA_CANNY, STAGE_CANNY_GRADIENT,
+                            STAGE_CANNY_HYSTERESIS, STAGE_CANNY_OUTPUT};
+    for (Stage stage : stages) {
+        printStage(*stats, stage);
+    }
+    std::printf("edge pixels %llu, checksum %016llx\n", static_cast<unsigned long long>(edgePixels),
+                static_cast<unsigned long long>(checksum));
+
+    if (options.motionThreshold > 0) {
+        std::printf("motion gate: threshold %d, %lld frames static\n", options.motionThreshold,
+                    static_cast<long long>(motionGate.framesStatic));
+    }
+    if (governorConfig.budgetNanos > 0) {
+        std::printf("governor: %.1f ms budget, %lld frames skipped, frames per level:", options.budgetMs,
+                    static_cast<long long>(governor.framesSkipped));
+        for (int level = 0; level < kQualityLevelCount; level++) {
+            std::printf(" %d", framesAtLevel[level]);
+        }
+        QualityTransition transitions[QualityGovernor::kHistorySize];
+        int count = governorHistory(governor, transitions, QualityGovernor::kHistorySize);
+        std::printf("\nlast %d of %lld level changes:\n", count, static_cast<long long>(governor.transitions));
+        for (int i = 0; i < count; i++) {
+            std::printf("  %8.3f s  %d -> %d  (%.2f ms per frame)\n", (transitions[i].timestampNanos - start) / 1e9,
+                        transitions[i].fromLevel, transitions[i].toLevel, transitions[i].costNanos / 1e6);
+        }
+    }
+
+    if (!options.tracePath.empty()) {
+        traceDisable();
+        if (!traceWriteChromeJson(options.tracePath.c_str())) {
+            std::fprintf(stderr, "can't write %s\n", options.tracePath.c_str());
+            return 1;
+        }
+        std::printf("trace: %zu spans (%zu dropped) written to %s\n", traceEventCount(), traceDroppedCount(),
+                    options.tracePath.c_str());
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    return options.synthesize ? synthesize(options) : replay(options);
+}
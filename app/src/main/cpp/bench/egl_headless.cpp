@@ -0,0 +1,65 @@
+#include "egl_headless.h"
+
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+EGLDisplay openDisplay() {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr &&
+        getPlatformDisplay != nullptr) {
+        return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+}  // namespace
+
+bool createHeadlessContext(HeadlessContext& ctx) {
+    ctx.display = openDisplay();
+    if (ctx.display == EGL_NO_DISPLAY || !eglInitialize(ctx.display, nullptr, nullptr)) {
+        std::fprintf(stderr, "EGL: no display\n");
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_SURFACE_TYPE, 0,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglBindAPI(EGL_OPENGL_ES_API);
+    if (!eglChooseConfig(ctx.display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        std::fprintf(stderr, "EGL: no OpenGL ES 3 config\n");
+        destroyHeadlessContext(ctx);
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+    ctx.context = eglCreateContext(ctx.display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (ctx.context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx.context)) {
+        std::fprintf(stderr, "EGL: cannot make a surfaceless context current (0x%x)\n", eglGetError());
+        destroyHeadlessContext(ctx);
+        return false;
+    }
+    return true;
+}
+
+void destroyHeadlessContext(HeadlessContext& ctx) {
+    if (ctx.display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(ctx.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (ctx.context != EGL_NO_CONTEXT) {
+        eglDestroyContext(ctx.display, ctx.context);
+    }
+    eglTerminate(ctx.display);
+    ctx = HeadlessContext();
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+// Headless OpenGL ES 3 context for host tools. Uses the Mesa surfaceless
+// platform when available (llvmpipe in CI), so no window system is needed.
+struct HeadlessContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+};
+
+// Creates the context and makes it current with no surface bound
+bool createHeadlessContext(HeadlessContext& ctx);
+
+void destroyHeadlessContext(HeadlessContext& ctx);
@@ -0,0 +1,235 @@
+// Stress test for FrameRing, the lock-free frame handoff between the threads
+// that submit frames and the renderer's worker (and the recorder's writer).
+//
+// A producer and a consumer thread each run on a deadline clock, one frame
+// per period, so that they run at known mismatched rates: producer faster,
+// consumer faster, and both about the same. A side that oversleeps catches
+// up on later deadlines, so its average rate holds on a loaded or single-core
+// machine. A last run has both sides flat out to maximize the races. Every
+// frame carries its sequence number in every pixel, so the consumer catches
+// frames torn by a slot being written while it is read, frames out of order,
+// and (bounded) frames lost without being counted. After the producer
+// finishes and the consumer has drained the ring, the counters have to add
+// up:
+//
+//   published + dropped = frames submitted
+//   published = consumed + overwritten
+//
+// and a bounded ring must skip exactly the dropped frames. The paced runs
+// must also show their rates: the share of submitted frames consumed has to
+// fall in the range the two periods allow, which for a consumer that keeps
+// up means almost every frame. Exits non-zero if any check fails.
+//
+// Usage: frame_ring_stress [--frames N]
+
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct StressOptions {
+    int frames = 4000;
+};
+
+// Small enough to keep the test fast, large enough that a torn copy shows
+constexpr int kFramePixels = 256;
+
+struct StressFrame {
+    uint64_t sequence = 0;
+    std::vector<uint32_t> pixels;
+};
+
+struct Rates {
+    const char* name;
+    int producerPeriodMicros;  // One frame per period; 0 = flat out
+    int consumerPeriodMicros;
+    // Range of frames consumed / frames submitted, at either policy. Frames
+    // not consumed are overwritten (latest-wins) or dropped (bounded).
+    double minConsumed;
+    double maxConsumed;
+};
+
+const Rates kRates[] = {
+    {"producer faster", 100, 400, 0.1, 0.5},   // About 1 in 4
+    {"consumer faster", 400, 100, 0.98, 1.0},  // All but a hiccup's worth
+    {"matched", 200, 200, 0.6, 1.0},           // Most; phase jitter loses some
+    {"flat out", 0, 0, 0.0, 1.0},              // Races only, no rate
+};
+
+// Deadline clock: waits for the start of the next period. After an
+// oversleep the following deadlines are already due, so the average rate
+// stays one frame per period.
+class Pacer {
+public:
+    Pacer(std::chrono::steady_clock::time_point start, int periodMicros)
+        : next(start), period(periodMicros) {}
+
+    void wait() {
+        if (period.count() == 0) {
+            return;
+        }
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+
+private:
+    std::chrono::steady_clock::time_point next;
+    std::chrono::microseconds period;
+};
+
+// Helper function to check one consumed frame. Returns false if it is torn
+// or not newer than the last one.
+static bool checkFrame(const StressFrame& frame, int64_t& lastSequence) {
+    uint32_t expected = static_cast<uint32_t>(frame.sequence);
+    for (uint32_t pixel : frame.pixels) {
+        if (pixel != expected) {
+            std::fprintf(stderr, "  frame %llu torn: pixel %u\n",
+                         static_cast<unsigned long long>(frame.sequence), pixel);
+            return false;
+        }
+    }
+    if (static_cast<int64_t>(frame.sequence) <= lastSequence) {
+        std::fprintf(stderr, "  frame %llu after frame %lld\n",
+                     static_cast<unsigned long long>(frame.sequence), static_cast<long long>(lastSequence));
+        return false;
+    }
+    lastSequence = static_cast<int64_t>(frame.sequence);
+    return true;
+}
+
+// Runs one producer/consumer pair over a fresh ring. Returns the number of
+// failed checks.
+static int stressRing(FrameRingPolicy policy, const Rates& rates, const StressOptions& options) {
+    FrameRing<StressFrame> ring(policy, 4);
+    for (int i = 0; i < ring.slotCount(); i++) {
+        ring.slot(i).pixels.assign(kFramePixels, 0);
+    }
+
+    std::atomic<bool> producerDone{false};
+    std::atomic<int> badFrames{0};
+    uint64_t consumedFrames = 0;
+    uint64_t skippedFrames = 0;  // Sequence numbers the consumer never saw
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        Pacer pacer(start, rates.consumerPeriodMicros);
+        int64_t lastSequence = -1;
+        while (true) {
+            // Read the flag first: once it is set, one more empty read means drained
+            bool done = producerDone.load(std::memory_order_acquire);
+            StressFrame* frame = ring.beginRead();
+            if (frame == nullptr) {
+                if (done) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            int64_t previous = lastSequence;
+            if (!checkFrame(*frame, lastSequence)) {
+                badFrames.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                skippedFrames += static_cast<uint64_t>(lastSequence - previous - 1);
+            }
+            consumedFrames++;
+            ring.endRead();
+            pacer.wait();
+        }
+        skippedFrames += static_cast<uint64_t>(options.frames - 1 - lastSequence);
+    });
+
+    Pacer pacer(start, rates.producerPeriodMicros);
+    for (int i = 0; i < options.frames; i++) {
+        pacer.wait();
+        StressFrame* frame = ring.beginWrite();
+        if (frame == nullptr) {
+            continue;  // Bounded and full; counted by the ring
+        }
+        frame->sequence = static_cast<uint64_t>(i);
+        std::fill(frame->pixels.begin(), frame->pixels.end(), static_cast<uint32_t>(i));
+        ring.endWrite();
+    }
+    producerDone.store(true, std::memory_order_release);
+    consumer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    FrameRingCounters counters = ring.counters();
+    double consumedShare = static_cast<double>(counters.consumed) / options.frames;
+    const char* policyName = policy == FRAME_RING_LATEST_WINS ? "latest-wins" : "bounded";
+    std::printf("%-12s %-16s %10llu %10llu %12llu %10llu %9.1f %9.3f\n", policyName, rates.name,
+                static_cast<unsigned long long>(counters.published),
+                static_cast<unsigned long long>(counters.consumed),
+                static_cast<unsigned long long>(counters.overwritten),
+                static_cast<unsigned long long>(counters.dropped),
+                options.frames / seconds / 1e3, consumedShare);
+
+    int failures = badFrames.load();
+    auto expect = [&failures](bool ok, const char* what) {
+        if (!ok) {
+            std::fprintf(stderr, "  FAIL: %s\n", what);
+            failures++;
+        }
+    };
+    expect(counters.published + counters.dropped == static_cast<uint64_t>(options.frames),
+           "published + dropped != frames submitted");
+    expect(counters.published == counters.consumed + counters.overwritten,
+           "published != consumed + overwritten");
+    expect(counters.consumed == consumedFrames, "consumed counter != frames the consumer got");
+    if (policy == FRAME_RING_LATEST_WINS) {
+        expect(counters.dropped == 0, "latest-wins dropped frames");
+        expect(skippedFrames == counters.overwritten, "skipped frames != overwritten");
+    } else {
+        expect(counters.overwritten == 0, "bounded overwrote frames");
+        expect(skippedFrames == counters.dropped, "skipped frames != dropped");
+    }
+    expect(consumedShare >= rates.minConsumed && consumedShare <= rates.maxConsumed,
+           "consumed share outside the range the rates allow");
+    return failures;
+}
+
+// Helper function to parse the command line
+static bool parseOptions(int argc, char** argv, StressOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.frames <= 0) {
+        std::fprintf(stderr, "--frames must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    StressOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::printf("%d frames per run, %d pixels each\n", options.frames, kFramePixels);
+    std::printf("%-12s %-16s %10s %10s %12s %10s %9s %9s\n", "policy", "rates", "published", "consumed",
+                "overwritten", "dropped", "kframes/s", "consumed");
+    int failures = 0;
+    for (FrameRingPolicy policy : {FRAME_RING_LATEST_WINS, FRAME_RING_BOUNDED}) {
+        for (const Rates& rates : kRates) {
+            failures += stressRing(policy, rates, options);
+        }
+    }
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
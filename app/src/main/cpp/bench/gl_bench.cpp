@@ -0,0 +1,776 @@
+// Headless GL benchmark for the renderer's readback paths and GPU Canny.
+//
+// Renders frames into an FBO on a surfaceless EGL context (Mesa llvmpipe on
+// CI machines) and reads them back either synchronously with glReadPixels or
+// through the PBO ring. Every frame carries its index in its clear color, so
+// the frames handed back by the ring are checked for content and age.
+//
+// Output uploads are timed both the old way (glTexImage2D storage every
+// frame) and through the double-buffered StreamTexture, which must reach an
+// allocation-free steady state.
+//
+// Edge maps are uploaded as RGBA, single channel and 1 bit per pixel, each
+// drawn through the edge display program and read back to check that all
+// three layouts put the same edges on screen.
+//
+// Render passes (gl/render_pass.h) must orient frames exactly like the
+// renderer's old per-vertex trig shader for every rotation, mirroring and
+// row order; the CPU cost of a draw is timed both ways.
+//
+// The GPU Canny passes are timed per resolution. When built with OpenCV
+// (HAVE_EDGE_CORE) their output is also compared with the CPU pipeline on the
+// same stored rows: fusedCanny without blur, cv::Canny after the GPU's 3x3
+// Gaussian with it. With hysteresis run to convergence the two must agree on
+// every pixel, and the disagreement at the default pass count is reported.
+//
+// Usage: gl_bench [--frames N] [--warmup N]
+
+#include "bench_util.h"
+#include "edge_program.h"
+#include "egl_headless.h"
+#include "gl_program.h"
+#include "gpu_canny.h"
+#include "readback_ring.h"
+#include "render_pass.h"
+#include "stream_texture.h"
+
+#ifdef HAVE_EDGE_CORE
+#include "edge_pipeline.h"
+#include "fused_canny.h"
+
+#include <opencv2/imgproc.hpp>
+#endif
+
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    int frames = 200;
+    int warmup = 20;
+};
+
+struct RenderTarget {
+    GLuint fbo;
+    GLuint texture;
+    int width;
+    int height;
+};
+
+bool createTarget(RenderTarget& target, int width, int height) {
+    target.width = width;
+    target.height = height;
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void destroyTarget(RenderTarget& target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.texture);
+}
+
+// Frame index encoded in the red/green channels of the background
+void frameColor(int64_t frameId, unsigned char rgba[4]) {
+    rgba[0] = static_cast<unsigned char>(frameId & 0xFF);
+    rgba[1] = static_cast<unsigned char>((frameId >> 8) & 0xFF);
+    rgba[2] = 0x5A;
+    rgba[3] = 0xFF;
+}
+
+// Stand-in for the camera pass: background plus a few moving rectangles
+void renderFrame(const RenderTarget& target, int64_t frameId) {
+    unsigned char color[4];
+    frameColor(frameId, color);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, target.width, target.height);
+    glClearColor(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = 0; i < 8; i++) {
+        int x = 16 + static_cast<int>((frameId * 7 + i * 131) % (target.width / 2));
+        int y = 16 + static_cast<int>((frameId * 5 + i * 97) % (target.height / 2));
+        glScissor(x, y, target.width / 4, target.height / 4);
+        glClearColor((i * 37 % 255) / 255.0f, (i * 71 % 255) / 255.0f, 0.25f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+bool frameMatches(const unsigned char* pixels, int64_t frameId) {
+    unsigned char expected[4];
+    frameColor(frameId, expected);
+    return std::memcmp(pixels, expected, 4) == 0;
+}
+
+void printHeader() {
+    std::printf("%-8s %-8s %10s %10s %10s %10s %10s\n",
+                "res", "readback", "median_ms", "p99_ms", "mean_ms", "latency", "delivered");
+}
+
+void printRow(const Resolution& res, const char* mode, const Timing& t,
+              double latencyFrames, int delivered, int frames) {
+    std::printf("%-8s %-8s %10.3f %10.3f %10.3f %10.2f %5d/%-5d\n",
+                res.name, mode, t.medianMs, t.p99Ms, t.meanMs, latencyFrames, delivered, frames);
+}
+
+// Returns the number of frames whose content did not match their index
+int benchSync(const Resolution& res, const RenderTarget& target, const BenchOptions& options) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(res.width) * res.height * 4);
+    int64_t frameId = 0;
+    int bad = 0;
+    Timing t = timeFrames(options.frames, options.warmup, [&] {
+        renderFrame(target, frameId);
+        glReadPixels(0, 0, res.width, res.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        if (!frameMatches(pixels.data(), frameId)) {
+            bad++;
+        }
+        frameId++;
+    });
+    int total = options.frames + options.warmup;
+    printRow(res, "sync", t, 0.0, total - bad, total);
+    return bad;
+}
+
+int benchRing(const Resolution& res, const RenderTarget& target, const BenchOptions& options, int depth) {
+    ReadbackRing ring;
+    if (!readbackRingInit(ring, res.width, res.height, depth)) {
+        std::fprintf(stderr, "%s: PBO ring unavailable\n", res.name);
+        return 1;
+    }
+
+    int64_t frameId = 0;
+    int bad = 0;
+    int delivered = 0;
+    int64_t latencySum = 0;
+    Timing t = timeFrames(options.frames, options.warmup, [&] {
+        renderFrame(target, frameId);
+        readbackRingQueue(ring, frameId);
+        int64_t readId = -1;
+        const unsigned char* pixels = readbackRingAcquire(ring, frameId, &readId);
+        if (pixels != nullptr) {
+            if (!frameMatches(pixels, readId)) {
+                bad++;
+            }
+            delivered++;
+            latencySum += ring.latencyFrames;
+            readbackRingRelease(ring);
+        }
+        glFlush();  // Stands in for eglSwapBuffers
+        frameId++;
+    });
+    readbackRingDestroy(ring);
+
+    char mode[16];
+    std::snprintf(mode, sizeof(mode), "pbo x%d", depth);
+    printRow(res, mode, t, delivered > 0 ? static_cast<double>(latencySum) / delivered : 0.0,
+             delivered, options.frames + options.warmup);
+    return delivered == 0 ? bad + 1 : bad;
+}
+
+// Deterministic RGBA scene (gradient, rectangles, noise) without OpenCV
+std::vector<unsigned char> makeSceneRgba(int width, int height) {
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char* px = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            px[0] = static_cast<unsigned char>(x * 255 / width);
+            px[1] = static_cast<unsigned char>(y * 255 / height);
+            px[2] = static_cast<unsigned char>((x + y) & 0xFF);
+            px[3] = 255;
+        }
+    }
+
+    uint32_t seed = 0x5eed;
+    auto next = [&seed](int range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % static_cast<uint32_t>(range));
+    };
+    int shapes = std::max(4, (width * height) / 20000);
+    for (int i = 0; i < shapes; i++) {
+        int x0 = next(width);
+        int y0 = next(height);
+        int x1 = std::min(width, x0 + 8 + next(std::max(1, width / 8)));
+        int y1 = std::min(height, y0 + 8 + next(std::max(1, height / 8)));
+        unsigned char color[3] = {static_cast<unsigned char>(next(256)),
+                                  static_cast<unsigned char>(next(256)),
+                                  static_cast<unsigned char>(next(256))};
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                std::memcpy(&rgba[(static_cast<size_t>(y) * width + x) * 4], color, 3);
+            }
+        }
+    }
+    for (size_t i = 0; i < rgba.size(); i++) {
+        if ((i & 3) != 3) {
+            rgba[i] = static_cast<unsigned char>(std::min(255, std::max(0, rgba[i] + next(13) - 6)));
+        }
+    }
+    return rgba;
+}
+
+GLuint uploadRgbaTexture(const std::vector<unsigned char>& rgba, int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return texture;
+}
+
+void printUploadHeader() {
+    std::printf("\n%-8s %-12s %10s %10s %10s %12s\n", "res", "upload", "median_ms", "p99_ms", "mean_ms", "allocations");
+}
+
+// Returns 1 if the streamed texture does not hold the last frame or kept allocating
+int benchUpload(const Resolution& res, const BenchOptions& options) {
+    std::vector<unsigned char> frame = makeSceneRgba(res.width, res.height);
+    int total = options.frames + options.warmup;
+
+    // Previous renderer behaviour: fresh storage, then a full re-specification
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    Timing t = timeFrames(options.frames, options.warmup, [&] {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.width, res.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, res.width, res.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame.data());
+        glFinish();
+    });
+    glDeleteTextures(1, &texture);
+    std::printf("%-8s %-12s %10.3f %10.3f %10.3f %12d\n", res.name, "teximage", t.medianMs, t.p99Ms, t.meanMs, 2 * total);
+
+    StreamTexture stream;
+    streamTextureInit(stream);
+    int64_t frameId = 0;
+    t = timeFrames(options.frames, options.warmup, [&] {
+        frame[0] = static_cast<unsigned char>(frameId++);
+        streamTextureUpload(stream, res.width, res.height, GL_RGBA, frame.data(), 4);
+        glFinish();
+    });
+
+    RenderTarget target = {0, streamTextureCurrent(stream), res.width, res.height};
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    unsigned char first[4];
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, first);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &target.fbo);
+
+    bool ok = std::memcmp(first, frame.data(), 4) == 0 && stream.allocations == 2;
+    std::printf("%-8s %-12s %10.3f %10.3f %10.3f %12d%s\n", res.name, "subimage x2", t.medianMs, t.p99Ms,
+                t.meanMs, stream.allocations, ok ? "" : "  MISMATCH");
+    streamTextureDestroy(stream);
+    return ok ? 0 : 1;
+}
+
+// Edge map layouts as the renderer uploads them (mirrors EdgeFormat)
+enum UploadLayout { kLayoutRgba, kLayoutGray, kLayoutPacked, kLayoutCount };
+const char* const kLayoutNames[kLayoutCount] = {"rgba", "gray", "packed"};
+
+// Packs a 0/255 edge map 8 pixels per byte, leftmost pixel in bit 0
+std::vector<unsigned char> packEdges(const std::vector<unsigned char>& edges, int width, int height) {
+    int cols = (width + 7) / 8;
+    std::vector<unsigned char> packed(static_cast<size_t>(cols) * height, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (edges[static_cast<size_t>(y) * width + x] != 0) {
+                packed[static_cast<size_t>(y) * cols + x / 8] |= static_cast<unsigned char>(1 << (x % 8));
+            }
+        }
+    }
+    return packed;
+}
+
+const char* kEdgeVertexSource = R"(
+attribute vec2 aPosition;
+varying vec2 vTexCoord;
+void main() {
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+    vTexCoord = aPosition * 0.5 + 0.5;
+}
+)";
+
+// Draws `texture` through the edge program into `target` and returns the
+// number of pixels that are not exactly `color` on edges and black elsewhere
+int checkEdgeDisplay(const EdgeProgram& edge, GLuint texture, bool packed, const RenderTarget& target,
+                     const std::vector<unsigned char>& edges) {
+    const float color[4] = {0.0f, 1.0f, 1.0f, 1.0f};
+    const float quad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, target.width, target.height);
+    edgeProgramUse(edge, texture, packed, target.width, color);
+    GLint positionLoc = glGetAttribLocation(edge.program, "aPosition");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableVertexAttribArray(positionLoc);
+    glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, quad);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(positionLoc);
+
+    std::vector<unsigned char> rgba(edges.size() * 4);
+    glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    int bad = 0;
+    for (size_t i = 0; i < edges.size(); i++) {
+        unsigned char on = edges[i] != 0 ? 255 : 0;
+        const unsigned char* px = &rgba[i * 4];
+        bad += px[0] != 0 || px[1] != on || px[2] != on || px[3] != 255;
+    }
+    return bad;
+}
+
+// Edge maps for the format benchmark. With the CPU pipeline these are real
+// Canny results, and the kernel's own packed output must match packEdges.
+int makeEdgeMaps(int width, int height, std::vector<unsigned char>& edges, std::vector<unsigned char>& packed) {
+    std::vector<unsigned char> scene = makeSceneRgba(width, height);
+#ifdef HAVE_EDGE_CORE
+    cv::Mat frame(height, width, CV_8UC4, scene.data());
+    cv::Mat gray;
+    cv::Mat bits;
+    processReadbackFrame(frame, gray, EdgeParams(), nullptr, EDGE_FORMAT_GRAY);
+    processReadbackFrame(frame, bits, EdgeParams(), nullptr, EDGE_FORMAT_PACKED);
+    edges.assign(gray.begin<uchar>(), gray.end<uchar>());
+    packed = packEdges(edges, width, height);
+    if (!std::equal(packed.begin(), packed.end(), bits.begin<uchar>())) {
+        std::fprintf(stderr, "%dx%d: packed kernel output differs\n", width, height);
+        return 1;
+    }
+#else
+    // Luma steps of the synthetic scene stand in for Canny edges
+    edges.assign(static_cast<size_t>(width) * height, 0);
+    for (size_t i = 1; i < edges.size(); i++) {
+        edges[i] = std::abs(scene[i * 4 + 2] - scene[i * 4 - 2]) > 24 ? 255 : 0;
+    }
+    packed = packEdges(edges, width, height);
+#endif
+    return 0;
+}
+
+void printFormatHeader() {
+    std::printf("\n%-8s %-12s %10s %10s %10s %10s\n", "res", "edge upload", "bytes", "median_ms", "p99_ms", "mean_ms");
+}
+
+// Times the upload of one edge map in each layout and checks what the edge
+// program draws from it. `edges` is 0/255, one byte per pixel, GL row order.
+int benchEdgeFormats(const Resolution& res, const std::vector<unsigned char>& edges,
+                     const std::vector<unsigned char>& packed, const EdgeProgram& edge,
+                     const BenchOptions& options) {
+    std::vector<unsigned char> rgba(edges.size() * 4);
+    for (size_t i = 0; i < edges.size(); i++) {
+        rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = edges[i];
+        rgba[i * 4 + 3] = 255;
+    }
+
+    RenderTarget target;
+    if (!createTarget(target, res.width, res.height)) {
+        std::fprintf(stderr, "%s: incomplete framebuffer\n", res.name);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int layout = 0; layout < kLayoutCount; layout++) {
+        int cols = layout == kLayoutPacked ? (res.width + 7) / 8 : res.width;
+        GLenum format = layout == kLayoutRgba ? GL_RGBA : GL_LUMINANCE;
+        const unsigned char* data = layout == kLayoutRgba ? rgba.data()
+                                  : layout == kLayoutGray ? edges.data() : packed.data();
+        size_t bytes = static_cast<size_t>(cols) * res.height * (layout == kLayoutRgba ? 4 : 1);
+        GLint filter = layout == kLayoutPacked ? GL_NEAREST : GL_LINEAR;
+
+        StreamTexture stream;
+        streamTextureInit(stream);
+        Timing t = timeFrames(options.frames, options.warmup, [&] {
+            streamTextureUpload(stream, cols, res.height, format, data, layout == kLayoutRgba ? 4 : 1, filter);
+            glFinish();
+        });
+        int bad = checkEdgeDisplay(edge, streamTextureCurrent(stream), layout == kLayoutPacked, target, edges);
+        streamTextureDestroy(stream);
+
+        std::printf("%-8s %-12s %10zu %10.3f %10.3f %10.3f%s\n", res.name, kLayoutNames[layout], bytes,
+                    t.medianMs, t.p99Ms, t.meanMs, bad == 0 ? "" : "  MISMATCH");
+        failures += bad != 0;
+    }
+    destroyTarget(target);
+    return failures;
+}
+
+void printGpuHeader() {
+    std::printf("\n%-8s %-12s %10s %10s %10s\n", "res", "gpu canny", "median_ms", "p99_ms", "mean_ms");
+}
+
+// Times every pass, including glFinish, as the render thread would see it
+void benchGpuCanny(const Resolution& res, GpuCanny& canny, const BenchOptions& options) {
+    std::vector<unsigned char> scene = makeSceneRgba(res.width, res.height);
+    GLuint input = uploadRgbaTexture(scene, res.width, res.height);
+    gpuCannyResize(canny, res.width, res.height);
+
+    GpuCannyParams params;
+    Timing t = timeFrames(options.frames, options.warmup, [&] {
+        gpuCannyRun(canny, input, params);
+        glFinish();
+    });
+    char mode[32];
+    std::snprintf(mode, sizeof(mode), "%d passes", params.hysteresisPasses);
+    std::printf("%-8s %-12s %10.3f %10.3f %10.3f\n", res.name, mode, t.medianMs, t.p99Ms, t.meanMs);
+    glDeleteTextures(1, &input);
+}
+
+#ifdef HAVE_EDGE_CORE
+// Reads the red channel of an RGBA texture as an 8-bit edge map
+std::vector<unsigned char> readEdges(GLuint texture, int width, int height) {
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+
+    std::vector<unsigned char> edges(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < edges.size(); i++) {
+        edges[i] = rgba[i * 4];
+    }
+    return edges;
+}
+
+// CPU pipeline on the same frame, walked in the texture's stored (GL) row
+// order like the GPU passes. Without `blur` this is the renderer's fusedCanny;
+// with it the luma is smoothed with the GPU's 3x3 Gaussian (rounded,
+// replicated border) before cv::Canny, which no CPU path reproduces.
+std::vector<unsigned char> cpuEdges(std::vector<unsigned char>& rgba, int width, int height,
+                                    const GpuCannyParams& params) {
+    cv::Mat frame(height, width, CV_8UC4, rgba.data());
+    EdgeParams edgeParams;
+    edgeParams.lowThreshold = params.lowThreshold;
+    edgeParams.highThreshold = params.highThreshold;
+
+    cv::Mat edges;
+    if (!params.blur) {
+        fusedCanny(frame, edges, CV_8UC1, edgeParams, false);
+    } else {
+        cv::Mat gray;
+        cv::Mat blurred(height, width, CV_8UC1);
+        cv::cvtColor(frame, gray, cv::COLOR_RGBA2GRAY);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int sum = 0;
+                for (int j = -1; j <= 1; j++) {
+                    for (int i = -1; i <= 1; i++) {
+                        int weight = (i == 0 ? 2 : 1) * (j == 0 ? 2 : 1);
+                        sum += weight * gray.at<uchar>(std::min(std::max(y + j, 0), height - 1),
+                                                       std::min(std::max(x + i, 0), width - 1));
+                    }
+                }
+                blurred.at<uchar>(y, x) = static_cast<uchar>((sum + 8) >> 4);
+            }
+        }
+        cv::Canny(blurred, edges, params.lowThreshold, params.highThreshold, 3, false);
+    }
+    return std::vector<unsigned char>(edges.begin<uchar>(), edges.end<uchar>());
+}
+
+int countDifferences(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b) {
+    int diff = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff += a[i] != b[i];
+    }
+    return diff;
+}
+
+// Returns the number of pixels where the converged GPU result differs from the CPU
+int checkGpuAgreement(GpuCanny& canny, int width, int height, bool blur) {
+    std::vector<unsigned char> scene = makeSceneRgba(width, height);
+    GLuint input = uploadRgbaTexture(scene, width, height);
+    gpuCannyResize(canny, width, height);
+
+    GpuCannyParams params;
+    params.blur = blur;
+    std::vector<unsigned char> expected = cpuEdges(scene, width, height, params);
+    std::vector<unsigned char> gpu = readEdges(gpuCannyRun(canny, input, params), width, height);
+    int atDefault = countDifferences(gpu, expected);
+
+    // Grow until a round of passes changes nothing
+    const int kPassesPerCheck = 32;
+    int passes = params.hysteresisPasses;
+    for (int limit = width * height; passes < limit; passes += kPassesPerCheck) {
+        gpuCannyHysteresis(canny, kPassesPerCheck);
+        std::vector<unsigned char> grown = readEdges(gpuCannyResolve(canny), width, height);
+        bool stable = grown == gpu;
+        gpu.swap(grown);
+        if (stable) {
+            break;
+        }
+    }
+    int converged = countDifferences(gpu, expected);
+    glDeleteTextures(1, &input);
+
+    std::printf("%4dx%-4d blur=%d  %d passes: %6.3f%% differ  converged (%d passes): %d differ  %s\n",
+                width, height, blur ? 1 : 0, params.hysteresisPasses,
+                100.0 * atDefault / (static_cast<double>(width) * height), passes, converged,
+                converged == 0 ? "ok" : "MISMATCH");
+    return converged;
+}
+#endif
+
+// The renderer's vertex shader before render passes: trig rotation per
+// vertex, uniforms looked up and the quad sent from client memory every draw
+const char* kLegacyVertexSource = R"(
+attribute vec4 aPosition;
+attribute vec2 aTexCoord;
+uniform float uRotation;
+uniform bool uIsFrontCamera;
+uniform bool uTopDown;
+varying vec2 vTexCoord;
+void main() {
+    gl_Position = aPosition;
+    vec2 texCoord = aTexCoord;
+    float angle = uRotation * 3.14159265359 / 180.0;
+    float cosA = cos(angle);
+    float sinA = sin(angle);
+    texCoord -= 0.5;
+    float newX = texCoord.x * cosA - texCoord.y * sinA;
+    float newY = texCoord.x * sinA + texCoord.y * cosA;
+    texCoord = vec2(newX, newY) + 0.5;
+    if (uIsFrontCamera) {
+        texCoord.x = 1.0 - texCoord.x;
+    }
+    if (uTopDown) {
+        texCoord.y = 1.0 - texCoord.y;
+    }
+    vTexCoord = texCoord;
+}
+)";
+
+const char* kQuadFragmentSource = R"(
+precision mediump float;
+uniform sampler2D uTexture;
+varying vec2 vTexCoord;
+void main() {
+    gl_FragColor = texture2D(uTexture, vTexCoord);
+}
+)";
+
+const float kClientQuad[] = {
+    -1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+     1.0f, -1.0f, 0.0f,  1.0f, 0.0f,
+    -1.0f,  1.0f, 0.0f,  0.0f, 1.0f,
+     1.0f,  1.0f, 0.0f,  1.0f, 1.0f
+};
+
+// Draws the bound texture the way the renderer used to
+void drawLegacyQuad(GLuint program, int rotation, bool mirrored, bool topDown) {
+    glUseProgram(program);
+    GLint positionLoc = glGetAttribLocation(program, "aPosition");
+    GLint texCoordLoc = glGetAttribLocation(program, "aTexCoord");
+    GLint textureLoc = glGetUniformLocation(program, "uTexture");
+    GLint rotationLoc = glGetUniformLocation(program, "uRotation");
+    GLint isFrontCameraLoc = glGetUniformLocation(program, "uIsFrontCamera");
+    GLint topDownLoc = glGetUniformLocation(program, "uTopDown");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableVertexAttribArray(positionLoc);
+    glEnableVertexAttribArray(texCoordLoc);
+    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), kClientQuad);
+    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), kClientQuad + 3);
+    glUniform1f(rotationLoc, static_cast<GLfloat>(rotation));
+    glUniform1i(isFrontCameraLoc, mirrored ? 1 : 0);
+    glUniform1i(topDownLoc, topDown ? 1 : 0);
+    glUniform1i(textureLoc, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(positionLoc);
+    glDisableVertexAttribArray(texCoordLoc);
+}
+
+std::vector<unsigned char> readTarget(const RenderTarget& target) {
+    std::vector<unsigned char> rgba(static_cast<size_t>(target.width) * target.height * 4);
+    glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    return rgba;
+}
+
+// Checks that a render pass orients frames exactly like the old trig shader
+// for every camera rotation, mirrored or not, top-down or not, and times a
+// draw both ways. Returns the number of orientations that differ.
+int checkRenderPass(const BenchOptions& options) {
+    const int size = 64;  // Square, so quarter turns map texels onto pixels
+    RenderTarget target;
+    if (!createTarget(target, size, size)) {
+        std::fprintf(stderr, "render pass: incomplete framebuffer\n");
+        return 1;
+    }
+    GLuint legacy = createProgram(kLegacyVertexSource, kQuadFragmentSource);
+    GLuint program = createProgram(kQuadVertexSource, kQuadFragmentSource);
+    GLuint quad = quadBufferCreate();
+    RenderPass pass;
+    if (legacy == 0 || !renderPassInit(pass, program) || quad == 0) {
+        std::fprintf(stderr, "render pass: setup failed\n");
+        destroyTarget(target);
+        return 1;
+    }
+    GLuint texture = uploadRgbaTexture(makeSceneRgba(size, size), size, size);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, size, size);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    int failures = 0;
+    for (int rotation = 0; rotation < 360; rotation += 90) {
+        for (int flags = 0; flags < 4; flags++) {
+            bool mirrored = (flags & 1) != 0;
+            bool topDown = (flags & 2) != 0;
+            drawLegacyQuad(legacy, rotation, mirrored, topDown);
+            std::vector<unsigned char> expected = readTarget(target);
+            glUseProgram(pass.program);
+            renderPassSetOrientation(pass, rotation, mirrored, topDown);
+            renderPassDraw(pass, quad);
+            if (readTarget(target) != expected) {
+                std::fprintf(stderr, "render pass: rotation %d mirrored %d top-down %d differs\n",
+                             rotation, mirrored, topDown);
+                failures++;
+            }
+        }
+    }
+
+    // CPU cost of issuing one draw; the orientation stays put as it does between camera changes
+    Timing legacyTime = timeFrames(options.frames, options.warmup, [&] {
+        for (int i = 0; i < 100; i++) {
+            drawLegacyQuad(legacy, 90, true, true);
+        }
+        glFinish();
+    });
+    Timing passTime = timeFrames(options.frames, options.warmup, [&] {
+        glUseProgram(pass.program);
+        for (int i = 0; i < 100; i++) {
+            renderPassSetOrientation(pass, 90, true, true);
+            renderPassDraw(pass, quad);
+        }
+        glFinish();
+    });
+    std::printf("\n%-12s %12s %12s\n", "quad draw", "median_us", "mean_us");
+    std::printf("%-12s %12.2f %12.2f\n", "legacy", legacyTime.medianMs * 10.0, legacyTime.meanMs * 10.0);
+    std::printf("%-12s %12.2f %12.2f\n", "render pass", passTime.medianMs * 10.0, passTime.meanMs * 10.0);
+    std::printf("orientations matching the legacy shader: %d/16\n", 16 - failures);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &quad);
+    glDeleteProgram(program);
+    glDeleteProgram(legacy);
+    destroyTarget(target);
+    return failures;
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--frames N] [--warmup N]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    HeadlessContext ctx;
+    if (!createHeadlessContext(ctx)) {
+        return 1;
+    }
+    std::printf("%s / %s, %d frames (+%d warmup)\n",
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+                options.frames, options.warmup);
+
+    int failures = 0;
+    printHeader();
+    for (const Resolution& res : kResolutions) {
+        RenderTarget target;
+        if (!createTarget(target, res.width, res.height)) {
+            std::fprintf(stderr, "%s: incomplete framebuffer\n", res.name);
+            failures++;
+            continue;
+        }
+        failures += benchSync(res, target, options);
+        failures += benchRing(res, target, options, 2);
+        failures += benchRing(res, target, options, 3);
+        destroyTarget(target);
+    }
+
+    printUploadHeader();
+    for (const Resolution& res : kResolutions) {
+        failures += benchUpload(res, options);
+    }
+
+    EdgeProgram edge;
+    if (!edgeProgramInit(edge, kEdgeVertexSource)) {
+        std::fprintf(stderr, "edge program unavailable\n");
+        failures++;
+    } else {
+        printFormatHeader();
+        for (const Resolution& res : kResolutions) {
+            std::vector<unsigned char> edges;
+            std::vector<unsigned char> packed;
+            failures += makeEdgeMaps(res.width, res.height, edges, packed);
+            failures += benchEdgeFormats(res, edges, packed, edge, options);
+        }
+        edgeProgramDestroy(edge);
+    }
+
+    failures += checkRenderPass(options);
+
+    GpuCanny canny;
+    if (!gpuCannyInit(canny, GL_TEXTURE_2D)) {
+        std::fprintf(stderr, "GPU Canny unavailable\n");
+        failures++;
+    } else {
+        printGpuHeader();
+        for (const Resolution& res : kResolutions) {
+            benchGpuCanny(res, canny, options);
+        }
+
+#ifdef HAVE_EDGE_CORE
+        std::printf("\nGPU vs CPU agreement\n");
+        const int sizes[][2] = {{1280, 720}, {333, 197}};
+        for (const auto& size : sizes) {
+            for (bool blur : {false, true}) {
+                failures += checkGpuAgreement(canny, size[0], size[1], blur) != 0;
+            }
+        }
+#else
+        std::printf("\nGPU vs CPU agreement check skipped (built without OpenCV)\n");
+#endif
+        gpuCannyDestroy(canny);
+    }
+
+    destroyHeadlessContext(ctx);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+// Simulation of the adaptive quality governor under changing CPU load.
+//
+// Input frames arrive at 30 fps and each processed frame "costs" the base
+// time of the default level, scaled by a per-level cost and by the load of
+// the current phase, with log-normal noise and occasional 3x spikes. The
+// simulated costs deliberately differ from the governor's relativeCost table,
+// as real devices will. Each phase of load is checked once settled, using
+// the level the governor spent most of that time at:
+//   - it keeps the cost per input frame within the budget,
+//   - it is no lower than needed: the next better level would not fit,
+//     unless it is the best level allowed,
+//   - it does not oscillate: only a few level changes after settling,
+//   - it never steps above the best level allowed.
+// The whole ladder is open by default; --best-level 3 caps it at the default
+// quality, as the renderer does unless asked for higher quality.
+// Exits non-zero if any check fails. Needs no OpenCV, so it runs anywhere.
+//
+// Usage: governor_sim [--budget MS] [--base MS] [--seed N] [--best-level N]
+
+#include "quality_governor.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+struct SimOptions {
+    double budgetMs = 16.0;
+    double baseMs = 10.0;  // Default level at load 1
+    unsigned seed = 1;
+    int bestLevel = 0;  // GovernorConfig::bestLevel
+};
+
+// Load multiplier held for a number of seconds
+struct Phase {
+    double seconds;
+    double load;
+};
+
+const Phase kPhases[] = {
+    {10.0, 1.0},   // Nominal
+    {15.0, 2.5},   // Throttled
+    {10.0, 6.0},   // Heavily throttled
+    {15.0, 1.0},   // Recovered
+    {10.0, 0.45},  // Cool device with headroom for better quality
+};
+
+// "True" cost per processed frame relative to the default level, within
+// about 20% of the governor's table (which is per input frame)
+const double kSimulatedCost[kQualityLevelCount] = {1.8, 1.5, 1.2, 1.0, 0.35, 0.35, 0.12, 0.12};
+
+const int kFps = 30;
+const double kSettleSeconds = 4.0;
+const int kMaxSettledTransitions = 4;
+// The governor holds the upper quartile of a window within the budget
+const double kMaxOverBudgetShare = 0.25;
+
+// Helper function to turn milliseconds into nanoseconds
+int64_t toNanos(double ms) {
+    return static_cast<int64_t>(ms * 1e6);
+}
+
+// Mean cost per input frame at `level` under `load`, noise excluded
+double meanCostMs(const SimOptions& options, int level, double load) {
+    return options.baseMs * kSimulatedCost[level] * load / kQualityLevels[level].frameInterval;
+}
+
+bool parseOptions(int argc, char** argv, SimOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--budget") == 0 && hasValue) {
+            options.budgetMs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--base") == 0 && hasValue) {
+            options.baseMs = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--best-level") == 0 && hasValue) {
+            options.bestLevel = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--budget MS] [--base MS] [--seed N] [--best-level N]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.budgetMs <= 0.0 || options.baseMs <= 0.0) {
+        std::fprintf(stderr, "--budget and --base must be positive\n");
+        return false;
+    }
+    if (options.bestLevel < 0 || options.bestLevel > kDefaultQualityLevel) {
+        std::fprintf(stderr, "--best-level must be 0..%d\n", kDefaultQualityLevel);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    GovernorConfig config;
+    config.budgetNanos = toNanos(options.budgetMs);
+    config.bestLevel = options.bestLevel;
+    QualityGovernor governor;
+    governorInit(governor, config);
+
+    std::mt19937 rng(options.seed);
+    std::lognormal_distribution<double> noise(0.0, 0.15);
+    std::uniform_real_distribution<double> spike(0.0, 1.0);
+    const int64_t frameNanos = 1000000000LL / kFps;
+    int64_t now = 0;
+    int failures = 0;
+    int aboveBest = 0;  // Frames processed at a level better than allowed
+
+    std::printf("budget %.1f ms, default level %.1f ms at load 1, %d fps, best level %d\n", options.budgetMs,
+                options.baseMs, kFps, options.bestLevel);
+    std::printf("%6s %6s %6s %11s %8s %9s %8s\n", "load", "level", "moves", "settled_ms", "over_%", "skipped",
+                "best_ms");
+    for (const Phase& phase : kPhases) {
+        const int frames = static_cast<int>(phase.seconds * kFps);
+        const int settleFrame = static_cast<int>(kSettleSeconds * kFps);
+        int64_t transitionsAtSettle = 0;
+        int settledFrames = 0;
+        int overBudget = 0;
+        double settledCost = 0.0;
+        int64_t skippedBefore = governor.framesSkipped;
+        int framesAt[kQualityLevelCount] = {};
+
+        // Skipped frames share the cost of the next processed one, as in the governor
+        int pendingFrames = 0;
+        for (int i = 0; i < frames; i++, now += frameNanos) {
+            if (i == settleFrame) {
+                transitionsAtSettle = governor.transitions;
+            }
+            pendingFrames++;
+            if (!governorAdmitFrame(governor)) {
+                continue;
+            }
+            int level = governor.level;
+            if (level < options.bestLevel) {
+                aboveBest++;
+            }
+            double cost = options.baseMs * kSimulatedCost[level] * phase.load * noise(rng);
+            if (spike(rng) < 0.02) {
+                cost *= 3.0;
+            }
+            if (i >= settleFrame) {
+                framesAt[level] += pendingFrames;
+                double perFrame = cost / pendingFrames;
+                settledFrames += pendingFrames;
+                settledCost += cost;
+                if (perFrame > options.budgetMs) {
+                    overBudget += pendingFrames;
+                }
+            }
+            pendingFrames = 0;
+            governorRecord(governor, level, toNanos(cost), now);
+        }
+
+        int level = 0;
+        for (int l = 1; l < kQualityLevelCount; l++) {
+            level = framesAt[l] > framesAt[level] ? l : level;
+        }
+        int64_t moves = governor.transitions - transitionsAtSettle;
+        double overShare = settledFrames > 0 ? static_cast<double>(overBudget) / settledFrames : 0.0;
+        double betterCost = level > options.bestLevel ? meanCostMs(options, level - 1, phase.load) : 0.0;
+        std::printf("%6.2f %6d %6lld %11.2f %8.1f %9lld %8.2f\n", phase.load, level, static_cast<long long>(moves),
+                    settledFrames > 0 ? settledCost / settledFrames : 0.0, overShare * 100.0,
+                    static_cast<long long>(governor.framesSkipped - skippedBefore), betterCost);
+
+        if (meanCostMs(options, level, phase.load) > options.budgetMs || overShare > kMaxOverBudgetShare) {
+            std::fprintf(stderr, "FAIL: load %.2f settled at level %d, over the budget\n", phase.load, level);
+            failures++;
+        }
+        if (level > options.bestLevel && betterCost < options.budgetMs * config.upshiftRatio * 0.8) {
+            std::fprintf(stderr, "FAIL: load %.2f settled at level %d, level %d would fit\n", phase.load, level,
+                         level - 1);
+            failures++;
+        }
+        if (moves > kMaxSettledTransitions) {
+            std::fprintf(stderr, "FAIL: load %.2f changed level %lld times after settling\n", phase.load,
+                         static_cast<long long>(moves));
+            failures++;
+        }
+    }
+
+    if (aboveBest != 0) {
+        std::fprintf(stderr, "FAIL: %d frames processed above best level %d\n", aboveBest, options.bestLevel);
+        failures++;
+    }
+
+    QualityTransition history[QualityGovernor::kHistorySize];
+    int count = governorHistory(governor, history, QualityGovernor::kHistorySize);
+    std::printf("last %d of %lld transitions:\n", count, static_cast<long long>(governor.transitions));
+    for (int i = 0; i < count; i++) {
+        std::printf("  %7.2f s  %d -> %d  (%.2f ms per frame)\n", history[i].timestampNanos / 1e9,
+                    history[i].fromLevel, history[i].toLevel, history[i].costNanos / 1e6);
+    }
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
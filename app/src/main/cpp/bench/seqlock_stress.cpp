@@ -0,0 +1,156 @@
+// Stress test for Seqlock, the snapshot the render thread publishes its frame
+// counters through for the stats reporter.
+//
+// One writer publishes a multi-word record as fast as it can while reader
+// threads poll it. Every field of a record is derived from its sequence
+// number, so a reader catches any torn read (fields from two writes) and any
+// record older than one it already saw. Also reports what a write costs the
+// writer with and without readers polling. Exits non-zero if any check fails.
+//
+// Usage: seqlock_stress [--writes N] [--readers N]
+
+#include "seqlock.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct StressOptions {
+    int writes = 2000000;
+    int readers = 2;
+};
+
+// Five words, like the renderer's counters plus room to spare
+struct Record {
+    int64_t sequence;
+    int64_t doubled;
+    int64_t inverted;
+    int32_t low;
+    int32_t high;
+    int64_t checksum;
+};
+
+static Record makeRecord(int64_t sequence) {
+    Record record;
+    record.sequence = sequence;
+    record.doubled = sequence * 2;
+    record.inverted = ~sequence;
+    record.low = static_cast<int32_t>(sequence & 0x7FFFFFFF);
+    record.high = static_cast<int32_t>(sequence >> 31);
+    record.checksum = sequence * 2654435761LL;
+    return record;
+}
+
+static bool recordIntact(const Record& record) {
+    Record expected = makeRecord(record.sequence);
+    return std::memcmp(&record, &expected, sizeof(Record)) == 0;
+}
+
+// Helper function to time the writer alone. Returns nanoseconds per write.
+static double timeWrites(Seqlock<Record>& snapshot, int writes, int64_t firstSequence) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < writes; i++) {
+        snapshot.write(makeRecord(firstSequence + i));
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / writes;
+}
+
+// Helper function to parse the command line
+static bool parseOptions(int argc, char** argv, StressOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--writes") == 0 && hasValue) {
+            options.writes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--readers") == 0 && hasValue) {
+            options.readers = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--writes N] [--readers N]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.writes <= 0 || options.readers <= 0) {
+        std::fprintf(stderr, "--writes and --readers must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    StressOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    Seqlock<Record> snapshot;
+    snapshot.write(makeRecord(0));
+    double aloneNanos = timeWrites(snapshot, options.writes, 1);
+    int64_t base = options.writes + 1;
+
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> backwards{0};
+    std::vector<int64_t> reads(options.readers, 0);
+    std::vector<int64_t> retries(options.readers, 0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < options.readers; r++) {
+        readers.emplace_back([&, r] {
+            int64_t last = -1;
+            while (!done.load(std::memory_order_acquire)) {
+                Record record;
+                if (!snapshot.tryRead(record)) {
+                    retries[r]++;
+                    continue;
+                }
+                reads[r]++;
+                if (!recordIntact(record)) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                } else if (record.sequence < last) {
+                    backwards.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    last = record.sequence;
+                }
+            }
+            // The last write must be visible once the writer is done
+            Record latest = snapshot.read();
+            if (latest.sequence != base + options.writes - 1) {
+                backwards.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    double contendedNanos = timeWrites(snapshot, options.writes, base);
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    int64_t totalReads = 0;
+    int64_t totalRetries = 0;
+    for (int r = 0; r < options.readers; r++) {
+        totalReads += reads[r];
+        totalRetries += retries[r];
+    }
+    std::printf("%d writes, %d readers\n", options.writes, options.readers);
+    std::printf("write: %.1f ns alone, %.1f ns with readers polling\n", aloneNanos, contendedNanos);
+    std::printf("reads: %lld intact, %lld retried, %d torn, %d out of order\n",
+                static_cast<long long>(totalReads), static_cast<long long>(totalRetries),
+                torn.load(), backwards.load());
+    std::printf("version: %u (expect %d)\n", snapshot.version(), 2 * options.writes + 1);
+
+    int failures = torn.load() + backwards.load();
+    if (snapshot.version() != static_cast<uint32_t>(2 * options.writes + 1)) {
+        std::fprintf(stderr, "FAIL: version does not count the writes\n");
+        failures++;
+    }
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
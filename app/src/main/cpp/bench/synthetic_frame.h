@@ -0,0 +1,40 @@
+#pragma once
+
+// Synthetic camera frames shared by the host tools
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <cstdint>
+
+// Builds a deterministic RGBA scene with enough structure to keep Canny busy;
+// each seed gives a different arrangement of shapes
+inline cv::Mat makeSyntheticFrame(int width, int height, uint64_t seed = 0x5eed) {
+    cv::Mat frame(height, width, CV_8UC4);
+    for (int y = 0; y < height; y++) {
+        cv::Vec4b* row = frame.ptr<cv::Vec4b>(y);
+        for (int x = 0; x < width; x++) {
+            row[x] = cv::Vec4b(static_cast<uchar>(x * 255 / width),
+                               static_cast<uchar>(y * 255 / height),
+                               static_cast<uchar>((x + y) & 0xFF), 255);
+        }
+    }
+
+    cv::RNG rng(seed);
+    int shapes = (width * height) / 20000;
+    for (int i = 0; i < shapes; i++) {
+        cv::Point center(rng.uniform(0, width), rng.uniform(0, height));
+        cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256), 255);
+        if (i & 1) {
+            cv::circle(frame, center, rng.uniform(4, height / 8), color, cv::FILLED);
+        } else {
+            cv::Point corner = center + cv::Point(rng.uniform(8, width / 8), rng.uniform(8, height / 8));
+            cv::rectangle(frame, center, corner, color, rng.uniform(1, 6));
+        }
+    }
+
+    cv::Mat noise(height, width, CV_16SC4);
+    rng.fill(noise, cv::RNG::NORMAL, 0, 6);
+    cv::add(frame, noise, frame, cv::noArray(), CV_8U);
+    return frame;
+}
@@ -0,0 +1,195 @@
+#include "edge_pipeline.h"
+
+#include "fused_canny.h"
+#include "quality_governor.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <utility>
+
+cv::Mat processFrameWithCanny(const cv::Mat& input, const EdgeParams& params) {
+    cv::Mat gray, edges, result;
+
+    // Convert to grayscale
+    cv::cvtColor(input, gray, cv::COLOR_RGBA2GRAY);
+
+    // Apply Canny edge detection
+    cv::Canny(gray, edges, params.lowThreshold, params.highThreshold);
+
+    // Convert back to RGBA for display
+    cv::cvtColor(edges, result, cv::COLOR_GRAY2RGBA);
+
+    return result;
+}
+
+void applyQualityLevel(const QualityLevel& level, EdgeParams& params) {
+    params.l2Gradient = level.l2Gradient;
+    params.blurAperture = level.blurAperture;
+    params.downscale = level.downscale;
+}
+
+namespace {
+
+// Helper function to map an edge format to the fused kernel's dstType
+int edgeDstType(EdgeFormat format) {
+    switch (format) {
+        case EDGE_FORMAT_GRAY:
+            return CV_8UC1;
+        case EDGE_FORMAT_PACKED:
+            return kCannyPackedBits;
+        default:
+            return CV_8UC4;
+    }
+}
+
+// Helper function to turn row/column flips into a cv::flip code
+int flipCode(bool flipRows, bool flipCols) {
+    return flipRows && flipCols ? -1 : (flipRows ? 0 : 1);
+}
+
+// Helper function to make the shrunk and/or blurred luma plane Canny runs on,
+// for `params` that ask for either. Rows stay in `frame`'s stored order; rows
+// and columns that don't fill a whole downscale block are dropped from the
+// bottom and right of the displayed image.
+const cv::Mat& prepareLuma(const FrameView& frame, const EdgeParams& params, CannyWorkspace& ws) {
+    const int cn = frame.format == FRAME_PIXEL_RGBA ? 4 : 1;
+    const int factor = std::max(1, params.downscale);
+    cv::Mat luma;
+    if (factor > 1) {
+        // Bottom-up frames drop their first stored rows instead of their last
+        int top = frame.orientation.bottomUp ? frame.height % factor : 0;
+        downscaleLuma(frame.data + static_cast<size_t>(top) * frame.rowStride, cn, frame.width,
+                      frame.height - top, frame.rowStride, frame.pixelStride, factor, ws.smallLuma, params, &ws);
+        luma = ws.smallLuma;
+    } else if (cn == 4) {
+        cv::Mat rgba(frame.height, frame.width, CV_8UC4, const_cast<uchar*>(frame.data),
+                     static_cast<size_t>(frame.rowStride));
+        cv::cvtColor(rgba, ws.luma, cv::COLOR_RGBA2GRAY);
+        luma = ws.luma;
+    } else if (frame.pixelStride == 1) {
+        luma = cv::Mat(frame.height, frame.width, CV_8UC1, const_cast<uchar*>(frame.data),
+                       static_cast<size_t>(frame.rowStride));
+    } else {
+        ws.luma.create(frame.height, frame.width, CV_8UC1);
+        for (int y = 0; y < frame.height; y++) {
+            const uchar* src = frame.data + static_cast<size_t>(y) * frame.rowStride;
+            uchar* dst = ws.luma.ptr(y);
+            for (int x = 0; x < frame.width; x++) {
+                dst[x] = src[x * frame.pixelStride];
+            }
+        }
+        luma = ws.luma;
+    }
+
+    cv::Mat& prepared = factor > 1 ? ws.smallLuma : ws.luma;
+    if (params.blurAperture > 1) {
+        // Symmetric kernel, so blurring the stored rows equals blurring upright ones
+        cv::GaussianBlur(luma, prepared, cv::Size(params.blurAperture, params.blurAperture), 0);
+    }
+    return prepared;
+}
+
+}  // namespace
+
+void processStillImage(const uchar* input, int width, int height, int inputStride,
+                       uchar* output, int outputStride, const EdgeParams& params,
+                       CannyWorkspace* workspace) {
+    CV_Assert(inputStride >= width * 4 && outputStride >= width * 4);
+    const cv::Mat image(height, width, CV_8UC4, const_cast<uchar*>(input), inputStride);
+    cv::Mat edges(height, width, CV_8UC4, output, outputStride);
+    fusedCanny(image, edges, CV_8UC4, params, false, workspace);
+    CV_Assert(edges.data == output);  // Written in place, never reallocated
+}
+
+void processReadbackFrame(const cv::Mat& readback, cv::Mat& output, const EdgeParams& params,
+                          CannyWorkspace* workspace, EdgeFormat format) {
+    CV_Assert(readback.type() == CV_8UC4);
+
+    // The kernel walks the rows upright itself, so no flip passes are needed
+    fusedCanny(readback, output, edgeDstType(format), params, true, workspace);
+}
+
+void processLumaPlane(const uchar* y, int width, int height, int rowStride, int pixelStride,
+                      cv::Mat& edges, const EdgeParams& params, CannyWorkspace* workspace,
+                      EdgeFormat format) {
+    fusedCannyPlane(y, width, height, rowStride, pixelStride, edges, edgeDstType(format), params, true,
+                    workspace);
+}
+
+size_t frameViewBytes(const FrameView& frame) {
+    if (frame.width <= 0 || frame.height <= 0) {
+        return 0;
+    }
+    size_t rows = static_cast<size_t>(frame.height);
+    switch (frame.format) {
+        case FRAME_PIXEL_RGBA:
+            return (rows - 1) * frame.rowStride + static_cast<size_t>(frame.width) * 4;
+        case FRAME_PIXEL_NV21:
+            // VU rows share the Y stride and follow the last Y row
+            return (rows + (rows + 1) / 2) * frame.rowStride;
+        default:
+            return (rows - 1) * frame.rowStride + static_cast<size_t>(frame.width - 1) * frame.pixelStride + 1;
+    }
+}
+
+void processFrameView(const FrameView& frame, cv::Mat& edges, FrameOrientation& edgesOrientation,
+                      const EdgeParams& params, CannyWorkspace* workspace, EdgeFormat format) {
+    edgesOrientation = frame.orientation;
+    if (params.downscale > 1 || params.blurAperture > 1) {
+        CannyWorkspace localWorkspace;
+        CannyWorkspace& ws = workspace != nullptr ? *workspace : localWorkspace;
+        const cv::Mat& luma = prepareLuma(frame, params, ws);
+        if (frame.format == FRAME_PIXEL_RGBA) {
+            fusedCanny(luma, edges, edgeDstType(format), params, frame.orientation.bottomUp, &ws);
+        } else {
+            fusedCannyPlane(luma.data, luma.cols, luma.rows, luma.step, 1, edges, edgeDstType(format), params,
+                            true, &ws);
+            edgesOrientation.bottomUp = !frame.orientation.bottomUp;
+        }
+        return;
+    }
+    if (frame.format == FRAME_PIXEL_RGBA) {
+        cv::Mat rgba(frame.height, frame.width, CV_8UC4, const_cast<uchar*>(frame.data),
+                     static_cast<size_t>(frame.rowStride));
+        fusedCanny(rgba, edges, edgeDstType(format), params, frame.orientation.bottomUp, workspace);
+    } else {
+        processLumaPlane(frame.data, frame.width, frame.height, frame.rowStride, frame.pixelStride,
+                         edges, params, workspace, format);
+        edgesOrientation.bottomUp = !frame.orientation.bottomUp;
+    }
+}
+
+void orientUpright(const cv::Mat& src, const FrameOrientation& orientation, cv::Mat& dst) {
+    CV_Assert(dst.data == nullptr || dst.data != src.data);
+
+    bool flipRows = orientation.bottomUp;
+    bool flipCols = orientation.mirrored;
+    int rotation = ((orientation.rotation % 360) + 360) % 360 / 90 * 90;
+
+    if (rotation == 90 || rotation == 270) {
+        // Transposing swaps which axis each flip applies to; a clockwise
+        // quarter turn is then one more column flip, three are a row flip
+        cv::transpose(src, dst);
+        std::swap(flipRows, flipCols);
+        if (rotation == 90) {
+            flipCols = !flipCols;
+        } else {
+            flipRows = !flipRows;
+        }
+        if (flipRows || flipCols) {
+            cv::flip(dst, dst, flipCode(flipRows, flipCols));
+        }
+        return;
+    }
+
+    if (rotation == 180) {
+        flipRows = !flipRows;
+        flipCols = !flipCols;
+    }
+    if (flipRows || flipCols) {
+        cv::flip(src, dst, flipCode(flipRows, flipCols));
+    } else {
+        src.copyTo(dst);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+// Platform-neutral CPU edge pipeline. Nothing in here may depend on JNI, EGL
+// or GLES so that the same code runs inside the app and in host tools.
+
+struct CannyWorkspace;
+
+// Canny parameters shared by every processing path
+struct EdgeParams {
+    double lowThreshold = 50.0;
+    double highThreshold = 150.0;
+    // Horizontal stripes for the parallel Canny kernel; 0 = one per OpenCV thread
+    int stripes = 0;
+
+    // Quality knobs the governor trades for time (see quality_governor.h).
+    // The defaults give exactly processFrameWithCanny's edges.
+    bool l2Gradient = false;  // sqrt(dx^2 + dy^2) magnitude instead of |dx| + |dy|
+    int blurAperture = 0;     // Gaussian blur of the luma before Canny: 0 (none), 3 or 5
+    int downscale = 1;        // Canny runs on the luma shrunk by 1, 2 or 4; so is the edge map
+};
+
+struct QualityLevel;
+
+// Helper function to set the quality knobs of `params` to a governor level
+void applyQualityLevel(const QualityLevel& level, EdgeParams& params);
+
+// Width or height of the edge map processFrameView makes of a frame dimension.
+// A smaller map is magnified back to full size by the display quad.
+inline int edgeMapSize(int size, const EdgeParams& params) {
+    return params.downscale > 1 ? size / params.downscale : size;
+}
+
+// Layout of the edge maps handed to the renderer
+enum EdgeFormat {
+    EDGE_FORMAT_RGBA = 0,    // CV_8UC4, 0/255 gray with opaque alpha
+    EDGE_FORMAT_GRAY = 1,    // CV_8UC1, 0/255 (GL_LUMINANCE upload, 4x smaller)
+    EDGE_FORMAT_PACKED = 2,  // 1 bit per pixel, see kCannyPackedBits (32x smaller)
+};
+
+// How a frame's stored pixels relate to what should be shown. Frames keep the
+// row order they were produced in and carry this instead of being flipped or
+// rotated; the display shader applies it for free, and only consumers that
+// need upright pixels (snapshots, export) pay for a copy via orientUpright.
+struct FrameOrientation {
+    int rotation = 0;       // Clockwise degrees to turn the frame for display (0, 90, 180, 270)
+    bool mirrored = false;  // Flip horizontally before rotating (front camera)
+    bool bottomUp = false;  // Rows stored bottom to top (OpenGL order)
+};
+
+// Pixel layouts of input frames
+enum FramePixelFormat {
+    FRAME_PIXEL_RGBA = 0,  // 4 bytes per pixel, as read back from the camera FBO
+    FRAME_PIXEL_NV21 = 1,  // Y plane followed by interleaved VU at half resolution
+    FRAME_PIXEL_LUMA = 2,  // Y plane only, e.g. of a YUV_420_888 Image
+};
+
+// Non-owning view of one input frame: a readback, a camera buffer or a frame
+// of a recording. Only the Y plane of NV21/LUMA frames is processed.
+struct FrameView {
+    const uchar* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int rowStride = 0;    // Bytes between rows (of the Y plane for NV21/LUMA)
+    int pixelStride = 1;  // Bytes between Y samples; RGBA frames are always 4
+    FramePixelFormat format = FRAME_PIXEL_RGBA;
+    int64_t timestampNanos = 0;
+    FrameOrientation orientation;
+};
+
+// Bytes `frame` spans from `data`, chroma included
+size_t frameViewBytes(const FrameView& frame);
+
+// Writes `src` as it would be displayed: top-down rows, mirrored and rotated
+// per `orientation`, in at most one transpose and one flip. `dst` may not alias `src`.
+void orientUpright(const cv::Mat& src, const FrameOrientation& orientation, cv::Mat& dst);
+
+// Bytes per row of a bit-packed edge map
+inline int packedEdgeCols(int width) {
+    return (width + 7) / 8;
+}
+
+// Helper function to process frame with Canny edge detection.
+// Takes an RGBA frame and returns the edge map expanded back to RGBA.
+cv::Mat processFrameWithCanny(const cv::Mat& input, const EdgeParams& params = EdgeParams());
+
+// Processes a still RGBA image (top-down rows, e.g. a Bitmap's pixels) into an
+// RGBA edge image matching processFrameWithCanny. Both live in caller-owned
+// memory and are wrapped, not copied: `output` is written in place. Strides
+// are in bytes; `output` may not overlap `input`.
+void processStillImage(const uchar* input, int width, int height, int inputStride,
+                       uchar* output, int outputStride, const EdgeParams& params = EdgeParams(),
+                       CannyWorkspace* workspace = nullptr);
+
+// Processes an RGBA frame as returned by glReadPixels (origin at bottom-left)
+// with the fused kernel. The result is in the same row order, so `output` can
+// be uploaded with glTexImage2D as-is, and matches flipping upright, running
+// processFrameWithCanny and flipping back. `output` may alias `readback`.
+// `format` selects the output layout; only RGBA matches processFrameWithCanny
+// byte for byte, the others carry the same edges in fewer bytes.
+void processReadbackFrame(const cv::Mat& readback, cv::Mat& output,
+                          const EdgeParams& params = EdgeParams(),
+                          CannyWorkspace* workspace = nullptr,
+                          EdgeFormat format = EDGE_FORMAT_RGBA);
+
+// Runs Canny directly on the luma plane of an NV21, I420 or YUV_420_888 camera
+// frame, reading it in place through its row and pixel strides. For NV21 and
+// I420 buffers the Y plane is the first `height` rows of `width` bytes. The
+// result is written in OpenGL row order, as 0/255 gray for a GL_LUMINANCE
+// upload unless `format` asks for RGBA or packed bits.
+void processLumaPlane(const uchar* y, int width, int height, int rowStride, int pixelStride,
+                      cv::Mat& edges, const EdgeParams& params = EdgeParams(),
+                      CannyWorkspace* workspace = nullptr,
+                      EdgeFormat format = EDGE_FORMAT_GRAY);
+
+// Runs whichever of the above fits `frame`: RGBA frames keep their stored row
+// order, luma planes come out in OpenGL row order. `edgesOrientation` is set to
+// how `edges` should be displayed. This is the single entry point the renderer
+// uses for camera, readback and replayed frames alike. With a downscale or
+// blur in `params`, the luma is shrunk (downscaleLuma's SIMD area average,
+// straight from the frame) and smoothed into the workspace first, and `edges`
+// is edgeMapSize() of the frame.
+void processFrameView(const FrameView& frame, cv::Mat& edges, FrameOrientation& edgesOrientation,
+                      const EdgeParams& params = EdgeParams(), CannyWorkspace* workspace = nullptr,
+                      EdgeFormat format = EDGE_FORMAT_GRAY);
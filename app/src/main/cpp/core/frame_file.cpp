@@ -0,0 +1,195 @@
+#include "frame_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+uint32_t packOrientation(const FrameOrientation& orientation) {
+    uint32_t rotation = static_cast<uint32_t>(((orientation.rotation % 360) + 360) % 360);
+    return rotation | (orientation.mirrored ? kFrameMirrored : 0) | (orientation.bottomUp ? kFrameBottomUp : 0);
+}
+
+FrameOrientation unpackOrientation(uint32_t packed) {
+    FrameOrientation orientation;
+    orientation.rotation = static_cast<int>(packed & 0xFFFF);
+    orientation.mirrored = (packed & kFrameMirrored) != 0;
+    orientation.bottomUp = (packed & kFrameBottomUp) != 0;
+    return orientation;
+}
+
+uint64_t alignToPage(uint64_t offset) {
+    return (offset + kFramePageSize - 1) / kFramePageSize * kFramePageSize;
+}
+
+FrameView entryView(const FrameIndexEntry& entry, const uchar* payload) {
+    FrameView frame;
+    frame.data = payload;
+    frame.width = static_cast<int>(entry.width);
+    frame.height = static_cast<int>(entry.height);
+    frame.rowStride = static_cast<int>(entry.rowStride);
+    frame.pixelStride = static_cast<int>(entry.pixelStride);
+    frame.format = static_cast<FramePixelFormat>(entry.format);
+    frame.timestampNanos = entry.timestampNanos;
+    frame.orientation = unpackOrientation(entry.orientation);
+    return frame;
+}
+
+// Helper function to check that an entry describes a frame lying inside the file
+bool entryValid(const FrameIndexEntry& entry, size_t fileSize) {
+    if (entry.format > FRAME_PIXEL_LUMA || entry.width == 0 || entry.height == 0 ||
+        entry.width > 1u << 15 || entry.height > 1u << 15 || entry.rowStride > 1u << 20 ||
+        entry.pixelStride > 16 || entry.offset % kFramePageSize != 0 ||
+        entry.offset > fileSize || entry.payloadBytes > fileSize - entry.offset) {
+        return false;
+    }
+    return frameViewBytes(entryView(entry, nullptr)) <= entry.payloadBytes;
+}
+
+bool writeAt(int fd, const void* data, size_t bytes, uint64_t offset) {
+    const char* bytesLeft = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = pwrite(fd, bytesLeft, bytes, static_cast<off_t>(offset));
+        if (written <= 0) {
+            return false;
+        }
+        bytesLeft += written;
+        bytes -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+}  // namespace
+
+bool frameFileCreate(FrameFileWriter& writer, const char* path, int maxFrames) {
+    writer = FrameFileWriter();
+    if (maxFrames <= 0) {
+        return false;
+    }
+    writer.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer.fd < 0) {
+        return false;
+    }
+    writer.indexCapacity = static_cast<uint32_t>(maxFrames);
+    writer.end = alignToPage(sizeof(FrameFileHeader) + static_cast<uint64_t>(maxFrames) * sizeof(FrameIndexEntry));
+
+    FrameFileHeader header = {};
+    std::memcpy(header.magic, kFrameFileMagic, sizeof(header.magic));
+    header.version = kFrameFileVersion;
+    header.headerBytes = sizeof(FrameFileHeader);
+    header.entryBytes = sizeof(FrameIndexEntry);
+    header.indexCapacity = writer.indexCapacity;
+    header.frameCount = 0;
+    header.pageSize = kFramePageSize;
+    // Extending to the first payload leaves the unused index entries zeroed
+    if (!writeAt(writer.fd, &header, sizeof(header), 0) || ftruncate(writer.fd, static_cast<off_t>(writer.end)) != 0) {
+        frameFileClose(writer);
+        return false;
+    }
+    return true;
+}
+
+bool frameFileAppend(FrameFileWriter& writer, const FrameView& frame) {
+    if (writer.fd < 0 || writer.frames == writer.indexCapacity) {
+        return false;
+    }
+    FrameIndexEntry entry = {};
+    entry.offset = writer.end;
+    entry.payloadBytes = frameViewBytes(frame);
+    entry.timestampNanos = frame.timestampNanos;
+    entry.format = frame.format;
+    entry.width = frame.width;
+    entry.height = frame.height;
+    entry.rowStride = frame.rowStride;
+    entry.pixelStride = frame.pixelStride;
+    entry.orientation = packOrientation(frame.orientation);
+
+    // Payload, then its index entry, then the count that makes it visible
+    uint32_t frameCount = writer.frames + 1;
+    if (!writeAt(writer.fd, frame.data, entry.payloadBytes, entry.offset) ||
+        !writeAt(writer.fd, &entry, sizeof(entry), sizeof(FrameFileHeader) + writer.frames * sizeof(FrameIndexEntry)) ||
+        !writeAt(writer.fd, &frameCount, sizeof(frameCount), offsetof(FrameFileHeader, frameCount))) {
+        return false;
+    }
+    writer.frames = frameCount;
+    writer.end = alignToPage(entry.offset + entry.payloadBytes);
+    return true;
+}
+
+void frameFileClose(FrameFileWriter& writer) {
+    if (writer.fd >= 0) {
+        // Pad the last payload to a whole page so every payload can be mapped on its own
+        if (ftruncate(writer.fd, static_cast<off_t>(writer.end)) != 0) {
+            // The frames are complete either way; only the padding is missing
+        }
+        close(writer.fd);
+    }
+    writer = FrameFileWriter();
+}
+
+bool frameFileOpen(FrameFile& file, const char* path) {
+    frameFileClose(file);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(FrameFileHeader))) {
+        // Private and writable: Mats over the mapping may be written, copy on write
+        mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);  // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    file.data = static_cast<uchar*>(mapping);
+    file.size = static_cast<size_t>(info.st_size);
+
+    FrameFileHeader header;
+    std::memcpy(&header, file.data, sizeof(header));
+    uint64_t indexEnd = sizeof(FrameFileHeader) + static_cast<uint64_t>(header.indexCapacity) * sizeof(FrameIndexEntry);
+    if (std::memcmp(header.magic, kFrameFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != kFrameFileVersion || header.headerBytes != sizeof(FrameFileHeader) ||
+        header.entryBytes != sizeof(FrameIndexEntry) || header.pageSize != kFramePageSize ||
+        header.frameCount > header.indexCapacity || indexEnd > file.size) {
+        frameFileClose(file);
+        return false;
+    }
+    file.index = reinterpret_cast<const FrameIndexEntry*>(file.data + sizeof(FrameFileHeader));
+
+    int count = 0;
+    while (count < static_cast<int>(header.frameCount) && entryValid(file.index[count], file.size)) {
+        count++;
+    }
+    file.frameCount = count;
+    return true;
+}
+
+void frameFileClose(FrameFile& file) {
+    if (file.data != nullptr) {
+        munmap(file.data, file.size);
+    }
+    file = FrameFile();
+}
+
+FrameView frameFileFrame(const FrameFile& file, int index) {
+    const FrameIndexEntry& entry = file.index[index];
+    return entryView(entry, file.data + entry.offset);
+}
+
+cv::Mat frameFileMat(const FrameFile& file, int index) {
+    const FrameIndexEntry& entry = file.index[index];
+    uchar* payload = file.data + entry.offset;
+    if (entry.format == FRAME_PIXEL_RGBA) {
+        return cv::Mat(entry.height, entry.width, CV_8UC4, payload, entry.rowStride);
+    }
+    CV_Assert(entry.pixelStride == 1);
+    return cv::Mat(entry.height, entry.width, CV_8UC1, payload, entry.rowStride);
+}
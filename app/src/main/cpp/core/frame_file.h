@@ -0,0 +1,94 @@
+#pragma once
+
+#include "edge_pipeline.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+
+// Recording of input frames, replayed through the pipeline by FileFrameSource.
+//
+// Layout, all little endian:
+//   FrameFileHeader
+//   FrameIndexEntry[indexCapacity]   one per frame, in recording order
+//   payloads                         each starting on a kFramePageSize boundary
+//
+// A payload holds a frame's pixels laid out exactly as its FrameView (rows
+// rowStride apart, NV21 chroma after the Y plane). The index has a fixed
+// size chosen when the file is created, so appending never moves anything:
+// the writer puts the payload at the end, fills in the frame's index entry,
+// then bumps frameCount in the header. A recording cut short therefore stays
+// readable up to its last complete frame.
+//
+// Readers map the file and find frame i at index[i] in O(1); frames come back
+// as views into the mapping without copying, and page-aligned payloads map
+// straight into memory.
+struct FrameFileHeader {
+    char magic[8];           // kFrameFileMagic
+    uint32_t version;        // kFrameFileVersion
+    uint32_t headerBytes;    // sizeof(FrameFileHeader)
+    uint32_t entryBytes;     // sizeof(FrameIndexEntry)
+    uint32_t indexCapacity;  // Entries reserved after the header
+    uint32_t frameCount;     // Entries filled in
+    uint32_t pageSize;       // Payload alignment
+};
+
+struct FrameIndexEntry {
+    uint64_t offset;         // Of the payload, from the start of the file
+    uint64_t payloadBytes;
+    int64_t timestampNanos;  // monotonicNanos() when the frame was recorded
+    uint32_t format;         // FramePixelFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowStride;
+    uint32_t pixelStride;
+    uint32_t orientation;    // Rotation in degrees | kFrameMirrored | kFrameBottomUp
+};
+
+const char kFrameFileMagic[8] = {'E', 'D', 'G', 'E', 'F', 'R', 'M', 'S'};
+const uint32_t kFrameFileVersion = 2;
+const uint32_t kFramePageSize = 4096;
+const uint32_t kFrameMirrored = 1u << 16;
+const uint32_t kFrameBottomUp = 1u << 17;
+
+struct FrameFileWriter {
+    int fd = -1;
+    uint32_t indexCapacity = 0;
+    uint32_t frames = 0;
+    uint64_t end = 0;  // Where the next payload goes
+};
+
+// Creates `path` with room for `maxFrames` frames. Returns false on error.
+bool frameFileCreate(FrameFileWriter& writer, const char* path, int maxFrames);
+
+// Appends one frame. Returns false once the index is full or on a write error.
+bool frameFileAppend(FrameFileWriter& writer, const FrameView& frame);
+
+void frameFileClose(FrameFileWriter& writer);
+
+// Mapping of a recording
+struct FrameFile {
+    uchar* data = nullptr;
+    size_t size = 0;
+    const FrameIndexEntry* index = nullptr;
+    int frameCount = 0;  // Complete frames
+};
+
+// Maps `path`. Frames whose payload lies outside the file or doesn't fit
+// their size and strides end the recording there. Returns false if the file
+// can't be read or isn't a recording.
+bool frameFileOpen(FrameFile& file, const char* path);
+
+void frameFileClose(FrameFile& file);
+
+inline int frameFileCount(const FrameFile& file) {
+    return file.frameCount;
+}
+
+// View of frame `index`, pointing into the mapping
+FrameView frameFileFrame(const FrameFile& file, int index);
+
+// Frame `index` as a cv::Mat header over the mapping: CV_8UC4 for RGBA
+// frames, the CV_8UC1 Y plane for NV21/luma frames with a pixel stride of 1.
+// The mapping is private, so writing to the Mat never changes the file.
+cv::Mat frameFileMat(const FrameFile& file, int index);
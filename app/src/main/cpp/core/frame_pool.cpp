@@ -0,0 +1,113 @@
+#include "frame_pool.h"
+
+#include <cstring>
+
+FramePool::~FramePool() {
+    for (cv::UMatData* u : freeBuffers) {
+        cv::fastFree(u->origdata);
+        delete u;
+    }
+}
+
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                  cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    // Same step computation as OpenCV's default allocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step != nullptr) {
+            if (data != nullptr && step[i] != cv::Mat::AUTO_STEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    if (data == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = freeBuffers.begin(); it != freeBuffers.end(); ++it) {
+            if ((*it)->size == total) {
+                cv::UMatData* u = *it;
+                freeBuffers.erase(it);
+                return u;
+            }
+        }
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    if (data != nullptr) {
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    } else {
+        u->data = u->origdata = static_cast<uchar*>(cv::fastMalloc(total));
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    u->size = total;
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData* data, cv::AccessFlag /*accessFlags*/,
+                         cv::UMatUsageFlags /*usageFlags*/) const {
+    return data != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData* u) const {
+    if (u == nullptr) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0 && u->refcount == 0);
+
+    if ((u->flags & cv::UMatData::USER_ALLOCATED) != 0) {
+        delete u;
+        return;
+    }
+
+    cv::UMatData* evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // The vector never grows past its reserved size, so this never allocates
+        if (freeBuffers.capacity() < kMaxFreeBuffers + 1) {
+            freeBuffers.reserve(kMaxFreeBuffers + 1);
+        }
+        freeBuffers.push_back(u);
+        if (freeBuffers.size() > kMaxFreeBuffers) {
+            evicted = freeBuffers.front();
+            freeBuffers.erase(freeBuffers.begin());
+        }
+    }
+    if (evicted != nullptr) {
+        cv::fastFree(evicted->origdata);
+        delete evicted;
+    }
+}
+
+bool fillFrame(cv::Mat& frame, const void* data, int rows, int cols, int type) {
+    const uchar* bytes = static_cast<const uchar*>(data);
+    if (frame.data != nullptr && bytes >= frame.datastart && bytes < frame.dataend) {
+        return bytes == frame.data && frame.rows == rows && frame.cols == cols && frame.type() == type &&
+               frame.isContinuous();
+    }
+    frame.create(rows, cols, type);  // From the pool, and only on a size change
+    std::memcpy(frame.data, bytes, frame.total() * frame.elemSize());
+    return true;
+}
+
+void lendFrame(LentFrames& lent, const cv::Mat& frame) {
+    for (const cv::Mat& lentFrame : lent.frames) {
+        if (lentFrame.data == frame.data) {
+            return;
+        }
+    }
+    lent.frames.push_back(frame);
+}
+
+void returnFrame(LentFrames& lent, const void* data) {
+    for (size_t i = 0; i < lent.frames.size(); i++) {
+        if (lent.frames[i].data == data) {
+            lent.frames.erase(lent.frames.begin() + static_cast<ptrdiff_t>(i));
+            return;
+        }
+    }
+}
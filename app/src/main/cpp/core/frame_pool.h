@@ -0,0 +1,72 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Size-keyed pool of frame buffers, usable as a cv::MatAllocator.
+//
+// Point the allocator of long-lived Mats at the pool (`mat.allocator = &pool`)
+// and their buffers come from it. A buffer released by such a Mat goes back
+// into the pool, together with its cv::UMatData, and the next allocation of
+// the same byte size gets it back. A steady stream of frames therefore does
+// no heap allocation, even when Mats are released and recreated or the edge
+// format switches back and forth.
+//
+// Thread-safe. The pool must outlive every Mat that uses it.
+class FramePool : public cv::MatAllocator {
+public:
+    // Buffers kept for reuse; older ones are freed beyond this
+    static constexpr size_t kMaxFreeBuffers = 8;
+
+    FramePool() = default;
+    ~FramePool() override;
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    // Buffers taken from the heap so far. Constant once processing has warmed
+    // up; this is the per-frame allocation hook for benchmarks and stats.
+    int allocations() const {
+        return allocationCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::mutex mutex;
+    mutable std::vector<cv::UMatData*> freeBuffers;  // Oldest first
+    mutable std::atomic<int> allocationCount{0};
+};
+
+// Helper function to make `mat` (and whatever it is recreated as) allocate from `pool`
+inline void useFramePool(cv::Mat& mat, FramePool& pool) {
+    mat.allocator = &pool;
+}
+
+// Makes `frame` a rows x cols Mat of `type` holding the tightly packed bytes
+// at `data`. `data` may point into `frame`'s own buffer, e.g. one handed out
+// to be filled in place: it is then taken as is, without a copy, but only at
+// `frame`'s current size and type, since recreating `frame` would free the
+// memory being read. Returns false, leaving `frame` alone, if they differ.
+bool fillFrame(cv::Mat& frame, const void* data, int rows, int cols, int type);
+
+// Frame buffers lent out to be filled in place, e.g. as direct ByteBuffers
+// over a Mat's memory. Each stays allocated while lent, even if the Mat it
+// came from is recreated at another size in the meantime, so the borrower
+// never writes into freed memory. Not thread-safe.
+struct LentFrames {
+    std::vector<cv::Mat> frames;  // Headers sharing the lent buffers
+};
+
+// Lends `frame`'s buffer, unless it is lent already
+void lendFrame(LentFrames& lent, const cv::Mat& frame);
+
+// Ends the loan of the buffer starting at `data`, if any. Its memory is
+// freed (or pooled) once no Mat uses it any more.
+void returnFrame(LentFrames& lent, const void* data);
@@ -0,0 +1,100 @@
+#include "frame_recorder.h"
+
+#include "stage_stats.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstring>
+
+FrameRecorder::~FrameRecorder() {
+    stop();
+}
+
+bool FrameRecorder::start(const std::string& path, int maxFrames) {
+    stop();
+    if (!frameFileCreate(writer, path.c_str(), maxFrames)) {
+        return false;
+    }
+    writtenCount.store(0, std::memory_order_relaxed);
+    droppedCount.store(0, std::memory_order_relaxed);
+    stopping.store(false, std::memory_order_relaxed);
+    writerThread = std::thread(&FrameRecorder::writerLoop, this);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void FrameRecorder::stop() {
+    {
+        // Waits out a submit in progress; later ones see the recorder inactive
+        std::lock_guard<std::mutex> lock(submitMutex);
+        active.store(false, std::memory_order_relaxed);
+    }
+    if (writerThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping.store(true, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+        writerThread.join();
+    }
+    frameFileClose(writer);
+}
+
+bool FrameRecorder::submit(const FrameView& frame) {
+    if (!active.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(submitMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!active.load(std::memory_order_relaxed)) {
+        return false;  // Stopped since the check above
+    }
+    Slot* queued = queue.beginWrite();
+    if (queued == nullptr) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);  // Every slot still waits for the disk
+        return false;
+    }
+
+    Slot& slot = *queued;
+    size_t bytes = frameViewBytes(frame);
+    if (slot.bytes.size() < bytes) {
+        slot.bytes.resize(bytes);
+    }
+    std::memcpy(slot.bytes.data(), frame.data, bytes);
+    slot.frame = frame;
+    slot.frame.data = slot.bytes.data();
+    queue.endWrite();
+    // Notifying without the wake mutex keeps submit lock-free for the writer;
+    // a wakeup lost to the race is caught by the writer's timed wait
+    wake.notify_one();
+    return true;
+}
+
+void FrameRecorder::writerLoop() {
+    traceSetThreadName("frame_recorder");
+    while (true) {
+        Slot* slot = queue.beginRead();
+        if (slot == nullptr) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                break;  // Queue drained
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10), [this] {
+                return stopping.load(std::memory_order_relaxed) || queue.beginRead() != nullptr;
+            });
+            continue;
+        }
+
+        int64_t start = monotonicNanos();
+        if (frameFileAppend(writer, slot->frame)) {
+            writtenCount.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);  // Index full or disk error
+        }
+        traceSpan("record_frame", start, monotonicNanos());
+        queue.endRead();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "edge_pipeline.h"
+#include "frame_file.h"
+#include "frame_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records the frames going through the pipeline to a recording (frame_file.h)
+// without slowing down the threads that produce them.
+//
+// submit() copies the frame into a slot of a bounded FrameRing and returns;
+// a background thread writes the slots out. When every slot is still waiting
+// for the disk, or another thread is submitting at the same moment, the frame
+// is dropped and counted instead of waiting. Once the slots have grown to the
+// frame size, submitting doesn't allocate.
+class FrameRecorder {
+public:
+    // Frames that can wait for the disk before new ones are dropped
+    static constexpr int kQueueDepth = 4;
+
+    FrameRecorder() = default;
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Starts recording to `path`, with room for `maxFrames` frames; frames
+    // past that are dropped. Stops a recording already in progress first.
+    bool start(const std::string& path, int maxFrames);
+
+    // Writes out the frames still queued and closes the file
+    void stop();
+
+    // Queues `frame` for writing. Never blocks. Returns false if the frame
+    // was dropped or nothing is being recorded.
+    bool submit(const FrameView& frame);
+
+    bool recording() const {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // Of the current or last recording
+    int framesWritten() const {
+        return writtenCount.load(std::memory_order_relaxed);
+    }
+    int framesDropped() const {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::vector<uchar> bytes;
+        FrameView frame;  // data points into bytes
+    };
+
+    void writerLoop();
+
+    FrameFileWriter writer;
+    FrameRing<Slot> queue{FRAME_RING_BOUNDED, kQueueDepth};  // Submitter -> writer thread
+
+    std::mutex submitMutex;  // One submitter at a time; contenders drop their frame
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread writerThread;
+    std::atomic<bool> active{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<int> writtenCount{0};
+    std::atomic<int> droppedCount{0};
+};
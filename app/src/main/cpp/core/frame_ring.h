@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// What a FrameRing does when frames arrive faster than they are consumed
+enum FrameRingPolicy {
+    // Live input: a frame that hasn't been consumed yet is replaced by the
+    // next one (counted as overwritten), and the consumer always gets the
+    // newest. Uses three slots whatever the capacity.
+    FRAME_RING_LATEST_WINS = 0,
+    // Every frame matters (recording): frames are consumed in order, and a
+    // frame arriving while all slots are queued is refused (counted as dropped).
+    FRAME_RING_BOUNDED = 1,
+};
+
+// Frame counts of a FrameRing since it was created
+struct FrameRingCounters {
+    uint64_t published;    // Frames handed over by the producer
+    uint64_t consumed;     // Frames handed to the consumer
+    uint64_t overwritten;  // Published but replaced before the consumer got them (latest-wins)
+    uint64_t dropped;      // Refused because the ring was full (bounded)
+};
+
+// Lock-free single-producer/single-consumer ring of preallocated frame slots.
+//
+// Slots are filled and read in place, so frames are never copied and, once
+// their buffers have grown, never allocated. Neither side ever waits:
+//
+//   producer:  if (T* slot = ring.beginWrite()) { fill *slot; ring.endWrite(); }
+//   consumer:  if (T* slot = ring.beginRead()) { use *slot; ring.endRead(); }
+//
+// The producer's slot is its own until endWrite and the consumer's until
+// endRead (latest-wins: until the next beginRead), whatever the other side
+// does meanwhile. Latest-wins swaps slots through one shared atomic, like
+// TripleBuffer; bounded is a classic head/tail queue.
+template <typename T>
+class FrameRing {
+public:
+    explicit FrameRing(FrameRingPolicy policy = FRAME_RING_LATEST_WINS, int capacity = 3)
+        : ringPolicy(policy), slots(policy == FRAME_RING_LATEST_WINS ? 3 : (capacity > 0 ? capacity : 1)) {}
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Producer side. Returns the slot to fill, or null (and counts a drop)
+    // when a bounded ring is full.
+    T* beginWrite() {
+        if (ringPolicy == FRAME_RING_LATEST_WINS) {
+            return &slots[backIndex];
+        }
+        uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == slots.size()) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[tail % slots.size()];
+    }
+
+    // Publishes the slot returned by beginWrite
+    void endWrite() {
+        publishedCount.fetch_add(1, std::memory_order_relaxed);
+        if (ringPolicy == FRAME_RING_LATEST_WINS) {
+            int previous = middle.exchange(backIndex | kFresh, std::memory_order_acq_rel);
+            if (previous & kFresh) {
+                overwrittenCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            backIndex = previous & kIndexMask;
+            return;
+        }
+        tailIndex.store(tailIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Index of the slot beginWrite returns, for state kept per slot (e.g. a
+    // Java buffer over its memory). Producer side.
+    int writeSlot() const {
+        if (ringPolicy == FRAME_RING_LATEST_WINS) {
+            return backIndex;
+        }
+        return static_cast<int>(tailIndex.load(std::memory_order_relaxed) % slots.size());
+    }
+
+    // Consumer side. Returns the next frame (latest-wins: the newest one), or
+    // null if nothing new was published.
+    T* beginRead() {
+        if (ringPolicy == FRAME_RING_LATEST_WINS) {
+            if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) {
+                return nullptr;
+            }
+            int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & kIndexMask;
+            consumedCount.fetch_add(1, std::memory_order_relaxed);
+            return &slots[frontIndex];
+        }
+        uint32_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[head % slots.size()];
+    }
+
+    // Hands the slot returned by beginRead back to the producer
+    void endRead() {
+        if (ringPolicy == FRAME_RING_LATEST_WINS) {
+            return;  // The slot is swapped out by the next beginRead
+        }
+        consumedCount.fetch_add(1, std::memory_order_relaxed);
+        headIndex.store(headIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    FrameRingCounters counters() const {
+        FrameRingCounters counters;
+        counters.published = publishedCount.load(std::memory_order_relaxed);
+        counters.consumed = consumedCount.load(std::memory_order_relaxed);
+        counters.overwritten = overwrittenCount.load(std::memory_order_relaxed);
+        counters.dropped = droppedCount.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+    FrameRingPolicy policy() const {
+        return ringPolicy;
+    }
+
+    // Every slot, e.g. to point their Mats at a FramePool before use
+    int slotCount() const {
+        return static_cast<int>(slots.size());
+    }
+    T& slot(int index) {
+        return slots[index];
+    }
+
+private:
+    static constexpr int kIndexMask = 3;
+    static constexpr int kFresh = 4;  // Middle slot holds an unconsumed frame
+
+    const FrameRingPolicy ringPolicy;
+    std::vector<T> slots;
+
+    // Latest-wins
+    std::atomic<int> middle{1};
+    int backIndex = 2;   // Owned by the producer
+    int frontIndex = 0;  // Owned by the consumer
+
+    // Bounded: slots [head, tail) are queued
+    std::atomic<uint32_t> headIndex{0};
+    std::atomic<uint32_t> tailIndex{0};
+
+    std::atomic<uint64_t> publishedCount{0};
+    std::atomic<uint64_t> consumedCount{0};
+    std::atomic<uint64_t> overwrittenCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+};
@@ -0,0 +1,51 @@
+#include "frame_source.h"
+
+#include "stage_stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+FileFrameSource::~FileFrameSource() {
+    frameFileClose(file);
+}
+
+bool FileFrameSource::open(const std::string& path, bool loop) {
+    index = 0;
+    this->loop = loop;
+    return frameFileOpen(file, path.c_str()) && frameFileCount(file) > 0;
+}
+
+bool FileFrameSource::next(FrameView& frame) {
+    if (index == frameFileCount(file)) {
+        if (!loop || index == 0) {
+            return false;
+        }
+        index = 0;
+    }
+    frame = frameFileFrame(file, index++);
+    return true;
+}
+
+void FileFrameSource::seek(int index) {
+    this->index = std::max(0, std::min(index, frameFileCount(file)));
+}
+
+bool PacedFrameSource::next(FrameView& frame) {
+    if (!source.next(frame)) {
+        return false;
+    }
+    int64_t now = monotonicNanos();
+    if (!started || frame.timestampNanos < lastTimestamp) {
+        started = true;
+        firstTimestamp = frame.timestampNanos;
+        startNanos = now;
+    }
+    lastTimestamp = frame.timestampNanos;
+
+    int64_t due = startNanos + (frame.timestampNanos - firstTimestamp);
+    if (due > now) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "edge_pipeline.h"
+#include "frame_file.h"
+
+#include <string>
+
+// Where input frames come from. The renderer gets them from the camera;
+// tools get them from a recording, so a scene captured once can be pushed
+// through the same processing as often as needed.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Fills `frame` with the next frame, valid until the next call or until
+    // the source is destroyed. Returns false when there are no more frames.
+    virtual bool next(FrameView& frame) = 0;
+};
+
+// Replays a recording (frame_file.h) frame by frame, zero-copy from its
+// mapping, optionally starting over at the end
+class FileFrameSource : public FrameSource {
+public:
+    FileFrameSource() = default;
+    ~FileFrameSource() override;
+
+    FileFrameSource(const FileFrameSource&) = delete;
+    FileFrameSource& operator=(const FileFrameSource&) = delete;
+
+    bool open(const std::string& path, bool loop = false);
+    bool next(FrameView& frame) override;
+
+    // Continues from frame `index` (clamped to the recording); O(1) through the index
+    void seek(int index);
+
+    int frameCount() const {
+        return frameFileCount(file);
+    }
+
+private:
+    FrameFile file;
+    int index = 0;
+    bool loop = false;
+};
+
+// Delivers another source's frames at the pace they were recorded: next()
+// sleeps until the frame's timestamp, relative to the first frame, has come
+// around. Timestamps going backwards (a looping source) restart the clock.
+class PacedFrameSource : public FrameSource {
+public:
+    explicit PacedFrameSource(FrameSource& source) : source(source) {}
+
+    bool next(FrameView& frame) override;
+
+private:
+    FrameSource& source;
+    bool started = false;
+    int64_t firstTimestamp = 0;
+    int64_t startNanos = 0;
+    int64_t lastTimestamp = 0;
+};
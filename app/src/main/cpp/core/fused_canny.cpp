@@ -0,0 +1,658 @@
+#include "fused_canny.h"
+
+#include "stage_stats.h"
+#include "trace.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+using namespace cv;
+
+// Fixed-point direction test from cv::Canny: tan(22.5 deg) * 2^15
+const int kCannyShift = 15;
+const int kTg22 = 13573;
+
+// Edge map values, same convention as cv::Canny
+const uchar kMaybeEdge = 0;
+const uchar kNoEdge = 1;
+const uchar kEdge = 2;
+
+// Fixed-point luma weights used by cv::cvtColor(COLOR_RGBA2GRAY)
+const int kLumaShift = 14;
+const int kR2Y = 4899;
+const int kG2Y = 9617;
+const int kB2Y = 1868;
+
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+inline v_uint16 lumaU16(const v_uint16& r, const v_uint16& g, const v_uint16& b) {
+    const v_uint32 cr = vx_setall_u32(kR2Y);
+    const v_uint32 cg = vx_setall_u32(kG2Y);
+    const v_uint32 cb = vx_setall_u32(kB2Y);
+    const v_uint32 half = vx_setall_u32(1 << (kLumaShift - 1));
+
+    v_uint32 r0, r1, g0, g1, b0, b1;
+    v_expand(r, r0, r1);
+    v_expand(g, g0, g1);
+    v_expand(b, b0, b1);
+    v_uint32 y0 = v_add(v_add(v_mul(r0, cr), v_mul(g0, cg)), v_add(v_mul(b0, cb), half));
+    v_uint32 y1 = v_add(v_add(v_mul(r1, cr), v_mul(g1, cg)), v_add(v_mul(b1, cb), half));
+    return v_pack(v_shr<kLumaShift>(y0), v_shr<kLumaShift>(y1));
+}
+#endif
+
+// Converts one input row to luma and replicates the border pixels. Single
+// channel input is a luma plane whose samples are `pixelStride` bytes apart.
+void lumaRow(const uchar* src, int cn, int pixelStride, int width, uchar* dst) {
+    if (cn == 1 && pixelStride == 1) {
+        std::memcpy(dst, src, width);
+    } else if (cn == 1) {
+        for (int x = 0; x < width; x++) {
+            dst[x] = src[x * pixelStride];
+        }
+    } else {
+        int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+        const int lanes = VTraits<v_uint8>::vlanes();
+        for (; x <= width - lanes; x += lanes) {
+            v_uint8 r, g, b, a;
+            v_load_deinterleave(src + x * 4, r, g, b, a);
+            v_uint16 r0, r1, g0, g1, b0, b1;
+            v_expand(r, r0, r1);
+            v_expand(g, g0, g1);
+            v_expand(b, b0, b1);
+            v_store(dst + x, v_pack(lumaU16(r0, g0, b0), lumaU16(r1, g1, b1)));
+        }
+#endif
+        for (; x < width; x++) {
+            const uchar* p = src + x * 4;
+            dst[x] = static_cast<uchar>((p[0] * kR2Y + p[1] * kG2Y + p[2] * kB2Y +
+                                         (1 << (kLumaShift - 1))) >> kLumaShift);
+        }
+    }
+    dst[-1] = dst[0];
+    dst[width] = dst[width - 1];
+}
+
+// 3x3 Sobel on three padded luma rows (above, center, below) plus L1 magnitude
+void sobelRow(const uchar* a, const uchar* b, const uchar* c, int width,
+              short* dx, short* dy, ushort* mag) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_int16>::vlanes();
+    for (; x <= width - lanes; x += lanes) {
+        v_int16 a0 = v_reinterpret_as_s16(vx_load_expand(a + x - 1));
+        v_int16 a1 = v_reinterpret_as_s16(vx_load_expand(a + x));
+        v_int16 a2 = v_reinterpret_as_s16(vx_load_expand(a + x + 1));
+        v_int16 b0 = v_reinterpret_as_s16(vx_load_expand(b + x - 1));
+        v_int16 b2 = v_reinterpret_as_s16(vx_load_expand(b + x + 1));
+        v_int16 c0 = v_reinterpret_as_s16(vx_load_expand(c + x - 1));
+        v_int16 c1 = v_reinterpret_as_s16(vx_load_expand(c + x));
+        v_int16 c2 = v_reinterpret_as_s16(vx_load_expand(c + x + 1));
+
+        v_int16 gx = v_add(v_add(v_sub(a2, a0), v_sub(c2, c0)), v_shl<1>(v_sub(b2, b0)));
+        v_int16 gy = v_sub(v_add(v_add(c0, c2), v_shl<1>(c1)), v_add(v_add(a0, a2), v_shl<1>(a1)));
+        v_store(dx + x, gx);
+        v_store(dy + x, gy);
+        v_store(mag + x, v_add(v_abs(gx), v_abs(gy)));
+    }
+#endif
+    for (; x < width; x++) {
+        int gx = (a[x + 1] - a[x - 1]) + 2 * (b[x + 1] - b[x - 1]) + (c[x + 1] - c[x - 1]);
+        int gy = (c[x - 1] + 2 * c[x] + c[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+        dx[x] = static_cast<short>(gx);
+        dy[x] = static_cast<short>(gy);
+        mag[x] = static_cast<ushort>(std::abs(gx) + std::abs(gy));
+    }
+    mag[-1] = 0;
+    mag[width] = 0;
+}
+
+// Same Sobel with the squared L2 magnitude, as cv::Canny computes it with L2gradient
+void sobelRow(const uchar* a, const uchar* b, const uchar* c, int width,
+              short* dx, short* dy, int* mag) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_int16>::vlanes();
+    for (; x <= width - lanes; x += lanes) {
+        v_int16 a0 = v_reinterpret_as_s16(vx_load_expand(a + x - 1));
+        v_int16 a1 = v_reinterpret_as_s16(vx_load_expand(a + x));
+        v_int16 a2 = v_reinterpret_as_s16(vx_load_expand(a + x + 1));
+        v_int16 b0 = v_reinterpret_as_s16(vx_load_expand(b + x - 1));
+        v_int16 b2 = v_reinterpret_as_s16(vx_load_expand(b + x + 1));
+        v_int16 c0 = v_reinterpret_as_s16(vx_load_expand(c + x - 1));
+        v_int16 c1 = v_reinterpret_as_s16(vx_load_expand(c + x));
+        v_int16 c2 = v_reinterpret_as_s16(vx_load_expand(c + x + 1));
+
+        v_int16 gx = v_add(v_add(v_sub(a2, a0), v_sub(c2, c0)), v_shl<1>(v_sub(b2, b0)));
+        v_int16 gy = v_sub(v_add(v_add(c0, c2), v_shl<1>(c1)), v_add(v_add(a0, a2), v_shl<1>(a1)));
+        v_store(dx + x, gx);
+        v_store(dy + x, gy);
+
+        v_int32 gx0, gx1, gy0, gy1;
+        v_expand(gx, gx0, gx1);
+        v_expand(gy, gy0, gy1);
+        v_store(mag + x, v_add(v_mul(gx0, gx0), v_mul(gy0, gy0)));
+        v_store(mag + x + lanes / 2, v_add(v_mul(gx1, gx1), v_mul(gy1, gy1)));
+    }
+#endif
+    for (; x < width; x++) {
+        int gx = (a[x + 1] - a[x - 1]) + 2 * (b[x + 1] - b[x - 1]) + (c[x + 1] - c[x - 1]);
+        int gy = (c[x - 1] + 2 * c[x] + c[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+        dx[x] = static_cast<short>(gx);
+        dy[x] = static_cast<short>(gy);
+        mag[x] = gx * gx + gy * gy;
+    }
+    mag[-1] = 0;
+    mag[width] = 0;
+}
+
+// Non-max suppression for a single pixel, using the same comparisons as
+// cv::Canny. `Mag` is ushort for L1 magnitudes and int for squared L2 ones.
+template <typename Mag>
+inline void nmsPixel(int j, const Mag* magP, const Mag* magA, const Mag* magN,
+                     const short* dx, const short* dy, int low, int high,
+                     uchar* map, std::vector<uchar*>& stack) {
+    int m = magA[j];
+    if (m <= low) {
+        return;
+    }
+
+    short xs = dx[j];
+    short ys = dy[j];
+    int x = std::abs(xs);
+    int y = std::abs(ys) << kCannyShift;
+    int tg22x = x * kTg22;
+
+    bool isMax;
+    if (y < tg22x) {
+        isMax = m > magA[j - 1] && m >= magA[j + 1];
+    } else {
+        int tg67x = tg22x + (x << (kCannyShift + 1));
+        if (y > tg67x) {
+            isMax = m > magP[j] && m >= magN[j];
+        } else {
+            int s = (xs ^ ys) < 0 ? -1 : 1;
+            isMax = m > magP[j - s] && m > magN[j + s];
+        }
+    }
+
+    if (!isMax) {
+        return;
+    }
+    if (m > high) {
+        map[j] = kEdge;
+        stack.push_back(map + j);
+    } else {
+        map[j] = kMaybeEdge;
+    }
+}
+
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+// Whether any of the vector of magnitudes at `mag` exceeds `low`, for each magnitude type
+inline int magLanes(const ushort*) {
+    return VTraits<v_uint16>::vlanes();
+}
+
+inline bool anyAboveLow(const ushort* mag, int low) {
+    return v_check_any(v_gt(vx_load(mag), vx_setall_u16(static_cast<ushort>(std::min(low, 65535)))));
+}
+
+inline int magLanes(const int*) {
+    return VTraits<v_int32>::vlanes();
+}
+
+inline bool anyAboveLow(const int* mag, int low) {
+    return v_check_any(v_gt(vx_load(mag), vx_setall_s32(low)));
+}
+#endif
+
+// Classifies one row of the edge map. `map` points at column 0 of the row.
+template <typename Mag>
+void nmsRow(const Mag* magP, const Mag* magA, const Mag* magN,
+            const short* dx, const short* dy, int width, int low, int high,
+            uchar* map, std::vector<uchar*>& stack) {
+    std::memset(map - 1, kNoEdge, width + 2);
+
+    int j = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    // Most of a frame is below the low threshold; skip it a vector at a time
+    if (low >= 0) {
+        const int lanes = magLanes(magA);
+        for (; j <= width - lanes; j += lanes) {
+            if (!anyAboveLow(magA + j, low)) {
+                continue;
+            }
+            for (int k = j; k < j + lanes; k++) {
+                nmsPixel(k, magP, magA, magN, dx, dy, low, high, map, stack);
+            }
+        }
+    }
+#endif
+    for (; j < width; j++) {
+        nmsPixel(j, magP, magA, magN, dx, dy, low, high, map, stack);
+    }
+}
+
+// Grows strong edges through 8-connected weak candidates. Only map bytes in
+// [rowBegin, rowEnd) are touched; popped pixels with a neighbour outside that
+// range are recorded in `seams` (pass a null range to grow unrestricted).
+void hysteresis(std::vector<uchar*>& stack, ptrdiff_t mapStep,
+                const uchar* rowBegin, const uchar* rowEnd, std::vector<uchar*>* seams) {
+    const ptrdiff_t offsets[8] = {
+        -mapStep - 1, -mapStep, -mapStep + 1,
+        -1, 1,
+        mapStep - 1, mapStep, mapStep + 1
+    };
+
+    while (!stack.empty()) {
+        uchar* m = stack.back();
+        stack.pop_back();
+
+        bool bounded = rowBegin != nullptr;
+        if (bounded && (m - rowBegin < mapStep || rowEnd - m <= mapStep)) {
+            seams->push_back(m);
+        }
+        for (ptrdiff_t offset : offsets) {
+            uchar* n = m + offset;
+            if (bounded && (n < rowBegin || n >= rowEnd)) {
+                continue;
+            }
+            if (*n == kMaybeEdge) {
+                *n = kEdge;
+                stack.push_back(n);
+            }
+        }
+    }
+}
+
+// Packs one row of the final edge map, 8 pixels per byte, leftmost pixel in bit 0
+void packRow(const uchar* map, int width, uchar* dst) {
+    int x = 0;
+#if CV_SIMD128
+    // The sign mask of 16 compare results is exactly two output bytes
+    const v_uint8x16 vedge = v_setall_u8(kEdge);
+    for (; x <= width - 16; x += 16) {
+        int bits = v_signmask(v_eq(v_load(map + x), vedge));
+        dst[x / 8] = static_cast<uchar>(bits);
+        dst[x / 8 + 1] = static_cast<uchar>(bits >> 8);
+    }
+#endif
+    for (; x < width; x += 8) {
+        uchar bits = 0;
+        for (int i = 0, n = std::min(8, width - x); i < n; i++) {
+            bits |= static_cast<uchar>((map[x + i] == kEdge) << i);
+        }
+        dst[x / 8] = bits;
+    }
+}
+
+// Expands one row of the final edge map to 0/255 gray, opaque RGBA or packed bits
+void outputRow(const uchar* map, int width, int dstType, uchar* dst) {
+    if (dstType == kCannyPackedBits) {
+        packRow(map, width, dst);
+        return;
+    }
+
+    const int cn = CV_MAT_CN(dstType);
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_uint8>::vlanes();
+    const v_uint8 vedge = vx_setall_u8(kEdge);
+    const v_uint8 alpha = vx_setall_u8(255);
+    for (; x <= width - lanes; x += lanes) {
+        v_uint8 e = v_eq(vx_load(map + x), vedge);
+        if (cn == 1) {
+            v_store(dst + x, e);
+        } else {
+            v_store_interleave(dst + x * 4, e, e, e, alpha);
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        uchar e = map[x] == kEdge ? 255 : 0;
+        if (cn == 1) {
+            dst[x] = e;
+        } else {
+            uchar* p = dst + x * 4;
+            p[0] = p[1] = p[2] = e;
+            p[3] = 255;
+        }
+    }
+}
+
+// Runs luma, gradients and non-max suppression for rows [y0, y1) over a
+// rolling window. Rows y0-2 and y1+1 are read as halo where they exist.
+// `map` points at pixel (0, 0) of the bordered edge map. `magRows` is the
+// window's L1 or L2 magnitude buffer, which selects the gradient.
+template <typename Mag>
+void cannyRows(const uchar* src, ptrdiff_t srcStep, int cn, int pixelStride, int width, int height,
+               int y0, int y1, int low, int high, CannyRowWindow& window, std::vector<Mag>& magRows,
+               uchar* map, ptrdiff_t mapStep, std::vector<uchar*>& stack) {
+    const int paddedWidth = width + 2;
+    window.gray.resize(3 * paddedWidth);
+    window.dx.resize(3 * width);
+    window.dy.resize(3 * width);
+    magRows.resize(3 * paddedWidth);
+
+    // Luma rows are indexed by image row; gradient rows by image row + 1 so
+    // that the zero row above the image gets a slot too
+    auto grayRow = [&](int r) { return window.gray.data() + (r % 3) * paddedWidth + 1; };
+    auto magRow = [&](int r) { return magRows.data() + ((r + 1) % 3) * paddedWidth + 1; };
+    auto dxRow = [&](int r) { return window.dx.data() + ((r + 1) % 3) * width; };
+    auto dyRow = [&](int r) { return window.dy.data() + ((r + 1) % 3) * width; };
+
+    int nextGray = std::max(y0 - 2, 0);
+    auto gradientRow = [&](int r) {
+        Mag* mag = magRow(r);
+        if (r < 0 || r >= height) {
+            std::memset(mag - 1, 0, paddedWidth * sizeof(Mag));
+            return;
+        }
+        for (int last = std::min(r + 1, height - 1); nextGray <= last; nextGray++) {
+            lumaRow(src + nextGray * srcStep, cn, pixelStride, width, grayRow(nextGray));
+        }
+        sobelRow(grayRow(std::max(r - 1, 0)), grayRow(r), grayRow(std::min(r + 1, height - 1)),
+                 width, dxRow(r), dyRow(r), mag);
+    };
+
+    gradientRow(y0 - 1);
+    gradientRow(y0);
+    for (int y = y0; y < y1; y++) {
+        gradientRow(y + 1);
+        nmsRow(magRow(y - 1), magRow(y), magRow(y + 1), dxRow(y), dyRow(y),
+               width, low, high, map + y * mapStep, stack);
+    }
+}
+
+// Minimum stripe height; below this the halo rows dominate the work
+const int kMinStripeRows = 32;
+
+// Loop body for cv::parallel_for_ that calls a stripe lambda directly. The
+// std::function overload would heap-allocate the lambda on every frame.
+template <typename Body>
+struct StripeLoop : ParallelLoopBody {
+    explicit StripeLoop(const Body& body) : body(body) {}
+
+    void operator()(const Range& range) const override {
+        body(range);
+    }
+
+    const Body& body;
+};
+
+// Runs `body` over stripes [0, count), inline when there is only one
+template <typename Body>
+void forEachStripe(int count, const Body& body) {
+    if (count == 1) {
+        body(Range(0, 1));
+    } else {
+        parallel_for_(Range(0, count), StripeLoop<Body>(body));
+    }
+}
+
+// Sums `factor` luma rows column by column
+void sumRows(const uchar* const* rows, int factor, int width, ushort* sums) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_uint16>::vlanes();
+    for (; x <= width - lanes; x += lanes) {
+        v_uint16 sum = vx_load_expand(rows[0] + x);
+        for (int k = 1; k < factor; k++) {
+            sum = v_add(sum, vx_load_expand(rows[k] + x));
+        }
+        v_store(sums + x, sum);
+    }
+#endif
+    for (; x < width; x++) {
+        int sum = 0;
+        for (int k = 0; k < factor; k++) {
+            sum += rows[k][x];
+        }
+        sums[x] = static_cast<ushort>(sum);
+    }
+}
+
+// Adds up each `factor` neighbouring column sums and divides by the block
+// area, rounding halves up
+void averageColumns(const ushort* sums, int factor, int cols, uchar* dst) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    const int lanes = VTraits<v_uint16>::vlanes();
+    if (factor == 2) {
+        const v_uint16 half = vx_setall_u16(2);
+        for (; x <= cols - lanes; x += lanes) {
+            v_uint16 a, b;
+            v_load_deinterleave(sums + x * 2, a, b);
+            v_pack_store(dst + x, v_shr<2>(v_add(v_add(a, b), half)));
+        }
+    } else if (factor == 4) {
+        const v_uint16 half = vx_setall_u16(8);
+        for (; x <= cols - lanes; x += lanes) {
+            v_uint16 a, b, c, d;
+            v_load_deinterleave(sums + x * 4, a, b, c, d);
+            v_pack_store(dst + x, v_shr<4>(v_add(v_add(a, b), v_add(v_add(c, d), half))));
+        }
+    }
+#endif
+    const int area = factor * factor;
+    for (; x < cols; x++) {
+        int sum = 0;
+        for (int k = 0; k < factor; k++) {
+            sum += sums[x * factor + k];
+        }
+        dst[x] = static_cast<uchar>((sum + area / 2) / area);
+    }
+}
+
+void runFusedCanny(const uchar* src, ptrdiff_t srcStep, int srcCn, int srcPixelStride,
+                   uchar* dst, ptrdiff_t dstStep, int dstType,
+                   int width, int height, int low, int high, bool l2Gradient, int stripeCount,
+                   CannyWorkspace& ws) {
+    ws.phaseMarks[0] = monotonicNanos();
+    const ptrdiff_t mapStep = width + 2;
+    ws.map.resize(mapStep * (height + 2));
+    uchar* map = ws.map.data() + mapStep + 1;
+    std::memset(map - mapStep - 1, kNoEdge, mapStep);
+    std::memset(map + height * mapStep - 1, kNoEdge, mapStep);
+
+    ws.stripes.resize(stripeCount);
+    auto stripeRows = [&](int i) {
+        return Range(static_cast<int>(static_cast<int64_t>(height) * i / stripeCount),
+                     static_cast<int>(static_cast<int64_t>(height) * (i + 1) / stripeCount));
+    };
+
+    // Stage 1: gradients, NMS and stripe-local hysteresis
+    auto classify = [&](const Range& range) {
+        int64_t start = traceEnabled() ? monotonicNanos() : 0;
+        for (int i = range.start; i < range.end; i++) {
+            CannyStripe& stripe = ws.stripes[i];
+            Range rows = stripeRows(i);
+            stripe.stack.clear();
+            stripe.seams.clear();
+            if (l2Gradient) {
+                cannyRows(src, srcStep, srcCn, srcPixelStride, width, height, rows.start, rows.end, low, high,
+                          stripe.window, stripe.window.mag2, map, mapStep, stripe.stack);
+            } else {
+                cannyRows(src, srcStep, srcCn, srcPixelStride, width, height, rows.start, rows.end, low, high,
+                          stripe.window, stripe.window.mag, map, mapStep, stripe.stack);
+            }
+            hysteresis(stripe.stack, mapStep, map + rows.start * mapStep - 1,
+                       map + rows.end * mapStep - 1, &stripe.seams);
+        }
+        if (start != 0) {
+            traceSpan("stripe_gradient", start, monotonicNanos());
+        }
+    };
+
+    // Stage 3: final output sweep
+    auto expand = [&](const Range& range) {
+        int64_t start = traceEnabled() ? monotonicNanos() : 0;
+        for (int i = range.start; i < range.end; i++) {
+            Range rows = stripeRows(i);
+            for (int y = rows.start; y < rows.end; y++) {
+                outputRow(map + y * mapStep, width, dstType, dst + y * dstStep);
+            }
+        }
+        if (start != 0) {
+            traceSpan("stripe_output", start, monotonicNanos());
+        }
+    };
+
+    forEachStripe(stripeCount, classify);
+    ws.phaseMarks[1] = monotonicNanos();
+
+    // Stage 2: continue every chain that reached a stripe boundary across it
+    std::vector<uchar*>& stack = ws.stripes[0].stack;
+    for (const CannyStripe& stripe : ws.stripes) {
+        stack.insert(stack.end(), stripe.seams.begin(), stripe.seams.end());
+    }
+    hysteresis(stack, mapStep, nullptr, nullptr, nullptr);
+    ws.phaseMarks[2] = monotonicNanos();
+
+    forEachStripe(stripeCount, expand);
+    ws.phaseMarks[3] = monotonicNanos();
+}
+
+// Allocates `dst` for a width x height edge map in the given layout
+void createEdgeOutput(cv::Mat& dst, int width, int height, int dstType) {
+    if (dstType == kCannyPackedBits) {
+        dst.create(height, packedEdgeCols(width), CV_8UC1);
+    } else {
+        dst.create(height, width, dstType);
+    }
+}
+
+// Resolves the integer thresholds cv::Canny uses and runs the kernel
+void fusedCannyImpl(const uchar* src, ptrdiff_t srcStep, int srcCn, int srcPixelStride,
+                    int width, int height, cv::Mat& dst, int dstType, bool flipOutput,
+                    const EdgeParams& params, CannyWorkspace* workspace) {
+    if (workspace != nullptr) {
+        std::fill_n(workspace->phaseMarks, 4, 0);  // Stays so unless the kernel runs
+    }
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    double lowThreshold = params.lowThreshold;
+    double highThreshold = params.highThreshold;
+    if (lowThreshold > highThreshold) {
+        std::swap(lowThreshold, highThreshold);
+    }
+    if (params.l2Gradient) {
+        // Squared magnitudes are compared against squared thresholds
+        lowThreshold = std::min(32767.0, lowThreshold);
+        highThreshold = std::min(32767.0, highThreshold);
+        if (lowThreshold > 0) {
+            lowThreshold *= lowThreshold;
+        }
+        if (highThreshold > 0) {
+            highThreshold *= highThreshold;
+        }
+    }
+
+    CannyWorkspace localWorkspace;
+    CannyWorkspace& ws = workspace != nullptr ? *workspace : localWorkspace;
+
+    const ptrdiff_t dstStep = static_cast<ptrdiff_t>(dst.step);
+    runFusedCanny(src, srcStep, srcCn, srcPixelStride,
+                  dst.ptr(flipOutput ? height - 1 : 0), flipOutput ? -dstStep : dstStep, dstType,
+                  width, height, cvFloor(lowThreshold), cvFloor(highThreshold), params.l2Gradient,
+                  cannyStripeCount(params, height), ws);
+}
+
+}  // namespace
+
+int cannyStripeCount(const EdgeParams& params, int rows) {
+    int stripes = params.stripes > 0 ? params.stripes : cv::getNumThreads();
+    return std::max(1, std::min(stripes, rows / kMinStripeRows));
+}
+
+void fusedCanny(const cv::Mat& src, cv::Mat& dst, int dstType, const EdgeParams& params,
+                bool bottomUp, CannyWorkspace* workspace) {
+    CV_Assert(src.depth() == CV_8U && (src.channels() == 1 || src.channels() == 4));
+    CV_Assert(dstType == CV_8UC1 || dstType == CV_8UC4 || dstType == kCannyPackedBits);
+
+    // Hold a reference so `dst` may alias `src` even if it gets reallocated
+    cv::Mat input = src;
+    createEdgeOutput(dst, input.cols, input.rows, dstType);
+    if (input.empty()) {
+        return;
+    }
+
+    // Walking both images from their last row keeps Canny running upright
+    const ptrdiff_t srcStep = static_cast<ptrdiff_t>(input.step);
+    fusedCannyImpl(input.ptr(bottomUp ? input.rows - 1 : 0), bottomUp ? -srcStep : srcStep,
+                   input.channels(), input.channels(), input.cols, input.rows,
+                   dst, dstType, bottomUp, params, workspace);
+}
+
+void fusedCannyPlane(const uchar* data, int width, int height, size_t rowStride, int pixelStride,
+                     cv::Mat& dst, int dstType, const EdgeParams& params,
+                     bool flipOutput, CannyWorkspace* workspace) {
+    CV_Assert(data != nullptr && width >= 0 && height >= 0 && pixelStride >= 1);
+    CV_Assert(width == 0 || rowStride >= static_cast<size_t>(width - 1) * pixelStride + 1);
+    CV_Assert(dstType == CV_8UC1 || dstType == CV_8UC4 || dstType == kCannyPackedBits);
+
+    createEdgeOutput(dst, width, height, dstType);
+    fusedCannyImpl(data, static_cast<ptrdiff_t>(rowStride), 1, pixelStride, width, height,
+                   dst, dstType, flipOutput, params, workspace);
+}
+
+void downscaleLuma(const uchar* data, int cn, int width, int height, size_t rowStride, int pixelStride,
+                   int factor, cv::Mat& dst, const EdgeParams& params, CannyWorkspace* workspace) {
+    CV_Assert(data != nullptr && (cn == 1 || cn == 4) && factor >= 2 && factor <= kMaxDownscale);
+    CV_Assert(cn == 4 || pixelStride >= 1);
+
+    const int cols = width / factor;
+    const int rows = height / factor;
+    dst.create(rows, cols, CV_8UC1);
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+
+    CannyWorkspace localWorkspace;
+    CannyWorkspace& ws = workspace != nullptr ? *workspace : localWorkspace;
+    const int stripeCount = cannyStripeCount(params, rows);
+    if (static_cast<int>(ws.stripes.size()) < stripeCount) {
+        ws.stripes.resize(stripeCount);
+    }
+    // Planes with packed samples are summed in place; anything else is
+    // converted or gathered a row at a time first
+    const bool direct = cn == 1 && pixelStride == 1;
+    const int used = cols * factor;
+
+    auto shrink = [&](const Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            CannyStripe& stripe = ws.stripes[i];
+            stripe.downscaleSums.resize(used);
+            if (!direct) {
+                stripe.downscaleRows.resize(static_cast<size_t>(factor) * (width + 2));
+            }
+            const uchar* lumaRows[kMaxDownscale];
+            int y0 = static_cast<int>(static_cast<int64_t>(rows) * i / stripeCount);
+            int y1 = static_cast<int>(static_cast<int64_t>(rows) * (i + 1) / stripeCount);
+            for (int y = y0; y < y1; y++) {
+                for (int k = 0; k < factor; k++) {
+                    const uchar* src = data + (static_cast<size_t>(y) * factor + k) * rowStride;
+                    if (direct) {
+                        lumaRows[k] = src;
+                    } else {
+                        uchar* luma = stripe.downscaleRows.data() + k * (width + 2) + 1;
+                        lumaRow(src, cn, pixelStride, width, luma);
+                        lumaRows[k] = luma;
+                    }
+                }
+                sumRows(lumaRows, factor, used, stripe.downscaleSums.data());
+                averageColumns(stripe.downscaleSums.data(), factor, cols, dst.ptr(y));
+            }
+        }
+    };
+    forEachStripe(stripeCount, shrink);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "edge_pipeline.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+// Rolling three-row window used by the gradient and non-max suppression stage
+struct CannyRowWindow {
+    std::vector<uchar> gray;    // 3 luma rows, 1px replicated border on each side
+    std::vector<short> dx;      // 3 rows of horizontal Sobel response
+    std::vector<short> dy;      // 3 rows of vertical Sobel response
+    std::vector<ushort> mag;    // 3 rows of L1 magnitude, 1px zero border on each side
+    std::vector<int> mag2;      // Same for the squared L2 magnitude (EdgeParams::l2Gradient)
+};
+
+// Per-stripe state for the parallel gradient/NMS and hysteresis stages
+struct CannyStripe {
+    CannyRowWindow window;
+    std::vector<uchar*> stack;  // hysteresis work list
+    std::vector<uchar*> seams;  // edge pixels whose neighbours lie in another stripe
+    std::vector<uchar> downscaleRows;  // downscaleLuma: converted luma rows of one block
+    std::vector<ushort> downscaleSums;  // downscaleLuma: column sums of one block row
+};
+
+// Scratch memory for fusedCanny. Keep one around and pass it in to avoid
+// reallocating the edge map and row buffers every frame.
+struct CannyWorkspace {
+    std::vector<uchar> map;     // (rows + 2) x (cols + 2) edge classification map
+    std::vector<CannyStripe> stripes;
+    // Luma planes for EdgeParams::downscale and blurAperture (processFrameView)
+    cv::Mat luma;
+    cv::Mat smallLuma;
+    // monotonicNanos() at the start of the last call and after each of its
+    // three stages (gradient/NMS, cross-stripe hysteresis, output sweep);
+    // all 0 when the last call had nothing to do
+    int64_t phaseMarks[4] = {};
+};
+
+// Largest downscaleLuma factor (its 16-bit block sums hold 16 x 16 pixels)
+const int kMaxDownscale = 16;
+
+// dstType for a bit-packed edge map: CV_8UC1 rows of packedEdgeCols(cols)
+// bytes, each holding 8 pixels with the leftmost in the least significant bit
+const int kCannyPackedBits = -1;
+
+// Number of horizontal stripes fusedCanny will use for a frame of `rows`
+// rows, after resolving EdgeParams::stripes == 0 and the minimum stripe height
+int cannyStripeCount(const EdgeParams& params, int rows);
+
+// Fused RGBA/gray -> luma -> Canny -> output kernel.
+//
+// The input is read exactly once: luma conversion, Sobel gradients and
+// non-max suppression run over a rolling window of three rows, hysteresis
+// runs on the compact edge map, and a single final sweep writes `dst` as
+// CV_8UC1, CV_8UC4 or kCannyPackedBits (`dstType`). The result is bit-identical to
+// processFrameWithCanny (cvtColor + Canny with L1 gradient, aperture 3), or
+// to cv::Canny with L2gradient when EdgeParams::l2Gradient is set. Downscale
+// and blur are not applied here; processFrameView does that.
+//
+// With more than one stripe, rows are split into horizontal stripes that run
+// on cv::parallel_for_. Each stripe reads two halo rows on either side for the
+// gradient/NMS stages and runs hysteresis locally; chains that cross a stripe
+// boundary are then completed in a serial seam pass, so the output does not
+// depend on the stripe count.
+//
+// When `bottomUp` is set, `src` and `dst` are in OpenGL row order and the
+// kernel walks them upright, so the output equals flip -> Canny -> flip
+// without either flip pass.
+void fusedCanny(const cv::Mat& src, cv::Mat& dst, int dstType, const EdgeParams& params,
+                bool bottomUp = false, CannyWorkspace* workspace = nullptr);
+
+// Same kernel on a single 8-bit plane described by explicit strides, such as
+// the Y plane of an NV21, I420 or YUV_420_888 camera frame. The plane is read
+// in place with no color conversion or copy. `flipOutput` writes `dst`
+// bottom-up (OpenGL row order) while Canny still runs on the upright plane.
+void fusedCannyPlane(const uchar* data, int width, int height, size_t rowStride, int pixelStride,
+                     cv::Mat& dst, int dstType, const EdgeParams& params,
+                     bool flipOutput = false, CannyWorkspace* workspace = nullptr);
+
+// Shrinks the luma of an RGBA image (`cn` 4) or of an 8-bit plane whose
+// samples are `pixelStride` bytes apart (`cn` 1) by an integer `factor` into
+// CV_8UC1 `dst`, averaging each factor x factor block with halves rounded up.
+// Rows and columns that don't fill a whole block are dropped from the end.
+// For factors 2 and 4 this is cv::resize with INTER_AREA (up to the rounding
+// of exact halves at 4, which OpenCV's builds don't agree on), in one SIMD
+// pass with the luma conversion fused in: the full-size luma is never written.
+// Rows are split into stripes as by fusedCanny.
+void downscaleLuma(const uchar* data, int cn, int width, int height, size_t rowStride, int pixelStride,
+                   int factor, cv::Mat& dst, const EdgeParams& params, CannyWorkspace* workspace = nullptr);
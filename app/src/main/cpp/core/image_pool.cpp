@@ -0,0 +1,159 @@
+#include "image_pool.h"
+
+#include "fused_canny.h"
+#include "stage_stats.h"
+#include "trace.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+ImageBatch::ImageBatch(std::vector<ImageJob> jobs)
+    : jobs(std::move(jobs)), nanos(this->jobs.size(), -1) {
+    completionOrder.reserve(this->jobs.size());
+}
+
+int ImageBatch::completed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(completionOrder.size());
+}
+
+int64_t ImageBatch::imageNanos(int index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nanos[index];
+}
+
+void ImageBatch::copyImageNanos(int64_t* out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::copy(nanos.begin(), nanos.end(), out);
+}
+
+int ImageBatch::waitCompleted(int count) {
+    if (size() == 0) {
+        return -1;
+    }
+    count = std::max(1, std::min(count, size()));
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this, count] {
+        return static_cast<int>(completionOrder.size()) >= count;
+    });
+    return completionOrder[count - 1];
+}
+
+void ImageBatch::wait() {
+    waitCompleted(size());
+}
+
+void ImageBatch::complete(int index, int64_t imageNanos) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nanos[index] = imageNanos;
+        completionOrder.push_back(index);
+    }
+    done.notify_all();
+}
+
+ImagePool::ImagePool(int threads) {
+    int count = threads > 0 ? threads : bigCoreCount();
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back(&ImagePool::workerLoop, this);
+    }
+}
+
+ImagePool::~ImagePool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::shared_ptr<ImageBatch> ImagePool::submit(std::vector<ImageJob> jobs, const EdgeParams& params) {
+    auto batch = std::make_shared<ImageBatch>(std::move(jobs));
+    if (batch->size() == 0) {
+        return batch;
+    }
+    PendingBatch pending;
+    pending.batch = batch;
+    pending.params = params;
+    pending.params.stripes = 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(pending);
+    }
+    wake.notify_all();
+    return batch;
+}
+
+void ImagePool::workerLoop() {
+    traceSetThreadName("image_pool");
+    CannyWorkspace workspace;
+    while (true) {
+        std::shared_ptr<ImageBatch> batch;
+        EdgeParams params;
+        int index = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] {
+                return stopping || !queue.empty();
+            });
+            if (queue.empty()) {
+                return;  // Stopping, and every queued image has been handed out
+            }
+            PendingBatch& pending = queue.front();
+            batch = pending.batch;
+            params = pending.params;
+            index = batch->nextJob++;
+            if (batch->nextJob == batch->size()) {
+                queue.pop_front();
+            }
+        }
+
+        const ImageJob& job = batch->jobs[index];
+        if (job.input == nullptr || job.output == nullptr || job.width <= 0 || job.height <= 0 ||
+            job.inputStride < job.width * 4 || job.outputStride < job.width * 4) {
+            batch->complete(index, -1);
+            continue;
+        }
+        int64_t start = monotonicNanos();
+        processStillImage(job.input, job.width, job.height, job.inputStride, job.output, job.outputStride,
+                          params, &workspace);
+        int64_t end = monotonicNanos();
+        traceSpan("still_image", start, end);
+        batch->complete(index, end - start);
+    }
+}
+
+int bigCoreCount() {
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    std::vector<long> maxFrequencies;
+    for (long cpu = 0; cpu < cpus; cpu++) {
+        char path[96];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+        FILE* file = std::fopen(path, "r");
+        long frequency = 0;
+        if (file != nullptr) {
+            if (std::fscanf(file, "%ld", &frequency) != 1) {
+                frequency = 0;
+            }
+            std::fclose(file);
+        }
+        maxFrequencies.push_back(frequency);
+    }
+    if (maxFrequencies.empty()) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    auto range = std::minmax_element(maxFrequencies.begin(), maxFrequencies.end());
+    long slowest = *range.first;
+    if (slowest == 0 || slowest == *range.second) {
+        return static_cast<int>(maxFrequencies.size());  // Unreadable or a single cluster
+    }
+    return static_cast<int>(std::count_if(maxFrequencies.begin(), maxFrequencies.end(),
+                                          [slowest](long frequency) { return frequency > slowest; }));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "edge_pipeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Concurrent edge detection on batches of still images (NativeBridge).
+//
+// A fixed set of worker threads, each with its own CannyWorkspace, takes
+// images one at a time from the oldest submitted batch. Every image runs
+// single-stripe: with many images in flight, parallelism across images beats
+// splitting each one, and small images would not fill the stripes anyway.
+// Threads are started once, so a batch costs no thread creation.
+
+// One still image, processed by processStillImage. Images with a null
+// buffer, no pixels or strides too short complete straight away with a time of -1.
+struct ImageJob {
+    const uchar* input = nullptr;
+    int width = 0;
+    int height = 0;
+    int inputStride = 0;  // Bytes between input rows
+    uchar* output = nullptr;
+    int outputStride = 0;  // Bytes between output rows
+};
+
+// Completion state of a submitted batch. Thread-safe; the jobs' buffers must
+// stay valid until wait() returns.
+class ImageBatch {
+public:
+    explicit ImageBatch(std::vector<ImageJob> jobs);
+
+    int size() const {
+        return static_cast<int>(jobs.size());
+    }
+
+    // Images done so far
+    int completed() const;
+
+    // Processing time of image `index` in nanoseconds, -1 while pending or if the image was invalid
+    int64_t imageNanos(int index) const;
+
+    // imageNanos of every image, into `nanos[size()]`
+    void copyImageNanos(int64_t* nanos) const;
+
+    // Blocks until `count` images are done and returns the index of the
+    // count-th one, in completion order (count is 1-based); -1 for an empty batch
+    int waitCompleted(int count);
+
+    // Blocks until every image is done
+    void wait();
+
+private:
+    friend class ImagePool;
+
+    void complete(int index, int64_t nanos);
+
+    std::vector<ImageJob> jobs;
+    int nextJob = 0;  // Next image to hand out; guarded by the pool's mutex
+
+    mutable std::mutex mutex;
+    std::condition_variable done;
+    std::vector<int64_t> nanos;
+    std::vector<int> completionOrder;
+};
+
+class ImagePool {
+public:
+    // threads = 0 sizes the pool to the big cores (bigCoreCount)
+    explicit ImagePool(int threads = 0);
+    ~ImagePool();
+
+    ImagePool(const ImagePool&) = delete;
+    ImagePool& operator=(const ImagePool&) = delete;
+
+    // Queues the images and returns at once; `params.stripes` is ignored
+    std::shared_ptr<ImageBatch> submit(std::vector<ImageJob> jobs, const EdgeParams& params = EdgeParams());
+
+    int threadCount() const {
+        return static_cast<int>(workers.size());
+    }
+
+private:
+    struct PendingBatch {
+        std::shared_ptr<ImageBatch> batch;
+        EdgeParams params;
+    };
+
+    void workerLoop();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<PendingBatch> queue;  // Batches with images not yet handed out
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+// Cores outside the slowest cluster of a big.LITTLE CPU, by their maximum
+// frequency in sysfs; every core when the clusters can't be told apart
+int bigCoreCount();
@@ -0,0 +1,112 @@
+#include "motion_gate.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Cheap luma for the signature; only changes matter, not exact values
+inline int sampleLuma(const uint8_t* p, int cn) {
+    return cn == 4 ? (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8 : p[0];
+}
+
+// Helper function to size the signature grid for a frame and count the
+// samples that fall into each block
+void resizeGrid(MotionGate& gate, int width, int height) {
+    const int block = gate.config.blockSize;
+    const int step = gate.config.sampleStep;
+    gate.width = width;
+    gate.height = height;
+    gate.blockCols = (width + block - 1) / block;
+    gate.blockRows = (height + block - 1) / block;
+    const size_t blocks = static_cast<size_t>(gate.blockCols) * gate.blockRows;
+    gate.reference.assign(blocks, 0);
+    gate.current.assign(blocks, 0);
+    gate.sums.assign(gate.blockCols, 0);
+    gate.samples.resize(blocks);
+    for (int by = 0; by < gate.blockRows; by++) {
+        int rows = (std::min(height, (by + 1) * block) - by * block + step - 1) / step;
+        for (int bx = 0; bx < gate.blockCols; bx++) {
+            int cols = (std::min(width, (bx + 1) * block) - bx * block + step - 1) / step;
+            gate.samples[by * gate.blockCols + bx] = static_cast<uint16_t>(rows * cols);
+        }
+    }
+    gate.hasReference = false;
+}
+
+// Helper function to fill gate.current with the block means of a frame
+void computeSignature(MotionGate& gate, const uint8_t* data, int cn, int rowStride, int pixelStride) {
+    const int block = gate.config.blockSize;
+    const int step = gate.config.sampleStep;
+    const int pixelBytes = cn == 4 ? 4 : pixelStride;
+    const int xStep = step * pixelBytes;
+    for (int by = 0; by < gate.blockRows; by++) {
+        std::fill(gate.sums.begin(), gate.sums.end(), 0u);
+        const int yEnd = std::min(gate.height, (by + 1) * block);
+        for (int y = by * block; y < yEnd; y += step) {
+            const uint8_t* row = data + static_cast<size_t>(y) * rowStride;
+            for (int bx = 0; bx < gate.blockCols; bx++) {
+                const int xEnd = std::min(gate.width, (bx + 1) * block);
+                const uint8_t* p = row + static_cast<size_t>(bx) * block * pixelBytes;
+                uint32_t sum = 0;
+                for (int x = bx * block; x < xEnd; x += step, p += xStep) {
+                    sum += sampleLuma(p, cn);
+                }
+                gate.sums[bx] += sum;
+            }
+        }
+        for (int bx = 0; bx < gate.blockCols; bx++) {
+            const int index = by * gate.blockCols + bx;
+            const uint32_t count = gate.samples[index];
+            gate.current[index] = static_cast<uint8_t>((gate.sums[bx] + count / 2) / count);
+        }
+    }
+}
+
+}  // namespace
+
+void motionGateInit(MotionGate& gate, const MotionGateConfig& config) {
+    gate = MotionGate();
+    gate.config = config;
+    gate.config.sampleStep = std::max(1, config.sampleStep);
+    gate.config.blockSize = std::max(1, config.blockSize / gate.config.sampleStep) * gate.config.sampleStep;
+}
+
+void motionGateConfigure(MotionGate& gate, int blockThreshold, int64_t refreshNanos) {
+    gate.config.blockThreshold = std::max(0, blockThreshold);
+    gate.config.refreshNanos = std::max<int64_t>(0, refreshNanos);
+    gate.hasReference = false;
+    gate.staticFrames = 0;
+}
+
+bool motionGateCheck(MotionGate& gate, const uint8_t* data, int cn, int width, int height, int rowStride,
+                     int pixelStride, int64_t nowNanos) {
+    if (gate.config.blockThreshold <= 0 || width <= 0 || height <= 0) {
+        gate.hasReference = false;
+        gate.changedBlocks = 0;
+        return true;
+    }
+    if (width != gate.width || height != gate.height) {
+        resizeGrid(gate, width, height);
+    }
+
+    computeSignature(gate, data, cn, rowStride, pixelStride);
+    gate.changedBlocks = 0;
+    for (size_t i = 0; i < gate.current.size(); i++) {
+        if (std::abs(gate.current[i] - gate.reference[i]) > gate.config.blockThreshold) {
+            gate.changedBlocks++;
+        }
+    }
+
+    bool refreshDue = nowNanos - gate.referenceNanos >= gate.config.refreshNanos;
+    if (gate.hasReference && gate.changedBlocks == 0 && !refreshDue) {
+        gate.staticFrames++;
+        gate.framesStatic++;
+        return false;
+    }
+    gate.reference.swap(gate.current);
+    gate.referenceNanos = nowNanos;
+    gate.hasReference = true;
+    gate.staticFrames = 0;
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Change detection that lets the edge pipeline skip frames of a static scene.
+//
+// Each frame is reduced to a signature: the mean luma of every blockSize x
+// blockSize block, sampled every sampleStep pixels of every sampleStep-th
+// row, which costs a small fraction of a Canny pass. A frame whose blocks
+// all stay within blockThreshold of the last processed frame's signature is
+// static: its edges would be the ones on screen already. Comparing against
+// the last processed frame rather than the previous one lets slow drift add
+// up until it is processed. Once refreshNanos have passed since the last
+// processed frame the next one is processed anyway, which bounds how stale
+// the edges can get (e.g. after lighting changes too even to trip a block).
+//
+// Plain state with no locking and no OpenCV; callers serialize access.
+
+struct MotionGateConfig {
+    int blockThreshold = 0;              // Change of a block's mean luma that counts as motion; 0 = off
+    int64_t refreshNanos = 1000000000;   // Longest time between processed frames
+    int blockSize = 32;                  // Pixels per block side, a multiple of sampleStep
+    int sampleStep = 4;                  // Pixels and rows between samples
+};
+
+struct MotionGate {
+    MotionGateConfig config;
+
+    // Signature grid, sized for the last frame checked
+    int width;
+    int height;
+    int blockCols;
+    int blockRows;
+    std::vector<uint8_t> reference;  // Block means of the last processed frame
+    std::vector<uint8_t> current;    // Block means of the frame being checked
+    std::vector<uint32_t> sums;      // Luma sums of one row of blocks
+    std::vector<uint16_t> samples;   // Samples per block, by row then column of blocks
+    bool hasReference;
+    int64_t referenceNanos;  // When the reference frame was checked
+
+    int changedBlocks;     // Blocks over the threshold in the last frame checked
+    int staticFrames;      // Frames skipped since the last processed one
+    int64_t framesStatic;  // Frames skipped ever
+};
+
+// Resets `gate` with `config`, counters included
+void motionGateInit(MotionGate& gate, const MotionGateConfig& config);
+
+// Changes the threshold and refresh interval, keeping the counters. The next
+// frame is processed and becomes the new reference.
+void motionGateConfigure(MotionGate& gate, int blockThreshold, int64_t refreshNanos);
+
+// Checks one frame: RGBA pixels (`cn` 4) or an 8-bit luma plane whose samples
+// are `pixelStride` bytes apart (`cn` 1). Returns true when it should be
+// processed - it moved, its size changed, a refresh is due or the gate is
+// off - and makes it the reference. Otherwise counts it as static.
+bool motionGateCheck(MotionGate& gate, const uint8_t* data, int cn, int width, int height, int rowStride,
+                     int pixelStride, int64_t nowNanos);
@@ -0,0 +1,124 @@
+#include "quality_governor.h"
+
+#include <algorithm>
+
+const QualityLevel kQualityLevels[kQualityLevelCount] = {
+    {1, 5, true, 1, 1.6},
+    {1, 3, true, 1, 1.45},
+    {1, 3, false, 1, 1.3},
+    {1, 0, false, 1, 1.0},  // kDefaultQualityLevel
+    {2, 0, false, 1, 0.3},
+    {2, 0, false, 2, 0.15},
+    {4, 0, false, 2, 0.05},
+    {4, 0, false, 3, 0.035},
+};
+
+namespace {
+
+// Helper function to move to `level`, logging the transition
+void changeLevel(QualityGovernor& governor, int level, int64_t costNanos, int64_t nowNanos) {
+    QualityTransition& transition = governor.history[governor.transitions % QualityGovernor::kHistorySize];
+    transition.timestampNanos = nowNanos;
+    transition.fromLevel = governor.level;
+    transition.toLevel = level;
+    transition.costNanos = costNanos;
+    governor.transitions++;
+
+    governor.onTrial = level < governor.level;
+    governor.level = level;
+    governor.framesAtLevel = 0;
+    governor.windowCount = 0;
+    governor.overBudgetWindows = 0;
+}
+
+}  // namespace
+
+void governorInit(QualityGovernor& governor, const GovernorConfig& config) {
+    governor = QualityGovernor();
+    governor.config = config;
+    governor.config.windowFrames = std::max(1, std::min(config.windowFrames, QualityGovernor::kMaxWindowFrames));
+    governor.config.bestLevel = std::max(0, std::min(config.bestLevel, kDefaultQualityLevel));
+    governor.level = kDefaultQualityLevel;
+    for (int& hold : governor.upshiftHold) {
+        hold = config.holdFrames;
+    }
+}
+
+void governorSetBudget(QualityGovernor& governor, int64_t budgetNanos, int64_t nowNanos) {
+    governor.config.budgetNanos = std::max<int64_t>(0, budgetNanos);
+    governor.windowCount = 0;
+    governor.overBudgetWindows = 0;
+    if (governor.config.budgetNanos == 0 && governor.level != kDefaultQualityLevel) {
+        changeLevel(governor, kDefaultQualityLevel, 0, nowNanos);
+        governor.onTrial = false;
+    }
+}
+
+void governorSetBestLevel(QualityGovernor& governor, int bestLevel, int64_t nowNanos) {
+    governor.config.bestLevel = std::max(0, std::min(bestLevel, kDefaultQualityLevel));
+    if (governor.level < governor.config.bestLevel) {
+        changeLevel(governor, governor.config.bestLevel, 0, nowNanos);
+    }
+}
+
+bool governorAdmitFrame(QualityGovernor& governor) {
+    if (++governor.framesSinceProcessed < kQualityLevels[governor.level].frameInterval) {
+        governor.framesSkipped++;
+        return false;
+    }
+    governor.framesSinceProcessed = 0;
+    return true;
+}
+
+bool governorRecord(QualityGovernor& governor, int level, int64_t processingNanos, int64_t nowNanos) {
+    const GovernorConfig& config = governor.config;
+    if (config.budgetNanos <= 0 || level != governor.level) {
+        return false;
+    }
+
+    governor.framesAtLevel++;
+    if (governor.onTrial && governor.framesAtLevel >= config.holdFrames) {
+        // The upshift held: that level may be tried again promptly next time
+        governor.onTrial = false;
+        governor.upshiftHold[governor.level] = config.holdFrames;
+    }
+
+    governor.windowNanos[governor.windowCount] = processingNanos / kQualityLevels[level].frameInterval;
+    if (++governor.windowCount < config.windowFrames) {
+        return false;
+    }
+    int64_t* window = governor.windowNanos;
+    int64_t* quartile = window + governor.windowCount * 3 / 4;
+    std::nth_element(window, quartile, window + governor.windowCount);
+    int64_t cost = *quartile;
+    governor.lastCostNanos = cost;
+    governor.windowCount = 0;
+
+    governor.overBudgetWindows = cost > config.budgetNanos ? governor.overBudgetWindows + 1 : 0;
+    if (governor.overBudgetWindows >= config.downshiftWindows && level + 1 < kQualityLevelCount) {
+        if (governor.onTrial) {
+            // Failed upshift: back off before trying this level again
+            int& hold = governor.upshiftHold[level];
+            hold = std::min(hold * 2, config.maxHoldFrames);
+        }
+        changeLevel(governor, level + 1, cost, nowNanos);
+        return true;
+    }
+    if (level > config.bestLevel && governor.framesAtLevel >= governor.upshiftHold[level - 1]) {
+        double predicted = cost * kQualityLevels[level - 1].relativeCost / kQualityLevels[level].relativeCost;
+        if (predicted < config.budgetNanos * config.upshiftRatio) {
+            changeLevel(governor, level - 1, cost, nowNanos);
+            return true;
+        }
+    }
+    return false;
+}
+
+int governorHistory(const QualityGovernor& governor, QualityTransition* out, int maxCount) {
+    int64_t count = std::min<int64_t>(std::min<int64_t>(governor.transitions, QualityGovernor::kHistorySize),
+                                      std::max(0, maxCount));
+    for (int64_t i = 0; i < count; i++) {
+        out[i] = governor.history[(governor.transitions - count + i) % QualityGovernor::kHistorySize];
+    }
+    return static_cast<int>(count);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+
+// Closed-loop quality control for the CPU edge pipeline.
+//
+// The governor is fed the measured processing time of every frame and keeps
+// it within a per-frame budget by stepping along a ladder of quality levels,
+// from full resolution with blur and L2 gradients down to a quarter-size luma
+// processed every third frame. Cost is compared per input frame, so a level
+// that processes every Nth frame is charged a Nth of each processing time.
+// It never steps above bestLevel, which is the default level unless the
+// caller opts into the blurred and L2 levels that change the edges drawn.
+//
+// Each decision looks at the upper quartile of a window of frames, so most
+// frames fit the budget and a lone spike changes nothing. Hysteresis keeps it
+// from oscillating: consecutive windows over the budget move one level down.
+// Moving up needs the better level's predicted cost (the measured one scaled
+// by the levels' relativeCost) to stay under upshiftRatio of the budget, and
+// the level must have been held for a while.
+// An upshift that has to be undone before it was confirmed doubles the hold
+// before that level is tried again, up to maxHoldFrames.
+//
+// Plain state with no locking and no platform dependencies; callers
+// serialize access.
+
+// One rung of the quality ladder
+struct QualityLevel {
+    int downscale;      // EdgeParams::downscale
+    int blurAperture;   // EdgeParams::blurAperture
+    bool l2Gradient;    // EdgeParams::l2Gradient
+    int frameInterval;  // Process every Nth input frame
+    // Rough cost per input frame relative to kDefaultQualityLevel. Only the
+    // ratios of neighbours matter; a wrong one costs a failed upshift.
+    double relativeCost;
+};
+
+const int kQualityLevelCount = 8;
+
+// Best quality first
+extern const QualityLevel kQualityLevels[kQualityLevelCount];
+
+// Full resolution, no blur, L1 gradient, every frame: the pipeline as it
+// runs without a governor
+const int kDefaultQualityLevel = 3;
+
+struct GovernorConfig {
+    int64_t budgetNanos = 0;    // Processing time allowed per input frame; 0 holds the level
+    int windowFrames = 8;       // Processed frames per decision, up to kMaxWindowFrames
+    int downshiftWindows = 2;   // Consecutive windows over the budget that step down
+    double upshiftRatio = 0.8;  // Share of the budget the better level must be predicted to fit
+    int holdFrames = 30;        // Processed frames to stay at a level before trying a better one
+    int maxHoldFrames = 960;    // Cap of the hold after failed upshifts
+    int bestLevel = kDefaultQualityLevel;  // Highest quality stepped up to, 0..kDefaultQualityLevel
+};
+
+// A level change and the window cost that triggered it
+struct QualityTransition {
+    int64_t timestampNanos;
+    int fromLevel;
+    int toLevel;
+    int64_t costNanos;  // Per input frame; 0 when the budget was changed
+};
+
+struct QualityGovernor {
+    static constexpr int kHistorySize = 16;
+    static constexpr int kMaxWindowFrames = 32;
+
+    GovernorConfig config;
+    int level;
+
+    // Current decision window, per input frame
+    int64_t windowNanos[kMaxWindowFrames];
+    int windowCount;
+    int overBudgetWindows;  // Consecutive, at this level
+
+    int framesAtLevel;   // Processed since the last change
+    bool onTrial;        // Reached by an upshift that is not confirmed yet
+    int upshiftHold[kQualityLevelCount];  // Frames to hold before trying each level
+    int framesSinceProcessed;
+
+    int64_t framesSkipped;  // Input frames dropped by frameInterval
+    int64_t lastCostNanos;  // Upper quartile of the last complete window, per input frame
+
+    QualityTransition history[kHistorySize];
+    int64_t transitions;  // Ever; history slot = transitions % kHistorySize
+};
+
+// Resets `governor` to kDefaultQualityLevel with `config`
+void governorInit(QualityGovernor& governor, const GovernorConfig& config);
+
+// Changes the budget, keeping the current level. A budget of 0 turns the
+// governor off and returns to kDefaultQualityLevel.
+void governorSetBudget(QualityGovernor& governor, int64_t budgetNanos, int64_t nowNanos);
+
+// Changes the best level stepped up to (clamped to 0..kDefaultQualityLevel),
+// stepping down to it at once if the current level is better.
+void governorSetBestLevel(QualityGovernor& governor, int bestLevel, int64_t nowNanos);
+
+// Call once per input frame before processing it. Returns false for frames
+// the current level's frameInterval skips, and counts them.
+bool governorAdmitFrame(QualityGovernor& governor);
+
+// Records that a frame processed at `level` took `processingNanos`, and
+// changes the level when a window is complete. Samples taken at a level that
+// is no longer current are ignored. Returns true if the level changed.
+bool governorRecord(QualityGovernor& governor, int level, int64_t processingNanos, int64_t nowNanos);
+
+// Copies up to `maxCount` of the most recent transitions, oldest first.
+// Returns how many were copied.
+int governorHistory(const QualityGovernor& governor, QualityTransition* out, int maxCount);
@@ -0,0 +1,163 @@
+#include "stage_stats.h"
+
+#include "fused_canny.h"
+#include "trace.h"
+
+#include <algorithm>
+
+const char* const kStageNames[STAGE_COUNT] = {
+    "frame",
+    "fbo_render",
+    "readback",
+    "canny",
+    "canny_gradient",
+    "canny_hysteresis",
+    "canny_output",
+    "luma_canny",
+    "gpu_canny",
+    "upload",
+    "draw",
+    "swap",
+};
+
+namespace {
+
+// Bucket 0 holds everything under 1024 ns. Above that each octave is split
+// into 8 buckets by the three bits below the leading one.
+const int kFirstOctaveBit = 10;
+const int kSubBucketBits = 3;
+
+int bucketIndex(int64_t nanos) {
+    if (nanos < (int64_t(1) << kFirstOctaveBit)) {
+        return 0;
+    }
+    int msb = 63 - __builtin_clzll(static_cast<uint64_t>(nanos));
+    int sub = static_cast<int>((nanos >> (msb - kSubBucketBits)) & ((1 << kSubBucketBits) - 1));
+    int index = 1 + ((msb - kFirstOctaveBit) << kSubBucketBits) + sub;
+    return std::min(index, StageTrack::kBuckets - 1);
+}
+
+// Exclusive upper bound of the durations in bucket `index`
+int64_t bucketUpperBound(int index) {
+    if (index == 0) {
+        return int64_t(1) << kFirstOctaveBit;
+    }
+    int msb = kFirstOctaveBit + ((index - 1) >> kSubBucketBits);
+    int64_t sub = (index - 1) & ((1 << kSubBucketBits) - 1);
+    return (int64_t(1 << kSubBucketBits) + sub + 1) << (msb - kSubBucketBits);
+}
+
+}  // namespace
+
+void stageStatsInit(StageStats& stats) {
+    for (StageTrack& track : stats.stages) {
+        for (int i = 0; i < StageTrack::kRingSize; i++) {
+            track.ringStart[i].store(0, std::memory_order_relaxed);
+            track.ringDuration[i].store(0, std::memory_order_relaxed);
+        }
+        for (std::atomic<uint32_t>& bucket : track.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        track.head.store(0, std::memory_order_relaxed);
+        track.maxNanos.store(0, std::memory_order_relaxed);
+    }
+}
+
+void stageRecord(StageStats& stats, Stage stage, int64_t startNanos, int64_t endNanos) {
+    StageTrack& track = stats.stages[stage];
+    int64_t duration = std::max<int64_t>(endNanos - startNanos, 0);
+
+    // Claiming the slot first lets several threads record the same stage. A
+    // reader racing a writer can see a slot's start and duration from
+    // different samples, which only matters for the ring, never the histogram.
+    uint32_t slot = track.head.fetch_add(1, std::memory_order_relaxed) % StageTrack::kRingSize;
+    track.ringStart[slot].store(startNanos, std::memory_order_relaxed);
+    track.ringDuration[slot].store(duration, std::memory_order_release);
+
+    track.buckets[bucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+    traceSpan(kStageNames[stage], startNanos, endNanos);
+
+    int64_t previous = track.maxNanos.load(std::memory_order_relaxed);
+    while (duration > previous &&
+           !track.maxNanos.compare_exchange_weak(previous, duration, std::memory_order_relaxed)) {
+    }
+}
+
+void stageRecordKernel(StageStats& stats, Stage stage, const CannyWorkspace& workspace,
+                       int64_t startNanos, int64_t endNanos) {
+    const int64_t* marks = workspace.phaseMarks;
+    stageRecord(stats, stage, startNanos, endNanos);
+    if (marks[3] == 0) {
+        return;  // The kernel returned before its phases (empty frame)
+    }
+    stageRecord(stats, STAGE_CANNY_GRADIENT, marks[0], marks[1]);
+    stageRecord(stats, STAGE_CANNY_HYSTERESIS, marks[1], marks[2]);
+    stageRecord(stats, STAGE_CANNY_OUTPUT, marks[2], marks[3]);
+}
+
+StageSummary stageSummary(const StageStats& stats, Stage stage, const StageBaseline* baseline) {
+    const StageTrack& track = stats.stages[stage];
+    StageSummary summary = {};
+
+    uint32_t counts[StageTrack::kBuckets];
+    int64_t total = 0;
+    int highest = -1;
+    for (int i = 0; i < StageTrack::kBuckets; i++) {
+        counts[i] = track.buckets[i].load(std::memory_order_relaxed);
+        if (baseline != nullptr) {
+            counts[i] -= baseline->buckets[stage][i];
+        }
+        total += counts[i];
+        if (counts[i] != 0) {
+            highest = i;
+        }
+    }
+    if (total == 0) {
+        return summary;
+    }
+
+    int64_t maxNanos = track.maxNanos.load(std::memory_order_relaxed);
+    if (baseline != nullptr) {
+        maxNanos = std::min(maxNanos, bucketUpperBound(highest));
+    }
+
+    // Percentile p is the smallest bucket bound with at least p * total samples under it
+    const double fractions[3] = {0.50, 0.90, 0.99};
+    int64_t* targets[3] = {&summary.p50Nanos, &summary.p90Nanos, &summary.p99Nanos};
+    int next = 0;
+    int64_t seen = 0;
+    for (int i = 0; i < StageTrack::kBuckets && next < 3; i++) {
+        seen += counts[i];
+        while (next < 3 && seen >= static_cast<int64_t>(fractions[next] * total + 0.999999)) {
+            *targets[next] = std::min(bucketUpperBound(i), maxNanos);
+            next++;
+        }
+    }
+
+    uint32_t head = track.head.load(std::memory_order_relaxed);
+    summary.count = total;
+    summary.maxNanos = maxNanos;
+    summary.lastNanos = track.ringDuration[(head - 1) % StageTrack::kRingSize].load(std::memory_order_acquire);
+    return summary;
+}
+
+void stageBaselineTake(const StageStats& stats, StageBaseline& baseline) {
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        for (int i = 0; i < StageTrack::kBuckets; i++) {
+            baseline.buckets[stage][i] = stats.stages[stage].buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void stageStatsPack(const StageStats& stats, const StageBaseline* baseline, int64_t* out) {
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        StageSummary summary = stageSummary(stats, static_cast<Stage>(stage), baseline);
+        int64_t* fields = out + stage * STAGE_FIELD_COUNT;
+        fields[STAGE_FIELD_SAMPLES] = summary.count;
+        fields[STAGE_FIELD_P50] = summary.p50Nanos;
+        fields[STAGE_FIELD_P90] = summary.p90Nanos;
+        fields[STAGE_FIELD_P99] = summary.p99Nanos;
+        fields[STAGE_FIELD_MAX] = summary.maxNanos;
+        fields[STAGE_FIELD_LAST] = summary.lastNanos;
+    }
+}
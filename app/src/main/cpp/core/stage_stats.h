@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+struct CannyWorkspace;
+
+// Per-stage latency instrumentation for the frame pipeline.
+//
+// Each stage keeps a ring of its most recent (start, duration) samples and a
+// log-bucketed histogram of every duration since start-up. Recording is a
+// handful of relaxed atomic operations with no locks or allocation, and any
+// thread may record any stage. Readers summarize a stage as count, p50, p90,
+// p99 and max; percentiles are the upper bound of their bucket, so within
+// 1/8 octave (about 9%) of the true value.
+enum Stage {
+    STAGE_FRAME = 0,           // Whole nativeOnDrawFrame
+    STAGE_FBO_RENDER,          // Camera texture into the FBO
+    STAGE_READBACK,            // glReadPixels or PBO map + copy
+    STAGE_CANNY,               // Kernel call on a read-back frame (worker)
+    STAGE_CANNY_GRADIENT,      // Luma, Sobel, non-max suppression, stripe hysteresis
+    STAGE_CANNY_HYSTERESIS,    // Cross-stripe hysteresis
+    STAGE_CANNY_OUTPUT,        // Final sweep to RGBA/gray/packed
+    STAGE_LUMA_CANNY,          // Kernel call on a camera Y plane (camera thread)
+    STAGE_GPU_CANNY,           // GLSL passes (GL command submission)
+    STAGE_UPLOAD,              // Edge texture upload
+    STAGE_DRAW,                // Final full-screen draw
+    STAGE_SWAP,                // eglSwapBuffers
+    STAGE_COUNT
+};
+
+// Short stage names, indexed by Stage
+extern const char* const kStageNames[STAGE_COUNT];
+
+// Fields per stage in stageStatsPack output
+enum StageField {
+    STAGE_FIELD_SAMPLES = 0,  // Samples recorded
+    STAGE_FIELD_P50,          // Nanoseconds
+    STAGE_FIELD_P90,
+    STAGE_FIELD_P99,
+    STAGE_FIELD_MAX,
+    STAGE_FIELD_LAST,         // Most recent sample
+    STAGE_FIELD_COUNT
+};
+
+struct StageSummary {
+    int64_t count;
+    int64_t p50Nanos;
+    int64_t p90Nanos;
+    int64_t p99Nanos;
+    int64_t maxNanos;
+    int64_t lastNanos;
+};
+
+struct StageTrack {
+    static constexpr int kRingSize = 128;
+    static constexpr int kBuckets = 256;
+
+    std::atomic<int64_t> ringStart[kRingSize];
+    std::atomic<int64_t> ringDuration[kRingSize];
+    std::atomic<uint32_t> head;  // Samples ever recorded; slot = head % kRingSize
+    std::atomic<uint32_t> buckets[kBuckets];
+    std::atomic<int64_t> maxNanos;
+};
+
+struct StageStats {
+    StageTrack stages[STAGE_COUNT];
+};
+
+// Reader-side copy of the histograms, used to report only what happened
+// since it was taken
+struct StageBaseline {
+    uint32_t buckets[STAGE_COUNT][StageTrack::kBuckets];
+};
+
+// Monotonic clock for stage timestamps
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Zeroes every ring and histogram. Not safe while other threads record.
+void stageStatsInit(StageStats& stats);
+
+// Records one sample of `stage` that ran from `startNanos` to `endNanos`,
+// and a span of the calling thread when tracing is enabled (trace.h)
+void stageRecord(StageStats& stats, Stage stage, int64_t startNanos, int64_t endNanos);
+
+// Records a kernel call that ran from `startNanos` to `endNanos` as `stage`
+// (STAGE_CANNY or STAGE_LUMA_CANNY), and the three phases it left in
+// `workspace` as STAGE_CANNY_GRADIENT, _HYSTERESIS and _OUTPUT, if it ran them
+void stageRecordKernel(StageStats& stats, Stage stage, const CannyWorkspace& workspace,
+                       int64_t startNanos, int64_t endNanos);
+
+// Summary of `stage`, counting only samples recorded after `baseline` was
+// taken (all samples when it is null). With a baseline, max is the bucket
+// bound of the slowest sample since, capped by the all-time exact max.
+StageSummary stageSummary(const StageStats& stats, Stage stage, const StageBaseline* baseline = nullptr);
+
+// Takes a baseline for later summaries
+void stageBaselineTake(const StageStats& stats, StageBaseline& baseline);
+
+// Writes STAGE_COUNT * STAGE_FIELD_COUNT values, stage-major in
+// StageField order, for a single JNI array transfer
+void stageStatsPack(const StageStats& stats, const StageBaseline* baseline, int64_t* out);
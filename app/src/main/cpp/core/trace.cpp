@@ -0,0 +1,152 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+// Every field is atomic because a slot can be written by a span that started
+// before traceEnable cleared the buffer. endNanos is written last and marks
+// the slot complete.
+struct TraceEvent {
+    std::atomic<const char*> name;
+    std::atomic<int64_t> beginNanos;
+    std::atomic<int64_t> endNanos;
+    std::atomic<uint32_t> threadId;
+};
+
+const int kMaxThreads = 64;
+
+std::atomic<bool> g_enabled{false};
+std::atomic<TraceEvent*> g_events{nullptr};
+std::atomic<size_t> g_next{0};
+std::atomic<size_t> g_dropped{0};
+std::atomic<uint32_t> g_threadCount{0};
+std::atomic<const char*> g_threadNames[kMaxThreads];
+
+// Small per-thread id, assigned on the thread's first span
+uint32_t currentThreadId() {
+    static thread_local uint32_t id = g_threadCount.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// Helper function to write a name as a JSON string. Names are plain ASCII, so
+// only quotes and backslashes need escaping.
+void writeJsonString(FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+}  // namespace
+
+void traceEnable() {
+    TraceEvent* events = g_events.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        // Never freed: spans in flight on other threads may still point into it
+        events = new TraceEvent[kTraceCapacity];
+        g_events.store(events, std::memory_order_release);
+    }
+    g_enabled.store(false, std::memory_order_relaxed);
+    for (size_t i = 0; i < kTraceCapacity; i++) {
+        events[i].endNanos.store(0, std::memory_order_relaxed);
+    }
+    g_next.store(0, std::memory_order_relaxed);
+    g_dropped.store(0, std::memory_order_relaxed);
+    g_enabled.store(true, std::memory_order_release);
+}
+
+void traceDisable() {
+    g_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool traceEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void traceSpan(const char* name, int64_t beginNanos, int64_t endNanos) {
+    if (!g_enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t slot = g_next.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= kTraceCapacity) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = g_events.load(std::memory_order_relaxed)[slot];
+    event.name.store(name, std::memory_order_relaxed);
+    event.beginNanos.store(beginNanos, std::memory_order_relaxed);
+    event.threadId.store(currentThreadId(), std::memory_order_relaxed);
+    event.endNanos.store(std::max(endNanos, beginNanos + 1), std::memory_order_release);
+}
+
+void traceSetThreadName(const char* name) {
+    uint32_t id = currentThreadId();
+    if (id < kMaxThreads) {
+        g_threadNames[id].store(name, std::memory_order_relaxed);
+    }
+}
+
+size_t traceEventCount() {
+    return std::min(g_next.load(std::memory_order_relaxed), kTraceCapacity);
+}
+
+size_t traceDroppedCount() {
+    return g_dropped.load(std::memory_order_relaxed);
+}
+
+bool traceWriteChromeJson(const char* path) {
+    std::unique_ptr<FILE, int (*)(FILE*)> file(std::fopen(path, "w"), std::fclose);
+    if (!file) {
+        return false;
+    }
+    FILE* out = file.get();
+    const TraceEvent* events = g_events.load(std::memory_order_acquire);
+    size_t count = traceEventCount();
+
+    // Timestamps relative to the earliest span keep the numbers short
+    int64_t origin = INT64_MAX;
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].endNanos.load(std::memory_order_acquire) != 0) {
+            origin = std::min(origin, events[i].beginNanos.load(std::memory_order_relaxed));
+        }
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    bool first = true;
+    uint32_t threads = std::min<uint32_t>(g_threadCount.load(std::memory_order_relaxed), kMaxThreads);
+    for (uint32_t id = 0; id < threads; id++) {
+        const char* name = g_threadNames[id].load(std::memory_order_relaxed);
+        if (name == nullptr) {
+            continue;
+        }
+        std::fprintf(out, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+                     first ? "" : ",\n", id);
+        writeJsonString(out, name);
+        std::fputs("}}", out);
+        first = false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const TraceEvent& event = events[i];
+        int64_t end = event.endNanos.load(std::memory_order_acquire);
+        if (end == 0) {
+            continue;  // Claimed but not written yet
+        }
+        int64_t begin = event.beginNanos.load(std::memory_order_relaxed);
+        std::fprintf(out, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":", first ? "" : ",\n",
+                     event.threadId.load(std::memory_order_relaxed));
+        writeJsonString(out, event.name.load(std::memory_order_relaxed));
+        // Chrome trace timestamps are microseconds
+        std::fprintf(out, ",\"ts\":%.3f,\"dur\":%.3f}", (begin - origin) / 1000.0, (end - begin) / 1000.0);
+        first = false;
+    }
+    std::fputs("\n]}\n", out);
+    return std::ferror(out) == 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Opt-in process-wide timeline tracer.
+//
+// Records complete spans (name, thread, begin, end) into a fixed-size buffer
+// that is allocated once, the first time tracing is enabled. Recording claims
+// a slot with one atomic increment and never locks or allocates; once the
+// buffer is full further spans are dropped and counted. While tracing is off
+// a span costs a single relaxed load.
+//
+// traceWriteChromeJson writes the spans as Chrome trace-event JSON, which
+// chrome://tracing and the Perfetto UI (ui.perfetto.dev) both load. It can be
+// called while spans are still being recorded.
+//
+// Span and thread names must be string literals or otherwise outlive the trace.
+
+// Spans the buffer holds (32 bytes each)
+const size_t kTraceCapacity = 1 << 16;
+
+// Clears the buffer and starts recording
+void traceEnable();
+
+// Stops recording; recorded spans stay available for writing
+void traceDisable();
+
+bool traceEnabled();
+
+// Records a span of the calling thread, timestamps from monotonicNanos()
+void traceSpan(const char* name, int64_t beginNanos, int64_t endNanos);
+
+// Names the calling thread in the trace (e.g. "render", "edge_worker")
+void traceSetThreadName(const char* name);
+
+// Spans recorded since traceEnable, and spans dropped because the buffer was full
+size_t traceEventCount();
+size_t traceDroppedCount();
+
+// Writes every recorded span to `path`. Returns false if the file can't be written.
+bool traceWriteChromeJson(const char* path);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single-producer/single-consumer triple buffer.
+//
+// The producer fills back() and calls publish(), which swaps it with the
+// shared middle slot. The consumer calls update() to swap the middle slot into
+// front() when something newer was published. Neither side ever waits for the
+// other: the producer always has a free slot to write, and the consumer always
+// sees the most recently published value (older unconsumed ones are dropped).
+template <typename T>
+struct TripleBuffer {
+    // Producer side
+    T& back() {
+        return slots[backIndex];
+    }
+
+    void publish() {
+        int previous = middle.exchange(backIndex | kFresh, std::memory_order_acq_rel);
+        backIndex = previous & kIndexMask;
+    }
+
+    // Consumer side. Returns true if front() now holds a newly published value.
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & kIndexMask;
+        return true;
+    }
+
+    T& front() {
+        return slots[frontIndex];
+    }
+
+    static constexpr int kIndexMask = 3;
+    static constexpr int kFresh = 4;  // Middle slot holds an unconsumed value
+
+    T slots[3];
+    std::atomic<int> middle{1};
+    int backIndex = 2;   // Owned by the producer
+    int frontIndex = 0;  // Owned by the consumer
+};
@@ -0,0 +1,64 @@
+#include "edge_program.h"
+
+#include "gl_program.h"
+
+namespace {
+
+// Pixel columns above 2048 need more than mediump's 11-bit integer range
+const char* kEdgeFragmentSource = R"(
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+uniform sampler2D uTexture;
+uniform bool uPacked;
+uniform float uWidth;
+uniform vec4 uEdgeColor;
+varying vec2 vTexCoord;
+void main() {
+    float edge;
+    if (uPacked) {
+        float x = clamp(floor(vTexCoord.x * uWidth), 0.0, uWidth - 1.0);
+        float byteIndex = floor(x / 8.0);
+        float bytes = ceil(uWidth / 8.0);
+        float value = floor(texture2D(uTexture, vec2((byteIndex + 0.5) / bytes, vTexCoord.y)).r * 255.0 + 0.5);
+        edge = mod(floor(value / exp2(x - byteIndex * 8.0)), 2.0);
+    } else {
+        edge = texture2D(uTexture, vTexCoord).r;
+    }
+    gl_FragColor = mix(vec4(0.0, 0.0, 0.0, 1.0), uEdgeColor, edge);
+}
+)";
+
+}  // namespace
+
+bool edgeProgramInit(EdgeProgram& edge, const char* vertexSource) {
+    edge = EdgeProgram();
+    edge.program = createProgram(vertexSource, kEdgeFragmentSource);
+    if (edge.program == 0) {
+        return false;
+    }
+    edge.textureLoc = glGetUniformLocation(edge.program, "uTexture");
+    edge.packedLoc = glGetUniformLocation(edge.program, "uPacked");
+    edge.widthLoc = glGetUniformLocation(edge.program, "uWidth");
+    edge.edgeColorLoc = glGetUniformLocation(edge.program, "uEdgeColor");
+    return true;
+}
+
+void edgeProgramDestroy(EdgeProgram& edge) {
+    if (edge.program != 0) {
+        glDeleteProgram(edge.program);
+    }
+    edge = EdgeProgram();
+}
+
+void edgeProgramUse(const EdgeProgram& edge, GLuint texture, bool packed, int width, const float color[4]) {
+    glUseProgram(edge.program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(edge.textureLoc, 0);
+    glUniform1i(edge.packedLoc, packed ? 1 : 0);
+    glUniform1f(edge.widthLoc, static_cast<GLfloat>(width));
+    glUniform4fv(edge.edgeColorLoc, 1, color);
+}
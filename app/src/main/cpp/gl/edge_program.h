@@ -0,0 +1,32 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// Display program for edge maps.
+//
+// Edge textures come in three layouts: RGBA (the GPU backend and the original
+// CPU path), single channel GL_LUMINANCE (4x smaller uploads) and bit-packed,
+// where each byte of a GL_LUMINANCE texture holds 8 pixels, leftmost in bit 0
+// (32x smaller). The fragment shader reads the red channel or extracts the
+// pixel's bit, then paints edges in a configurable color over black.
+//
+// GLSL ES 1.00, so it works on every context the renderer supports. The
+// vertex shader is the caller's and must pass the texture coordinate to the
+// fragment stage as `vTexCoord`.
+struct EdgeProgram {
+    GLuint program;
+    GLint textureLoc;
+    GLint packedLoc;
+    GLint widthLoc;
+    GLint edgeColorLoc;
+};
+
+// Links the edge fragment shader with `vertexSource`. Returns false on error.
+bool edgeProgramInit(EdgeProgram& edge, const char* vertexSource);
+
+void edgeProgramDestroy(EdgeProgram& edge);
+
+// Makes the program current and binds `texture` to unit 0. `width` is the edge
+// map width in pixels, which for a packed texture is up to 8x the texture
+// width. `color` is RGBA in 0..1. Packed textures must use GL_NEAREST filtering.
+void edgeProgramUse(const EdgeProgram& edge, GLuint texture, bool packed, int width, const float color[4]);
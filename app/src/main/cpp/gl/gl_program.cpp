@@ -0,0 +1,81 @@
+#include "gl_program.h"
+
+#include <cstdio>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define logError(...) __android_log_print(ANDROID_LOG_ERROR, "GLProgram", __VA_ARGS__)
+#else
+#define logError(...) (std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
+
+// Helper function to compile shader
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    
+    GLint compiled;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        GLint infoLen = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
+        if (infoLen > 1) {
+            char* infoLog = new char[infoLen];
+            glGetShaderInfoLog(shader, infoLen, nullptr, infoLog);
+            logError("shader compile failed: %s", infoLog);
+            delete[] infoLog;
+        }
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Helper function to create shader program
+GLuint createProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    if (vertexShader == 0) return 0;
+    
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        return 0;
+    }
+    
+    GLuint program = glCreateProgram();
+    if (program == 0) return 0;
+    
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    
+    GLint linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GLint infoLen = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLen);
+        if (infoLen > 1) {
+            char* infoLog = new char[infoLen];
+            glGetProgramInfoLog(program, infoLen, nullptr, infoLog);
+            logError("program link failed: %s", infoLog);
+            delete[] infoLog;
+        }
+        glDeleteProgram(program);
+        return 0;
+    }
+    
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    
+    return program;
+}
+
+int glesMajorVersion() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int major = 0;
+    if (version == nullptr || std::sscanf(version, "OpenGL ES %d", &major) != 1) {
+        return 0;
+    }
+    return major;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// Compiles a single shader stage. Returns 0 on failure.
+GLuint compileShader(GLenum type, const char* source);
+
+// Links a vertex/fragment shader pair into a program. Returns 0 on failure.
+GLuint createProgram(const char* vertexSource, const char* fragmentSource);
+
+// Major OpenGL ES version of the current context (2 or 3), 0 without a context
+int glesMajorVersion();
@@ -0,0 +1,374 @@
+#include "gpu_canny.h"
+
+#include "gl_program.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+namespace {
+
+// Luma pass. GLSL ES 1.00 so it can sample the camera's external texture
+// without GL_OES_EGL_image_external_essl3.
+const char* kLumaVertexSource = R"(
+attribute vec2 aPosition;
+varying vec2 vTexCoord;
+void main() {
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+    vTexCoord = aPosition * 0.5 + 0.5;
+}
+)";
+
+const char* kLumaExternalHeader = R"(
+#extension GL_OES_EGL_image_external : require
+precision highp float;
+uniform samplerExternalOES uTexture;
+)";
+
+const char* kLuma2DHeader = R"(
+precision highp float;
+uniform sampler2D uTexture;
+)";
+
+// Fixed-point BT.601 weights of the CPU kernel (14-bit), exact in highp float
+const char* kLumaFragmentBody = R"(
+varying vec2 vTexCoord;
+void main() {
+    vec3 c = floor(texture2D(uTexture, vTexCoord).rgb * 255.0 + 0.5);
+    float y = floor((c.r * 4899.0 + c.g * 9617.0 + c.b * 1868.0 + 8192.0) / 16384.0);
+    gl_FragColor = vec4(y / 255.0, 0.0, 0.0, 1.0);
+}
+)";
+
+// Remaining passes address texels directly with texelFetch
+const char* kPassVertexSource = R"(#version 300 es
+in vec2 aPosition;
+void main() {
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+}
+)";
+
+// 3x3 Gaussian [1 2 1]^2 / 16 with rounding and replicated borders
+const char* kBlurFragmentSource = R"(#version 300 es
+precision highp float;
+precision highp int;
+uniform highp sampler2D uTexture;
+out vec4 fragColor;
+int gray(ivec2 p, ivec2 maxP) {
+    return int(texelFetch(uTexture, clamp(p, ivec2(0), maxP), 0).r * 255.0 + 0.5);
+}
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 maxP = textureSize(uTexture, 0) - 1;
+    int sum = gray(p + ivec2(-1, -1), maxP) + 2 * gray(p + ivec2(0, -1), maxP) + gray(p + ivec2(1, -1), maxP)
+            + 2 * gray(p + ivec2(-1, 0), maxP) + 4 * gray(p, maxP) + 2 * gray(p + ivec2(1, 0), maxP)
+            + gray(p + ivec2(-1, 1), maxP) + 2 * gray(p + ivec2(0, 1), maxP) + gray(p + ivec2(1, 1), maxP);
+    fragColor = vec4(float((sum + 8) >> 4) / 255.0, 0.0, 0.0, 1.0);
+}
+)";
+
+// Sobel with replicated borders. Packs the L1 magnitude and the direction
+// class of the CPU kernel's tan(22.5) test: 0 horizontal, 1 vertical,
+// 2 diagonal (dx, dy same sign), 3 diagonal (opposite signs).
+const char* kGradientFragmentSource = R"(#version 300 es
+precision highp float;
+precision highp int;
+uniform highp sampler2D uTexture;
+out uvec4 fragValue;
+const int kCannyShift = 15;
+const int kTg22 = 13573;
+int gray(ivec2 p, ivec2 maxP) {
+    return int(texelFetch(uTexture, clamp(p, ivec2(0), maxP), 0).r * 255.0 + 0.5);
+}
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 maxP = textureSize(uTexture, 0) - 1;
+    int a0 = gray(p + ivec2(-1, -1), maxP);
+    int a1 = gray(p + ivec2(0, -1), maxP);
+    int a2 = gray(p + ivec2(1, -1), maxP);
+    int b0 = gray(p + ivec2(-1, 0), maxP);
+    int b2 = gray(p + ivec2(1, 0), maxP);
+    int c0 = gray(p + ivec2(-1, 1), maxP);
+    int c1 = gray(p + ivec2(0, 1), maxP);
+    int c2 = gray(p + ivec2(1, 1), maxP);
+    int dx = (a2 + 2 * b2 + c2) - (a0 + 2 * b0 + c0);
+    int dy = (c0 + 2 * c1 + c2) - (a0 + 2 * a1 + a2);
+
+    int x = abs(dx);
+    int y = abs(dy) << kCannyShift;
+    int tg22x = x * kTg22;
+    int tg67x = tg22x + (x << (kCannyShift + 1));
+    uint dir = y < tg22x ? 0u : (y > tg67x ? 1u : ((dx < 0) != (dy < 0) ? 3u : 2u));
+    fragValue = uvec4((uint(x + abs(dy)) << 2) | dir, 0u, 0u, 0u);
+}
+)";
+
+// Non-max suppression and double threshold: 0 none, 1 weak, 2 strong.
+// Magnitudes outside the image count as zero, as on the CPU.
+const char* kNmsFragmentSource = R"(#version 300 es
+precision highp float;
+precision highp int;
+uniform highp usampler2D uTexture;
+uniform int uLow;
+uniform int uHigh;
+out uvec4 fragValue;
+int mag(ivec2 p, ivec2 size) {
+    if (any(lessThan(p, ivec2(0))) || any(greaterThanEqual(p, size))) {
+        return 0;
+    }
+    return int(texelFetch(uTexture, p, 0).r >> 2);
+}
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(uTexture, 0);
+    uint g = texelFetch(uTexture, p, 0).r;
+    int m = int(g >> 2);
+    uint dir = g & 3u;
+
+    bool isMax;
+    if (dir == 0u) {
+        isMax = m > mag(p + ivec2(-1, 0), size) && m >= mag(p + ivec2(1, 0), size);
+    } else if (dir == 1u) {
+        isMax = m > mag(p + ivec2(0, -1), size) && m >= mag(p + ivec2(0, 1), size);
+    } else {
+        int s = dir == 3u ? -1 : 1;
+        isMax = m > mag(p + ivec2(-s, -1), size) && m > mag(p + ivec2(s, 1), size);
+    }
+
+    uint edge = (m > uLow && isMax) ? (m > uHigh ? 2u : 1u) : 0u;
+    fragValue = uvec4(edge, 0u, 0u, 0u);
+}
+)";
+
+// One hysteresis step: weak pixels touching a strong one become strong
+const char* kHysteresisFragmentSource = R"(#version 300 es
+precision highp float;
+precision highp int;
+uniform highp usampler2D uTexture;
+out uvec4 fragValue;
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 maxP = textureSize(uTexture, 0) - 1;
+    uint v = texelFetch(uTexture, p, 0).r;
+    if (v == 1u) {
+        for (int j = -1; j <= 1; j++) {
+            for (int i = -1; i <= 1; i++) {
+                ivec2 q = p + ivec2(i, j);
+                if (all(greaterThanEqual(q, ivec2(0))) && all(lessThanEqual(q, maxP)) &&
+                    texelFetch(uTexture, q, 0).r == 2u) {
+                    v = 2u;
+                }
+            }
+        }
+    }
+    fragValue = uvec4(v, 0u, 0u, 0u);
+}
+)";
+
+const char* kResolveFragmentSource = R"(#version 300 es
+precision highp float;
+precision highp int;
+uniform highp usampler2D uTexture;
+out vec4 fragColor;
+void main() {
+    float edge = texelFetch(uTexture, ivec2(gl_FragCoord.xy), 0).r == 2u ? 1.0 : 0.0;
+    fragColor = vec4(edge, edge, edge, 1.0);
+}
+)";
+
+// Single triangle covering the viewport
+const GLfloat kFullScreenTriangle[] = {
+    -1.0f, -1.0f,
+     3.0f, -1.0f,
+    -1.0f,  3.0f,
+};
+
+const GLenum kTargetFormats[GpuCanny::kTargetCount] = {
+    GL_R8,     // kLuma
+    GL_R8,     // kBlurred
+    GL_R16UI,  // kGradient
+    GL_R8UI,   // kEdgesA
+    GL_R8UI,   // kEdgesB
+    GL_RGBA8,  // kOutput
+};
+
+void releaseTargets(GpuCanny& canny) {
+    glDeleteFramebuffers(GpuCanny::kTargetCount, canny.fbos);
+    glDeleteTextures(GpuCanny::kTargetCount, canny.textures);
+    std::fill(canny.fbos, canny.fbos + GpuCanny::kTargetCount, 0u);
+    std::fill(canny.textures, canny.textures + GpuCanny::kTargetCount, 0u);
+    canny.width = 0;
+    canny.height = 0;
+}
+
+// Draws `pass` into `target`, reading `source` on texture unit 0
+void runPass(const GpuCanny& canny, GpuCanny::Pass pass, GpuCanny::Target target,
+             GLenum sourceTarget, GLuint source) {
+    glBindFramebuffer(GL_FRAMEBUFFER, canny.fbos[target]);
+    glUseProgram(canny.programs[pass]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(sourceTarget, source);
+
+    GLint positionLoc = canny.positionLocs[pass];
+    glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(positionLoc);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDisableVertexAttribArray(positionLoc);
+}
+
+}  // namespace
+
+bool gpuCannySupported() {
+    return glesMajorVersion() >= 3;
+}
+
+bool gpuCannyInit(GpuCanny& canny, GLenum inputTarget) {
+    canny = GpuCanny();
+    canny.inputTarget = inputTarget;
+    canny.edges = GpuCanny::kEdgesA;
+    if (!gpuCannySupported()) {
+        return false;
+    }
+
+    std::string lumaSource = inputTarget == GL_TEXTURE_EXTERNAL_OES ? kLumaExternalHeader : kLuma2DHeader;
+    lumaSource += kLumaFragmentBody;
+
+    const std::pair<const char*, const char*> sources[GpuCanny::kPassCount] = {
+        {kLumaVertexSource, lumaSource.c_str()},
+        {kPassVertexSource, kBlurFragmentSource},
+        {kPassVertexSource, kGradientFragmentSource},
+        {kPassVertexSource, kNmsFragmentSource},
+        {kPassVertexSource, kHysteresisFragmentSource},
+        {kPassVertexSource, kResolveFragmentSource},
+    };
+    for (int i = 0; i < GpuCanny::kPassCount; i++) {
+        canny.programs[i] = createProgram(sources[i].first, sources[i].second);
+        if (canny.programs[i] == 0) {
+            gpuCannyDestroy(canny);
+            return false;
+        }
+        canny.positionLocs[i] = glGetAttribLocation(canny.programs[i], "aPosition");
+        glUseProgram(canny.programs[i]);
+        glUniform1i(glGetUniformLocation(canny.programs[i], "uTexture"), 0);
+    }
+    canny.lowLoc = glGetUniformLocation(canny.programs[GpuCanny::kNmsPass], "uLow");
+    canny.highLoc = glGetUniformLocation(canny.programs[GpuCanny::kNmsPass], "uHigh");
+    glUseProgram(0);
+
+    glGenBuffers(1, &canny.quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, canny.quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kFullScreenTriangle), kFullScreenTriangle, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+bool gpuCannyResize(GpuCanny& canny, int width, int height) {
+    if (canny.programs[0] == 0 || width <= 0 || height <= 0) {
+        return false;
+    }
+    if (canny.width == width && canny.height == height) {
+        return true;
+    }
+
+    releaseTargets(canny);
+    glGenTextures(GpuCanny::kTargetCount, canny.textures);
+    glGenFramebuffers(GpuCanny::kTargetCount, canny.fbos);
+
+    bool complete = true;
+    for (int i = 0; i < GpuCanny::kTargetCount; i++) {
+        // Integer textures are only complete with NEAREST filtering; the
+        // passes use texelFetch anyway. The output is sampled for display.
+        GLint filter = i == GpuCanny::kOutput ? GL_LINEAR : GL_NEAREST;
+        glBindTexture(GL_TEXTURE_2D, canny.textures[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, kTargetFormats[i], width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, canny.fbos[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, canny.textures[i], 0);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        releaseTargets(canny);
+        return false;
+    }
+    canny.width = width;
+    canny.height = height;
+    return true;
+}
+
+void gpuCannyDestroy(GpuCanny& canny) {
+    releaseTargets(canny);
+    for (int i = 0; i < GpuCanny::kPassCount; i++) {
+        if (canny.programs[i] != 0) {
+            glDeleteProgram(canny.programs[i]);
+        }
+    }
+    if (canny.quadBuffer != 0) {
+        glDeleteBuffers(1, &canny.quadBuffer);
+    }
+    canny = GpuCanny();
+}
+
+GLuint gpuCannyRun(GpuCanny& canny, GLuint inputTexture, const GpuCannyParams& params) {
+    if (canny.width == 0) {
+        return 0;
+    }
+    int low = std::min(params.lowThreshold, params.highThreshold);
+    int high = std::max(params.lowThreshold, params.highThreshold);
+
+    glViewport(0, 0, canny.width, canny.height);
+    glBindBuffer(GL_ARRAY_BUFFER, canny.quadBuffer);
+
+    runPass(canny, GpuCanny::kLumaPass, GpuCanny::kLuma, canny.inputTarget, inputTexture);
+    GpuCanny::Target gray = GpuCanny::kLuma;
+    if (params.blur) {
+        runPass(canny, GpuCanny::kBlurPass, GpuCanny::kBlurred, GL_TEXTURE_2D, canny.textures[gray]);
+        gray = GpuCanny::kBlurred;
+    }
+    runPass(canny, GpuCanny::kGradientPass, GpuCanny::kGradient, GL_TEXTURE_2D, canny.textures[gray]);
+
+    glUseProgram(canny.programs[GpuCanny::kNmsPass]);
+    glUniform1i(canny.lowLoc, low);
+    glUniform1i(canny.highLoc, high);
+    runPass(canny, GpuCanny::kNmsPass, GpuCanny::kEdgesA, GL_TEXTURE_2D, canny.textures[GpuCanny::kGradient]);
+    canny.edges = GpuCanny::kEdgesA;
+
+    gpuCannyHysteresis(canny, params.hysteresisPasses);
+    return gpuCannyResolve(canny);
+}
+
+void gpuCannyHysteresis(GpuCanny& canny, int passes) {
+    if (canny.width == 0) {
+        return;
+    }
+    glViewport(0, 0, canny.width, canny.height);
+    glBindBuffer(GL_ARRAY_BUFFER, canny.quadBuffer);
+    for (int i = 0; i < passes; i++) {
+        GpuCanny::Target next = canny.edges == GpuCanny::kEdgesA ? GpuCanny::kEdgesB : GpuCanny::kEdgesA;
+        runPass(canny, GpuCanny::kHysteresisPass, next, GL_TEXTURE_2D, canny.textures[canny.edges]);
+        canny.edges = next;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint gpuCannyResolve(GpuCanny& canny) {
+    if (canny.width == 0) {
+        return 0;
+    }
+    glViewport(0, 0, canny.width, canny.height);
+    glBindBuffer(GL_ARRAY_BUFFER, canny.quadBuffer);
+    runPass(canny, GpuCanny::kResolvePass, GpuCanny::kOutput, GL_TEXTURE_2D, canny.textures[canny.edges]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return canny.textures[GpuCanny::kOutput];
+}
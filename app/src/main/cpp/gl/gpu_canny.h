@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// Canny edge detection entirely on the GPU (OpenGL ES 3.0).
+//
+// The camera texture goes through a chain of full-screen passes, each
+// rendering into its own texture:
+//
+//   luma (R8) -> 3x3 Gaussian (R8, optional) -> Sobel magnitude + quantized
+//   direction (R16UI) -> non-max suppression + double threshold (R8UI)
+//   -> N hysteresis passes (R8UI ping-pong) -> RGBA output
+//
+// All arithmetic is integer-exact and follows the CPU kernel (same luma
+// weights, L1 magnitude, tan(22.5) fixed-point direction test and tie
+// breaking). The passes walk the texture's stored rows, i.e. GL order from
+// the bottom. With hysteresis run to convergence the output therefore equals:
+//
+//   - blur off: fusedCanny on the same rows with `bottomUp` false;
+//   - blur on: cv::Canny (L1) on that luma after this rounded 3x3 Gaussian
+//     with replicated border. EdgeParams::blurAperture uses cv::GaussianBlur
+//     and is not bit-exact with it.
+//
+// gl_bench checks both. The renderer's readback path runs fusedCanny with
+// `bottomUp` set, walking the rows upright, so vertical non-max suppression
+// ties break the other way and the two backends can differ by a pixel along
+// such edges. Each hysteresis pass grows strong edges by one pixel; chains
+// longer than the pass count are cut short, which is the trade for never
+// leaving the GPU.
+struct GpuCannyParams {
+    int lowThreshold = 50;
+    int highThreshold = 150;
+    bool blur = true;           // 3x3 Gaussian before the gradient
+    int hysteresisPasses = 16;
+};
+
+struct GpuCanny {
+    enum Target { kLuma, kBlurred, kGradient, kEdgesA, kEdgesB, kOutput, kTargetCount };
+    enum Pass { kLumaPass, kBlurPass, kGradientPass, kNmsPass, kHysteresisPass, kResolvePass, kPassCount };
+
+    GLuint programs[kPassCount];
+    GLint positionLocs[kPassCount];
+    GLint lowLoc;   // NMS pass thresholds
+    GLint highLoc;
+    GLuint textures[kTargetCount];
+    GLuint fbos[kTargetCount];
+    GLuint quadBuffer;
+    GLenum inputTarget;  // GL_TEXTURE_EXTERNAL_OES or GL_TEXTURE_2D
+    int width;
+    int height;
+    int edges;  // kEdgesA or kEdgesB: the current edge map
+};
+
+// True when the current context can run the GPU pipeline (OpenGL ES 3.0+)
+bool gpuCannySupported();
+
+// Compiles the pass programs. `inputTarget` is the target of the textures
+// later passed to gpuCannyRun. Returns false if unsupported or on error.
+bool gpuCannyInit(GpuCanny& canny, GLenum inputTarget);
+
+// (Re)allocates the intermediate textures; cheap when the size is unchanged
+bool gpuCannyResize(GpuCanny& canny, int width, int height);
+
+void gpuCannyDestroy(GpuCanny& canny);
+
+// Runs every pass on `inputTexture` and returns the RGBA output texture
+// (white edges on black, same row order as the input). Leaves the default
+// framebuffer bound; the caller restores its viewport.
+GLuint gpuCannyRun(GpuCanny& canny, GLuint inputTexture, const GpuCannyParams& params);
+
+// Runs `passes` more hysteresis passes on the current edge map
+void gpuCannyHysteresis(GpuCanny& canny, int passes);
+
+// Writes the current edge map to the output texture and returns it
+GLuint gpuCannyResolve(GpuCanny& canny);
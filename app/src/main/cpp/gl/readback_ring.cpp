@@ -0,0 +1,151 @@
+#include "readback_ring.h"
+
+#include "gl_program.h"
+
+#include <algorithm>
+
+namespace {
+
+// Upper bound for a blocking wait on a readback fence
+const GLuint64 kFenceTimeoutNs = 100 * 1000 * 1000;
+
+int slotAt(const ReadbackRing& ring, int offset) {
+    return (ring.head + offset) % ring.depth;
+}
+
+GLsizeiptr bufferSize(const ReadbackRing& ring) {
+    return static_cast<GLsizeiptr>(ring.width) * ring.height * 4;
+}
+
+bool fenceSignaled(GLsync fence, bool wait) {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? kFenceTimeoutNs : 0);
+    return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void dropOldest(ReadbackRing& ring) {
+    int slot = ring.head;
+    glDeleteSync(ring.fences[slot]);
+    ring.fences[slot] = nullptr;
+    ring.head = (ring.head + 1) % ring.depth;
+    ring.pending--;
+}
+
+}  // namespace
+
+bool readbackRingSupported() {
+    return glesMajorVersion() >= 3;
+}
+
+bool readbackRingInit(ReadbackRing& ring, int width, int height, int depth) {
+    ring = ReadbackRing();
+    ring.mappedSlot = -1;
+    if (width <= 0 || height <= 0 || !readbackRingSupported()) {
+        return false;
+    }
+
+    ring.depth = std::max(2, std::min(depth, ReadbackRing::kMaxDepth));
+    ring.width = width;
+    ring.height = height;
+
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    glGenBuffers(ring.depth, ring.buffers);
+    for (int i = 0; i < ring.depth; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize(ring), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        readbackRingDestroy(ring);
+        return false;
+    }
+    return true;
+}
+
+void readbackRingDestroy(ReadbackRing& ring) {
+    readbackRingRelease(ring);
+    while (ring.pending > 0) {
+        dropOldest(ring);
+    }
+    if (ring.depth > 0) {
+        glDeleteBuffers(ring.depth, ring.buffers);
+    }
+    ring = ReadbackRing();
+    ring.mappedSlot = -1;
+}
+
+void readbackRingQueue(ReadbackRing& ring, int64_t frameId) {
+    if (ring.depth == 0) {
+        return;
+    }
+    if (ring.pending == ring.depth) {
+        // Every buffer is in flight: the consumer has fallen behind
+        fenceSignaled(ring.fences[ring.head], true);
+        dropOldest(ring);
+    }
+
+    int slot = slotAt(ring, ring.pending);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[slot]);
+    glReadPixels(0, 0, ring.width, ring.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    ring.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring.frameIds[slot] = frameId;
+    ring.pending++;
+}
+
+const unsigned char* readbackRingAcquire(ReadbackRing& ring, int64_t currentFrameId,
+                                         int64_t* frameId, bool wait) {
+    if (ring.mappedSlot >= 0 || ring.pending == 0) {
+        return nullptr;
+    }
+
+    // Transfers complete in order, so the newest signalled fence implies all
+    // older ones. Reads queued this frame are left alone so they overlap the
+    // rest of the frame instead of forcing a flush and wait.
+    int newest = ring.pending - 1;
+    while (newest >= 0 && ring.frameIds[slotAt(ring, newest)] >= currentFrameId) {
+        newest--;
+    }
+    int ready = -1;
+    for (int i = newest; i >= 0; i--) {
+        if (fenceSignaled(ring.fences[slotAt(ring, i)], wait && i == newest)) {
+            ready = i;
+            break;
+        }
+    }
+    if (ready < 0) {
+        return nullptr;
+    }
+    for (int i = 0; i < ready; i++) {
+        dropOldest(ring);
+    }
+
+    int slot = ring.head;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[slot]);
+    void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize(ring), GL_MAP_READ_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (pixels == nullptr) {
+        dropOldest(ring);
+        return nullptr;
+    }
+
+    ring.mappedSlot = slot;
+    ring.latencyFrames = static_cast<int>(currentFrameId - ring.frameIds[slot]);
+    if (frameId != nullptr) {
+        *frameId = ring.frameIds[slot];
+    }
+    return static_cast<const unsigned char*>(pixels);
+}
+
+void readbackRingRelease(ReadbackRing& ring) {
+    if (ring.mappedSlot < 0) {
+        return;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.buffers[ring.mappedSlot]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    ring.mappedSlot = -1;
+    dropOldest(ring);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+
+// Asynchronous glReadPixels through a ring of GLES3 pixel buffer objects.
+//
+// Each frame queues a read of the bound framebuffer into the next buffer and
+// fences it. The CPU only maps buffers whose fence has already signalled, so
+// frame N's transfer overlaps frame N+1's rendering instead of stalling the
+// pipeline. The price is latency: the edge frame shown is `latencyFrames`
+// frames older than the camera frame that was just rendered.
+struct ReadbackRing {
+    static constexpr int kMaxDepth = 3;
+
+    GLuint buffers[kMaxDepth];
+    GLsync fences[kMaxDepth];
+    int64_t frameIds[kMaxDepth];
+
+    int depth;
+    int width;
+    int height;
+    int head;     // Oldest in-flight slot
+    int pending;  // Number of in-flight slots
+    int mappedSlot;  // Slot currently mapped by readbackRingAcquire, or -1
+    int latencyFrames;  // Frames between queue and acquire for the last acquired buffer
+};
+
+// True when the current context supports PBOs and fences (OpenGL ES 3.0+)
+bool readbackRingSupported();
+
+// Creates `depth` (2..kMaxDepth) RGBA buffers of width x height. Returns false
+// and leaves the ring empty if the context cannot provide them.
+bool readbackRingInit(ReadbackRing& ring, int width, int height, int depth);
+
+void readbackRingDestroy(ReadbackRing& ring);
+
+// Starts an asynchronous RGBA read of the framebuffer bound to GL_READ_FRAMEBUFFER.
+// When every slot is in flight the oldest one is waited on and dropped first.
+void readbackRingQueue(ReadbackRing& ring, int64_t frameId);
+
+// Maps the newest buffer queued before `currentFrameId` whose transfer has
+// completed and drops any older ones. Returns nullptr without blocking if
+// nothing is ready yet, unless `wait` is set. The pointer stays valid until
+// readbackRingRelease.
+const unsigned char* readbackRingAcquire(ReadbackRing& ring, int64_t currentFrameId,
+                                         int64_t* frameId, bool wait = false);
+
+void readbackRingRelease(ReadbackRing& ring);
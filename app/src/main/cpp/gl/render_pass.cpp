@@ -0,0 +1,107 @@
+#include "render_pass.h"
+
+#include <cmath>
+
+const char* const kQuadVertexSource = R"(
+attribute vec4 aPosition;
+attribute vec2 aTexCoord;
+uniform mat2 uTexTransform;
+varying vec2 vTexCoord;
+void main() {
+    gl_Position = aPosition;
+
+    // Rotation, front camera mirroring and top-down flip, about the texture center
+    vTexCoord = uTexTransform * (aTexCoord - 0.5) + 0.5;
+}
+)";
+
+namespace {
+
+const GLsizei kVertexStride = 5 * sizeof(float);
+
+}  // namespace
+
+GLuint quadBufferCreate() {
+    const float vertices[] = {
+        -1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+         1.0f, -1.0f, 0.0f,  1.0f, 0.0f,
+        -1.0f,  1.0f, 0.0f,  0.0f, 1.0f,
+         1.0f,  1.0f, 0.0f,  1.0f, 1.0f
+    };
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    if (buffer == 0) {
+        return 0;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return buffer;
+}
+
+bool renderPassInit(RenderPass& pass, GLuint program) {
+    pass = RenderPass();
+    pass.program = program;
+    if (program == 0) {
+        return false;
+    }
+    pass.positionLoc = glGetAttribLocation(program, "aPosition");
+    pass.texCoordLoc = glGetAttribLocation(program, "aTexCoord");
+    pass.texTransformLoc = glGetUniformLocation(program, "uTexTransform");
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uTexture"), 0);
+    float identity[4];
+    renderPassTransform(0, false, false, identity);
+    glUniformMatrix2fv(pass.texTransformLoc, 1, GL_FALSE, identity);
+    return true;
+}
+
+void renderPassSetOrientation(RenderPass& pass, int rotation, bool mirrored, bool topDown) {
+    if (rotation == pass.rotation && mirrored == pass.mirrored && topDown == pass.topDown) {
+        return;
+    }
+    float matrix[4];
+    renderPassTransform(rotation, mirrored, topDown, matrix);
+    glUniformMatrix2fv(pass.texTransformLoc, 1, GL_FALSE, matrix);
+    pass.rotation = rotation;
+    pass.mirrored = mirrored;
+    pass.topDown = topDown;
+}
+
+void renderPassDraw(const RenderPass& pass, GLuint quadBuffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glVertexAttribPointer(pass.positionLoc, 3, GL_FLOAT, GL_FALSE, kVertexStride, nullptr);
+    glVertexAttribPointer(pass.texCoordLoc, 2, GL_FLOAT, GL_FALSE, kVertexStride,
+                          reinterpret_cast<const void*>(3 * sizeof(float)));
+    glEnableVertexAttribArray(pass.positionLoc);
+    glEnableVertexAttribArray(pass.texCoordLoc);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(pass.positionLoc);
+    glDisableVertexAttribArray(pass.texCoordLoc);
+}
+
+void renderPassTransform(int rotation, bool mirrored, bool topDown, float matrix[4]) {
+    // Quarter turns get exact 0/1 entries, so texels land on the same pixels as unrotated
+    float cosA = 0.0f;
+    float sinA = 0.0f;
+    switch (((rotation % 360) + 360) % 360) {
+        case 0: cosA = 1.0f; break;
+        case 90: sinA = 1.0f; break;
+        case 180: cosA = -1.0f; break;
+        case 270: sinA = -1.0f; break;
+        default: {
+            double angle = rotation * 3.14159265358979323846 / 180.0;
+            cosA = static_cast<float>(std::cos(angle));
+            sinA = static_cast<float>(std::sin(angle));
+            break;
+        }
+    }
+    // flip * rotate: x' = fx * (x cos - y sin), y' = fy * (x sin + y cos)
+    float fx = mirrored ? -1.0f : 1.0f;
+    float fy = topDown ? -1.0f : 1.0f;
+    matrix[0] = fx * cosA;   // Column 0
+    matrix[1] = fy * sinA;
+    matrix[2] = -fx * sinA;  // Column 1
+    matrix[3] = fy * cosA;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// Full-screen textured quad passes with their GL state resolved up front.
+//
+// A pass wraps a program linked with kQuadVertexSource: attribute and
+// uniform locations are looked up once when the surface is created, the quad
+// lives in a static vertex buffer shared by every pass, and the texture
+// transform (camera rotation, front camera mirroring, top-down rows) is a
+// 2x2 matrix computed on the CPU and uploaded only when it changes. Drawing
+// a frame needs no location lookups and no client-side vertex uploads.
+//
+// GLSL ES 1.00 like the rest of the display path.
+
+// Vertex shader of every pass: aPosition (xyz) and aTexCoord (st), with the
+// texture coordinate transformed about the texture center by uTexTransform and
+// passed on as `vTexCoord`
+extern const char* const kQuadVertexSource;
+
+struct RenderPass {
+    GLuint program;
+    GLint positionLoc;
+    GLint texCoordLoc;
+    GLint texTransformLoc;
+
+    // Orientation uTexTransform was last set to (uniforms live in the program)
+    int rotation;
+    bool mirrored;
+    bool topDown;
+};
+
+// Creates the static quad (triangle strip, 5 floats per vertex) the passes draw.
+// Returns 0 on error.
+GLuint quadBufferCreate();
+
+// Resolves the locations of `program`, binds uTexture to unit 0 and sets the
+// identity transform. Leaves the program current. Returns false without a program.
+bool renderPassInit(RenderPass& pass, GLuint program);
+
+// Sets the texture transform: rotate by `rotation` degrees, then mirror
+// horizontally and/or flip vertically. The program must be current; nothing
+// is sent to GL when the orientation is unchanged.
+void renderPassSetOrientation(RenderPass& pass, int rotation, bool mirrored, bool topDown);
+
+// Draws the quad from `quadBuffer` with the current program, which must be `pass.program`
+void renderPassDraw(const RenderPass& pass, GLuint quadBuffer);
+
+// Column-major matrix uploaded for an orientation; exact for multiples of 90 degrees
+void renderPassTransform(int rotation, bool mirrored, bool topDown, float matrix[4]);
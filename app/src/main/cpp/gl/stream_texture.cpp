@@ -0,0 +1,54 @@
+#include "stream_texture.h"
+
+void streamTextureInit(StreamTexture& stream) {
+    stream = StreamTexture();
+    stream.current = -1;
+    glGenTextures(2, stream.textures);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, stream.textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        stream.filters[i] = GL_LINEAR;
+    }
+}
+
+void streamTextureDestroy(StreamTexture& stream) {
+    if (stream.textures[0] != 0) {
+        glDeleteTextures(2, stream.textures);
+    }
+    stream = StreamTexture();
+    stream.current = -1;
+}
+
+GLuint streamTextureUpload(StreamTexture& stream, int width, int height, GLenum format,
+                           const void* data, int rowAlignment, GLint filter) {
+    int back = stream.current == 0 ? 1 : 0;
+    glBindTexture(GL_TEXTURE_2D, stream.textures[back]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, rowAlignment);
+
+    if (stream.filters[back] != filter) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        stream.filters[back] = filter;
+    }
+
+    if (stream.widths[back] != width || stream.heights[back] != height || stream.formats[back] != format) {
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        stream.widths[back] = width;
+        stream.heights[back] = height;
+        stream.formats[back] = format;
+        stream.allocations++;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    stream.current = back;
+    return stream.textures[back];
+}
+
+GLuint streamTextureCurrent(const StreamTexture& stream) {
+    return stream.current < 0 ? 0 : stream.textures[stream.current];
+}
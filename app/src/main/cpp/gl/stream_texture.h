@@ -0,0 +1,34 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// Double-buffered texture for frames produced on the CPU.
+//
+// Storage is allocated once per size/format change; every other upload is a
+// glTexSubImage2D into the texture that is not currently being displayed, so
+// the driver never has to orphan or reallocate storage the GPU may still be
+// sampling from the previous frame.
+struct StreamTexture {
+    GLuint textures[2];
+    int widths[2];
+    int heights[2];
+    GLenum formats[2];
+    GLint filters[2];
+    int current;      // Index of the texture holding the newest frame
+    int allocations;  // Storage (re)allocations so far
+};
+
+// Creates both textures (linear filtering, clamped). Needs a current context.
+void streamTextureInit(StreamTexture& stream);
+
+void streamTextureDestroy(StreamTexture& stream);
+
+// Uploads a tightly packed frame (`rowAlignment` as for GL_UNPACK_ALIGNMENT)
+// into the back texture and makes it current. `format` is an unsized format
+// such as GL_RGBA or GL_LUMINANCE. `filter` is the min/mag filter to sample
+// with; changing it does not reallocate. Returns the texture to draw.
+GLuint streamTextureUpload(StreamTexture& stream, int width, int height, GLenum format,
+                           const void* data, int rowAlignment, GLint filter = GL_LINEAR);
+
+// Texture holding the newest frame (0 before the first upload)
+GLuint streamTextureCurrent(const StreamTexture& stream);
@@ -1,54 +1,48 @@
 #include <jni.h>
+#include <android/api-level.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
 #include <EGL/egl.h>
-#include <GLES2/gl2.h>
+#include <GLES3/gl3.h>
 #include <GLES2/gl2ext.h>
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <string>
+#include <cstring>
 #include <chrono>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <memory>
+
+#include "edge_pipeline.h"
+#include "edge_program.h"
+#include "frame_pool.h"
+#include "frame_recorder.h"
+#include "frame_ring.h"
+#include "fused_canny.h"
+#include "gl_program.h"
+#include "gpu_canny.h"
+#include "image_pool.h"
+#include "motion_gate.h"
+#include "quality_governor.h"
+#include "readback_ring.h"
+#include "render_pass.h"
+#include "seqlock.h"
+#include "stage_stats.h"
+#include "stream_texture.h"
+#include "trace.h"
+#include "triple_buffer.h"
 
 #ifndef GL_TEXTURE_EXTERNAL_OES
 #define GL_TEXTURE_EXTERNAL_OES 0x8D65
 #endif
 
-// OpenGL shader sources
-const char* vertexShaderSource = R"(
-attribute vec4 aPosition;
-attribute vec2 aTexCoord;
-uniform float uRotation;
-uniform bool uIsFrontCamera;
-varying vec2 vTexCoord;
-void main() {
-    gl_Position = aPosition;
-    
-    // Rotate texture coordinates based on rotation
-    vec2 texCoord = aTexCoord;
-    
-    // Apply rotation
-    float angle = uRotation * 3.14159265359 / 180.0;
-    float cosA = cos(angle);
-    float sinA = sin(angle);
-    
-    // Translate to center, rotate, translate back
-    texCoord -= 0.5;
-    float newX = texCoord.x * cosA - texCoord.y * sinA;
-    float newY = texCoord.x * sinA + texCoord.y * cosA;
-    texCoord = vec2(newX, newY) + 0.5;
-    
-    // Mirror horizontally for front camera
-    if (uIsFrontCamera) {
-        texCoord.x = 1.0 - texCoord.x;
-    }
-    
-    vTexCoord = texCoord;
-}
-)";
-
+// Camera fragment shader; the vertex shader is the render passes' kQuadVertexSource
 const char* fragmentShaderSource = R"(
 #extension GL_OES_EGL_image_external : require
 precision mediump float;
@@ -59,15 +53,58 @@ void main() {
 }
 )";
 
-// Fragment shader for regular 2D texture
-const char* fragmentShader2DSource = R"(
-precision mediump float;
-uniform sampler2D uTexture;
-varying vec2 vTexCoord;
-void main() {
-    gl_FragColor = texture2D(uTexture, vTexCoord);
-}
-)";
+// Where edge detection runs when processing is enabled
+enum EdgeBackend {
+    EDGE_BACKEND_CPU = 0,  // FBO readback + fused CPU kernel
+    EDGE_BACKEND_GPU = 1,  // GLSL passes, frames never leave the GPU
+};
+
+// What the render thread publishes after every frame for the stats reporter
+struct FrameCounters {
+    int64_t timestampNanos;  // When the frame was drawn
+    int64_t framesDrawn;  // Since the renderer started
+    int64_t framesProcessed;  // Edge frames completed by any backend
+};
+
+// Layout of the stats record passed to StatsCallback.onStats, mirrored by the
+// STATS_ constants of OpenGLSurfaceView
+enum StatsField {
+    STATS_TIMESTAMP_NANOS = 0,    // Render thread clock at the last frame covered
+    STATS_INTERVAL_NANOS,         // Time covered by this record
+    STATS_DISPLAY_FPS,            // Over the interval
+    STATS_PROCESSING_FPS,
+    STATS_FRAMES_DRAWN,           // Totals since the renderer started
+    STATS_FRAMES_PROCESSED,
+    STATS_SUBMITTED_OVERWRITTEN,  // Submitted frames replaced before the worker got to them
+    STATS_RECORDER_DROPPED,       // Frames dropped by the current or last recording
+    STATS_QUALITY_LEVEL,          // Quality governor level, 0 = best (kQualityLevels)
+    STATS_QUALITY_COST_NANOS,     // Governor's last window cost per input frame
+    STATS_QUALITY_TRANSITIONS,    // Level changes since the renderer started
+    STATS_FRAMES_SKIPPED,         // Input frames skipped by the level's frame interval
+    STATS_FRAMES_STATIC,          // Input frames the motion gate found static and skipped
+    STATS_READBACKS_SKIPPED,      // Camera frames not read back while the scene was static
+    STATS_STAGES,                 // stageStatsPack output over the interval
+    STATS_FIELD_COUNT = STATS_STAGES + STAGE_COUNT * STAGE_FIELD_COUNT
+};
+
+// RGBA camera frame travelling to the worker: read back by the render thread
+// or submitted from Java
+struct CameraFrame {
+    cv::Mat pixels;  // RGBA
+    FrameOrientation orientation;
+};
+
+// Edge map travelling from a producer thread to the render thread
+struct EdgeFrame {
+    cv::Mat pixels;  // Layout given by `format`
+    int width = 0;   // In pixels; pixels.cols is smaller when packed
+    EdgeFormat format = EDGE_FORMAT_RGBA;
+    FrameOrientation orientation;  // Applied by the display shader
+};
+
+// While the motion gate finds the scene static, the FBO path reads back one
+// camera frame in this many. Motion is then noticed a few frames late at worst.
+const int kStaticProbeInterval = 4;
 
 struct RendererState {
     EGLDisplay display;
@@ -76,11 +113,18 @@ struct RendererState {
     EGLConfig config;
     
     GLuint program;
-    GLuint program2D;  // Program for 2D textures
+    GLuint readbackProgram;  // Same shaders as program, for the unrotated FBO pass
+    EdgeProgram edgeProgram;  // Draws edge textures of any EdgeFormat
+    RenderPass cameraPass;  // Camera texture to the screen
+    RenderPass readbackPass;  // Camera texture into the readback FBO
+    RenderPass edgePass;  // Edge textures to the screen
     GLuint cameraTextureId;  // Texture from SurfaceTexture
-    GLuint outputTextureId;  // Texture for processed output
+    StreamTexture output;  // Double-buffered textures for processed output
+    GLuint fboTextureId;  // Camera frame rendered as a regular 2D texture
     GLuint fbo;  // Framebuffer for intermediate rendering
-    GLuint vertexBuffer;
+    int fboWidth;
+    int fboHeight;
+    GLuint vertexBuffer;  // Static quad drawn by every render pass
     
     int width;
     int height;
@@ -90,84 +134,353 @@ struct RendererState {
     ANativeWindow* window;
     
     bool processingMode;
-    int frameCount;
-    std::chrono::steady_clock::time_point lastFpsTime;
-    int currentFps;
-    
-    int cameraRotation;  // Rotation in degrees (0, 90, 180, 270)
-    bool isFrontCamera;
-    
-    std::mutex frameMutex;
-    cv::Mat currentFrame;
-    bool frameReady;
-    
+    EdgeParams edgeParams;
+    std::chrono::steady_clock::time_point lastFpsTime;  // Last per-second stats update
+    int textureAllocations;  // Render target and GPU pipeline allocations
+    int lastTextureAllocations;
+    std::atomic<int> textureAllocationsPerSecond;  // Output uploads included; 0 in steady state
+    
+    // Frame buffers for every Mat below. Declared first so it is destroyed last.
+    FramePool framePool;
+    int lastFrameAllocations;
+    std::atomic<int> frameAllocationsPerSecond;  // Heap allocations for frames; 0 in steady state
+    
+    // CPU edge detection runs on its own worker so the render thread never
+    // waits on OpenCV. Frames travel through lock-free triple buffers: the
+    // render thread publishes readback frames into inputFrames, the worker
+    // publishes results into edgeFrames, and each side only ever sees the
+    // newest frame. RGBA frames submitted from Java take the same route
+    // through submittedFrames, a latest-wins FrameRing that counts the frames
+    // it hands over and replaces.
+    std::thread worker;
+    std::mutex workerMutex;  // Guards only the wake-up flags below
+    std::condition_variable workerWake;
+    bool workerInputPending;
+    bool workerStop;
+    TripleBuffer<CameraFrame> inputFrames;  // Render thread -> worker
+    FrameRing<CameraFrame> submittedFrames{FRAME_RING_LATEST_WINS};  // processFrame caller -> worker
+    jobject submitBuffers[3];  // Direct ByteBuffers over submittedFrames' slots, for buffer swapping
+    LentFrames lentFrames;  // Slot memory under buffers Java holds, kept until handed back
+    std::atomic<bool> submittedInput;  // RGBA frames are being submitted, so the FBO readback is skipped
+    TripleBuffer<EdgeFrame> edgeFrames;  // Worker -> render thread
+    CannyWorkspace cannyWorkspace;  // Worker-only scratch
+    std::atomic<int> processedFrames;  // Edge frames completed by any backend
+    
+    // Layout of CPU edge frames, and what their uploads cost
+    std::atomic<int> edgeFormat;
+    std::atomic<uint32_t> edgeColor;  // ARGB, as android.graphics.Color
+    std::atomic<int> processingScale;  // Least EdgeParams::downscale; the governor may go further
+    std::atomic<bool> linearMagnification;  // Sampling of edge maps smaller than the view
+    EdgeFormat outputFormat;  // Layout of the texture in `output`
+    int outputWidth;
+    FrameOrientation outputOrientation;
+    int64_t uploadBytes;  // Since the last stats update
+    int64_t uploadNanos;
+    int uploadCount;
+    std::atomic<int> uploadBytesPerFrame;
+    std::atomic<int> uploadNanosPerFrame;
+    std::atomic<int> uploadFormat;
+    
+    // Per-stage latency histograms, recorded lock-free by every thread
+    StageStats stageStats;
+    std::mutex stageBaselineMutex;  // Guards stageBaseline for the stats getter
+    StageBaseline stageBaseline;
+    bool stageBaselineTaken;
+    
+    // Optional recording of the input frames, written on its own thread
+    FrameRecorder frameRecorder;
+    
+    // Full-GPU Canny (GLES3 only, otherwise the CPU backend is used)
+    std::atomic<int> edgeBackend;
+    GpuCanny gpuCanny;
+    GpuCannyParams gpuCannyParams;
+    bool gpuCannyReady;
+    
+    // Asynchronous readback of the FBO (GLES3 only, otherwise glReadPixels)
+    ReadbackRing readbackRing;
+    std::atomic<bool> asyncReadback;
+    int64_t frameIndex;
+    std::atomic<int> readbackLatencyFrames;  // Age of the last read-back frame
+    
+    std::atomic<int> cameraRotation;  // Rotation in degrees (0, 90, 180, 270)
+    std::atomic<bool> isFrontCamera;
+    
+    // Quality of the CPU kernel, adapted to a frame time budget by whichever
+    // thread runs it (quality_governor.h). Off until a budget is set.
+    std::mutex governorMutex;  // Guards governor
+    QualityGovernor governor;
+    
+    // Skips the CPU kernel on static scenes (motion_gate.h). Off until a
+    // threshold is set. While frames come out static, the render thread only
+    // reads back every kStaticProbeInterval-th camera frame to look for motion.
+    std::mutex motionMutex;  // Guards motionGate
+    MotionGate motionGate;
+    std::atomic<int> staticFrames;  // motionGate.staticFrames after the last check
+    std::atomic<int64_t> readbacksSkipped;
+    
+    // Edge maps computed from camera YUV frames on the producer thread
+    CannyWorkspace lumaWorkspace;  // Producer-only scratch
+    cv::Mat nv21Luma;  // Y plane copied out of an NV21 array, producer-only
+    TripleBuffer<EdgeFrame> lumaEdges;  // Camera thread -> render thread
+    std::atomic<bool> lumaInput;  // YUV frames are arriving, so the FBO readback is skipped
+    
+    // Java callbacks run on a reporter thread that stays attached to the
+    // JVM, so a slow callback never delays the frame swap. The render thread
+    // only publishes its counters, through a seqlock, and never waits.
+    Seqlock<FrameCounters> frameCounters;  // Render thread -> reporter
+    std::thread reporter;
+    std::mutex reporterMutex;  // Guards the fields below
+    std::condition_variable reporterWake;
+    bool reporterStop;
+    int reportIntervalMs;
     jobject fpsCallback;
-    JavaVM* jvm;
+    jobject statsCallback;
 };
 
 static RendererState* g_renderer = nullptr;
 
-// Helper function to compile shader
-GLuint compileShader(GLenum type, const char* source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-    
-    GLint compiled;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
-    if (!compiled) {
-        GLint infoLen = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
-        if (infoLen > 1) {
-            char* infoLog = new char[infoLen];
-            glGetShaderInfoLog(shader, infoLen, nullptr, infoLog);
-            delete[] infoLog;
-        }
-        glDeleteShader(shader);
-        return 0;
+// Java classes and methods the native code calls back into, resolved once in
+// JNI_OnLoad. The class global refs keep the method IDs valid.
+struct JniCache {
+    jclass fpsCallbackClass;
+    jmethodID onFpsUpdate;  // FpsCallback.onFpsUpdate(II)V
+    jclass imageCallbackClass;
+    jmethodID onImageProcessed;  // NativeBridge.ImageCallback.onImageProcessed(IJ)V
+    jclass statsCallbackClass;
+    jmethodID onStats;  // StatsCallback.onStats([J)V
+    JavaVM* vm;
+};
+
+static JniCache g_jni;
+
+// Helper function to swap one of the reporter's callbacks for `callback` (may be null)
+void setReporterCallback(JNIEnv* env, RendererState* renderer, jobject& slot, jobject callback) {
+    jobject global = callback != nullptr ? env->NewGlobalRef(callback) : nullptr;
+    jobject previous;
+    {
+        std::lock_guard<std::mutex> lock(renderer->reporterMutex);
+        previous = slot;
+        slot = global;
+    }
+    if (previous != nullptr) {
+        env->DeleteGlobalRef(previous);
     }
-    return shader;
+    renderer->reporterWake.notify_one();
 }
 
-// Helper function to create shader program
-GLuint createProgram(const char* vertexSource, const char* fragmentSource) {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-    if (vertexShader == 0) return 0;
-    
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
-    if (fragmentShader == 0) {
-        glDeleteShader(vertexShader);
-        return 0;
+// Helper function to report a callback's exception without stopping the reporter
+void clearCallbackException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
     }
-    
-    GLuint program = glCreateProgram();
-    if (program == 0) return 0;
-    
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    
-    GLint linked;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
-    if (!linked) {
-        GLint infoLen = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLen);
-        if (infoLen > 1) {
-            char* infoLog = new char[infoLen];
-            glGetProgramInfoLog(program, infoLen, nullptr, infoLog);
-            delete[] infoLog;
+}
+
+// Reporter thread: attached to the JVM for its whole life, it wakes every
+// report interval, turns the render thread's counter snapshots into rates and
+// calls the FPS and stats callbacks. The stats array is allocated once and
+// refilled for every record.
+void statsReporter(RendererState* renderer) {
+    JNIEnv* env = nullptr;
+    JavaVMAttachArgs args = {JNI_VERSION_1_6, "stats_reporter", nullptr};
+    if (g_jni.vm == nullptr || g_jni.vm->AttachCurrentThreadAsDaemon(&env, &args) != JNI_OK) {
+        return;
+    }
+    traceSetThreadName("stats_reporter");
+    jlongArray localStats = env->NewLongArray(STATS_FIELD_COUNT);
+    jlongArray statsArray = static_cast<jlongArray>(env->NewGlobalRef(localStats));
+    env->DeleteLocalRef(localStats);
+    
+    // Stage percentiles cover the interval since the previous record
+    std::unique_ptr<StageBaseline> baseline(new StageBaseline());
+    stageBaselineTake(renderer->stageStats, *baseline);
+    jlong values[STATS_FIELD_COUNT];
+    FrameCounters last = renderer->frameCounters.read();
+    
+    std::unique_lock<std::mutex> lock(renderer->reporterMutex);
+    while (!renderer->reporterStop) {
+        renderer->reporterWake.wait_for(lock, std::chrono::milliseconds(renderer->reportIntervalMs));
+        if (renderer->reporterStop) {
+            break;
         }
-        glDeleteProgram(program);
-        return 0;
+        jobject fpsCallback = renderer->fpsCallback != nullptr ? env->NewLocalRef(renderer->fpsCallback) : nullptr;
+        jobject statsCallback = renderer->statsCallback != nullptr ? env->NewLocalRef(renderer->statsCallback) : nullptr;
+        lock.unlock();
+        
+        FrameCounters current = renderer->frameCounters.read();
+        int64_t interval = current.timestampNanos - last.timestampNanos;
+        int displayFps = 0;
+        int processingFps = 0;
+        if (interval > 0) {
+            displayFps = static_cast<int>((current.framesDrawn - last.framesDrawn) * 1000000000LL / interval);
+            processingFps = static_cast<int>((current.framesProcessed - last.framesProcessed) * 1000000000LL / interval);
+        }
+        
+        if (fpsCallback != nullptr) {
+            env->CallVoidMethod(fpsCallback, g_jni.onFpsUpdate, displayFps, processingFps);
+            clearCallbackException(env);
+            env->DeleteLocalRef(fpsCallback);
+        }
+        if (statsCallback != nullptr && statsArray != nullptr) {
+            values[STATS_TIMESTAMP_NANOS] = current.timestampNanos;
+            values[STATS_INTERVAL_NANOS] = interval;
+            values[STATS_DISPLAY_FPS] = displayFps;
+            values[STATS_PROCESSING_FPS] = processingFps;
+            values[STATS_FRAMES_DRAWN] = current.framesDrawn;
+            values[STATS_FRAMES_PROCESSED] = current.framesProcessed;
+            values[STATS_SUBMITTED_OVERWRITTEN] = static_cast<jlong>(renderer->submittedFrames.counters().overwritten);
+            values[STATS_RECORDER_DROPPED] = renderer->frameRecorder.framesDropped();
+            {
+                std::lock_guard<std::mutex> governorLock(renderer->governorMutex);
+                const QualityGovernor& governor = renderer->governor;
+                values[STATS_QUALITY_LEVEL] = governor.level;
+                values[STATS_QUALITY_COST_NANOS] = governor.lastCostNanos;
+                values[STATS_QUALITY_TRANSITIONS] = governor.transitions;
+                values[STATS_FRAMES_SKIPPED] = governor.framesSkipped;
+            }
+            {
+                std::lock_guard<std::mutex> motionLock(renderer->motionMutex);
+                values[STATS_FRAMES_STATIC] = renderer->motionGate.framesStatic;
+            }
+            values[STATS_READBACKS_SKIPPED] = renderer->readbacksSkipped;
+            stageStatsPack(renderer->stageStats, baseline.get(), reinterpret_cast<int64_t*>(values + STATS_STAGES));
+            stageBaselineTake(renderer->stageStats, *baseline);
+            env->SetLongArrayRegion(statsArray, 0, STATS_FIELD_COUNT, values);
+            env->CallVoidMethod(statsCallback, g_jni.onStats, statsArray);
+            clearCallbackException(env);
+            env->DeleteLocalRef(statsCallback);
+        }
+        last = current;
+        lock.lock();
     }
+    lock.unlock();
     
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    if (statsArray != nullptr) {
+        env->DeleteGlobalRef(statsArray);
+    }
+    g_jni.vm->DetachCurrentThread();
+}
+
+// Helper function to make every frame Mat of the renderer allocate from its pool
+void attachFramePool(RendererState* renderer) {
+    FramePool& pool = renderer->framePool;
+    for (int i = 0; i < renderer->submittedFrames.slotCount(); i++) {
+        useFramePool(renderer->submittedFrames.slot(i).pixels, pool);
+    }
+    for (int i = 0; i < 3; i++) {
+        useFramePool(renderer->inputFrames.slots[i].pixels, pool);
+        useFramePool(renderer->edgeFrames.slots[i].pixels, pool);
+        useFramePool(renderer->lumaEdges.slots[i].pixels, pool);
+    }
+    useFramePool(renderer->nv21Luma, pool);
+}
+
+// Helper function to describe frames captured now: camera orientation, OpenGL row order
+FrameOrientation captureOrientation(const RendererState* renderer) {
+    FrameOrientation orientation;
+    orientation.rotation = renderer->cameraRotation;
+    orientation.mirrored = renderer->isFrontCamera;
+    orientation.bottomUp = true;
+    return orientation;
+}
+
+// Helper function to hand an input frame to the recorder, if recording
+void recordInputFrame(RendererState* renderer, const FrameView& view, int64_t timestampNanos) {
+    if (renderer->frameRecorder.recording()) {
+        FrameView recorded = view;
+        recorded.timestampNanos = timestampNanos;
+        renderer->frameRecorder.submit(recorded);
+    }
+}
+
+// Helper function to run the motion gate on an input frame. Returns false
+// when the scene has not changed since the last processed frame.
+bool motionGateAdmit(RendererState* renderer, const FrameView& view, int64_t nowNanos) {
+    std::lock_guard<std::mutex> lock(renderer->motionMutex);
+    bool changed = motionGateCheck(renderer->motionGate, view.data, view.format == FRAME_PIXEL_RGBA ? 4 : 1,
+                                   view.width, view.height, view.rowStride, view.pixelStride, nowNanos);
+    renderer->staticFrames = renderer->motionGate.staticFrames;
+    return changed;
+}
+
+// Helper function to run the CPU kernel on any input frame, camera or replayed,
+// into an edge frame in the current edge format, at the governor's quality
+// level. Returns false, leaving `frame` alone, when the level skips the frame
+// or the scene is static, so the edges on screen stay current.
+bool processEdgeFrame(RendererState* renderer, const FrameView& view, EdgeFrame& frame,
+                      CannyWorkspace* workspace, Stage stage) {
+    int64_t arrival = monotonicNanos();
+    recordInputFrame(renderer, view, arrival);
+    int level;
+    {
+        std::lock_guard<std::mutex> lock(renderer->governorMutex);
+        if (!governorAdmitFrame(renderer->governor)) {
+            return false;
+        }
+        level = renderer->governor.level;
+    }
+    if (!motionGateAdmit(renderer, view, arrival)) {
+        return false;
+    }
     
-    return program;
+    // Timed from here, so the governor and STAGE_CANNY see the kernel alone
+    int64_t start = monotonicNanos();
+    EdgeParams params = renderer->edgeParams;
+    applyQualityLevel(kQualityLevels[level], params);
+    params.downscale = std::max(params.downscale, renderer->processingScale.load());
+    frame.format = static_cast<EdgeFormat>(renderer->edgeFormat.load());
+    frame.width = edgeMapSize(view.width, params);  // Magnified back by the display quad
+    processFrameView(view, frame.pixels, frame.orientation, params, workspace, frame.format);
+    int64_t end = monotonicNanos();
+    stageRecordKernel(renderer->stageStats, stage, *workspace, start, end);
+    
+    std::lock_guard<std::mutex> lock(renderer->governorMutex);
+    governorRecord(renderer->governor, level, end - start, end);
+    return true;
+}
+
+// Helper function to run the worker's kernel on an RGBA frame and publish the edges
+void processCameraFrame(RendererState* renderer, const CameraFrame& input) {
+    FrameView view;
+    view.data = input.pixels.data;
+    view.width = input.pixels.cols;
+    view.height = input.pixels.rows;
+    view.rowStride = static_cast<int>(input.pixels.step);
+    view.format = FRAME_PIXEL_RGBA;
+    view.orientation = input.orientation;  // Rows stay in the order they were stored
+    if (!processEdgeFrame(renderer, view, renderer->edgeFrames.back(), &renderer->cannyWorkspace, STAGE_CANNY)) {
+        return;
+    }
+    renderer->edgeFrames.publish();
+    renderer->processedFrames++;
+}
+
+// Worker thread: runs the CPU kernel on the newest read-back or submitted frame
+void processingWorker(RendererState* renderer) {
+    traceSetThreadName("edge_worker");
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(renderer->workerMutex);
+            renderer->workerWake.wait(lock, [renderer] {
+                return renderer->workerInputPending || renderer->workerStop;
+            });
+            if (renderer->workerStop) {
+                return;
+            }
+            renderer->workerInputPending = false;
+        }
+        
+        if (renderer->inputFrames.update()) {
+            processCameraFrame(renderer, renderer->inputFrames.front());
+        }
+        if (const CameraFrame* submitted = renderer->submittedFrames.beginRead()) {
+            processCameraFrame(renderer, *submitted);
+            renderer->submittedFrames.endRead();
+        }
+    }
 }
 
-extern "C" JNIEXPORT jlong JNICALL
+static jlong JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeInit(JNIEnv *env, jobject thiz) {
     RendererState* renderer = new RendererState();
     renderer->display = EGL_NO_DISPLAY;
@@ -179,45 +492,110 @@ Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeInit
     renderer->cameraWidth = 1280;
     renderer->cameraHeight = 720;
     renderer->processingMode = true;
-    renderer->frameCount = 0;
-    renderer->currentFps = 0;
-    renderer->frameReady = false;
+    renderer->textureAllocations = 0;
+    renderer->lastTextureAllocations = 0;
+    renderer->textureAllocationsPerSecond = 0;
+    renderer->lastFrameAllocations = 0;
+    renderer->frameAllocationsPerSecond = 0;
+    renderer->output = StreamTexture();
+    renderer->submittedInput = false;
+    for (int i = 0; i < 3; i++) {
+        renderer->submitBuffers[i] = nullptr;
+    }
+    renderer->lumaInput = false;
+    renderer->workerInputPending = false;
+    renderer->workerStop = false;
+    renderer->processedFrames = 0;
+    renderer->edgeFormat = EDGE_FORMAT_GRAY;
+    renderer->edgeColor = 0xFFFFFFFF;
+    renderer->processingScale = 1;
+    renderer->linearMagnification = true;
+    renderer->outputFormat = EDGE_FORMAT_RGBA;
+    renderer->outputWidth = 0;
+    renderer->outputOrientation = FrameOrientation();
+    renderer->uploadBytes = 0;
+    renderer->uploadNanos = 0;
+    renderer->uploadCount = 0;
+    renderer->uploadBytesPerFrame = 0;
+    renderer->uploadNanosPerFrame = 0;
+    renderer->uploadFormat = EDGE_FORMAT_GRAY;
+    stageStatsInit(renderer->stageStats);
+    renderer->stageBaselineTaken = false;
+    governorInit(renderer->governor, GovernorConfig());
+    motionGateInit(renderer->motionGate, MotionGateConfig());
+    renderer->staticFrames = 0;
+    renderer->readbacksSkipped = 0;
+    renderer->reporterStop = false;
+    renderer->reportIntervalMs = 1000;
     renderer->fpsCallback = nullptr;
+    renderer->statsCallback = nullptr;
     renderer->lastFpsTime = std::chrono::steady_clock::now();
     renderer->cameraRotation = 0;
     renderer->isFrontCamera = false;
+    renderer->program = 0;
+    renderer->readbackProgram = 0;
+    renderer->vertexBuffer = 0;
     renderer->fbo = 0;
-    renderer->program2D = 0;
-    
-    env->GetJavaVM(&renderer->jvm);
+    renderer->fboTextureId = 0;
+    renderer->fboWidth = 0;
+    renderer->fboHeight = 0;
+    renderer->edgeProgram = EdgeProgram();
+    renderer->readbackRing = ReadbackRing();
+    renderer->readbackRing.mappedSlot = -1;
+    renderer->asyncReadback = true;
+    renderer->edgeBackend = EDGE_BACKEND_CPU;
+    renderer->gpuCanny = GpuCanny();
+    renderer->gpuCannyReady = false;
+    renderer->frameIndex = 0;
+    renderer->readbackLatencyFrames = 0;
+    
+    attachFramePool(renderer);
+    
+    renderer->worker = std::thread(processingWorker, renderer);
+    renderer->reporter = std::thread(statsReporter, renderer);
     
     g_renderer = renderer;
     return reinterpret_cast<jlong>(renderer);
 }
 
-extern "C" JNIEXPORT void JNICALL
+static void JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeOnSurfaceCreated(JNIEnv *env, jobject thiz, jlong rendererPtr, jint textureId) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     
     // Store the camera texture ID from SurfaceTexture
     renderer->cameraTextureId = textureId;
+    traceSetThreadName("render");
+    
+    // Create shader programs for external textures: one keeps the identity
+    // transform for the FBO pass, so neither re-uploads it every frame
+    renderer->program = createProgram(kQuadVertexSource, fragmentShaderSource);
+    renderer->readbackProgram = createProgram(kQuadVertexSource, fragmentShaderSource);
     
-    // Create shader program for external textures
-    renderer->program = createProgram(vertexShaderSource, fragmentShaderSource);
+    // Create shader program for edge textures (RGBA, gray or packed bits)
+    edgeProgramInit(renderer->edgeProgram, kQuadVertexSource);
     
-    // Create shader program for 2D textures
-    renderer->program2D = createProgram(vertexShaderSource, fragmentShader2DSource);
+    // Resolve every attribute and uniform location once, and keep the quad on the GPU
+    renderPassInit(renderer->cameraPass, renderer->program);
+    renderPassInit(renderer->readbackPass, renderer->readbackProgram);
+    renderPassInit(renderer->edgePass, renderer->edgeProgram.program);
+    renderer->vertexBuffer = quadBufferCreate();
     
-    // Create output texture for processed frames
-    glGenTextures(1, &renderer->outputTextureId);
-    glBindTexture(GL_TEXTURE_2D, renderer->outputTextureId);
+    // Create output textures for processed frames (storage comes with the first frame)
+    streamTextureInit(renderer->output);
+    
+    // Create framebuffer for intermediate rendering
+    glGenFramebuffers(1, &renderer->fbo);
+    glGenTextures(1, &renderer->fboTextureId);
+    glBindTexture(GL_TEXTURE_2D, renderer->fboTextureId);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    renderer->fboWidth = 0;
+    renderer->fboHeight = 0;
     
-    // Create framebuffer for intermediate rendering
-    glGenFramebuffers(1, &renderer->fbo);
+    // GPU edge pipeline, available on OpenGL ES 3 contexts
+    renderer->gpuCannyReady = gpuCannyInit(renderer->gpuCanny, GL_TEXTURE_EXTERNAL_OES);
     
     // Set up camera texture parameters
     glBindTexture(GL_TEXTURE_EXTERNAL_OES, renderer->cameraTextureId);
@@ -227,7 +605,7 @@ Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeOnSu
     glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
-extern "C" JNIEXPORT void JNICALL
+static void JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeOnSurfaceChanged(JNIEnv *env, jobject thiz, jlong rendererPtr, jint width, jint height) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     renderer->width = width;
@@ -236,27 +614,125 @@ Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeOnSu
     glViewport(0, 0, width, height);
 }
 
-// Helper function to process frame with Canny edge detection
-cv::Mat processFrameWithCanny(const cv::Mat& input) {
-    cv::Mat gray, edges, result;
-    
-    // Convert to grayscale
-    cv::cvtColor(input, gray, cv::COLOR_RGBA2GRAY);
-    
-    // Apply Canny edge detection
-    // Low threshold: 50, High threshold: 150
-    cv::Canny(gray, edges, 50, 150);
+// Helper function to compute a luma edge map into the next frame for the render
+// thread. Returns false if the quality governor or the motion gate skipped the frame.
+bool processLumaEdges(RendererState* renderer, const uchar* y, int width, int height,
+                      int rowStride, int pixelStride) {
+    traceSetThreadName("camera");
+    FrameView view;
+    view.data = y;
+    view.width = width;
+    view.height = height;
+    view.rowStride = rowStride;
+    view.pixelStride = pixelStride;
+    view.format = FRAME_PIXEL_LUMA;
+    view.orientation = captureOrientation(renderer);
+    view.orientation.bottomUp = false;  // Camera planes are top-down
+    return processEdgeFrame(renderer, view, renderer->lumaEdges.back(), &renderer->lumaWorkspace, STAGE_LUMA_CANNY);
+}
+
+// Helper function to hand the latest luma edge map to the render thread
+void publishLumaEdges(RendererState* renderer) {
+    renderer->lumaEdges.publish();
+    renderer->processedFrames++;
+    renderer->lumaInput = true;
+}
+
+// Helper function to (re)create the FBO render target and readback ring for the camera size
+void ensureReadbackTarget(RendererState* renderer) {
+    int width = renderer->cameraWidth;
+    int height = renderer->cameraHeight;
+    
+    if (renderer->fboWidth != width || renderer->fboHeight != height) {
+        glBindTexture(GL_TEXTURE_2D, renderer->fboTextureId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindFramebuffer(GL_FRAMEBUFFER, renderer->fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                              renderer->fboTextureId, 0);
+        renderer->fboWidth = width;
+        renderer->fboHeight = height;
+        renderer->textureAllocations++;
+        readbackRingDestroy(renderer->readbackRing);
+    }
     
-    // Convert back to RGBA for display
-    cv::cvtColor(edges, result, cv::COLOR_GRAY2RGBA);
+    ReadbackRing& ring = renderer->readbackRing;
+    if (!renderer->asyncReadback) {
+        readbackRingDestroy(ring);
+    } else if (ring.depth == 0 && readbackRingSupported()) {
+        // Two buffers give one frame of latency; the third absorbs a slow frame
+        readbackRingInit(ring, width, height, 3);
+    }
+}
+
+// Helper function to tell the worker a new input frame was published
+void wakeWorker(RendererState* renderer) {
+    {
+        std::lock_guard<std::mutex> lock(renderer->workerMutex);
+        renderer->workerInputPending = true;
+    }
+    renderer->workerWake.notify_one();
+}
+
+// Helper function to read the FBO into the worker's next input frame. Does
+// nothing while the asynchronous ring has no finished transfer yet.
+void readbackToWorker(RendererState* renderer) {
+    int width = renderer->cameraWidth;
+    int height = renderer->cameraHeight;
+    ReadbackRing& ring = renderer->readbackRing;
+    CameraFrame& frame = renderer->inputFrames.back();
+    cv::Mat& input = frame.pixels;
+    
+    if (ring.depth == 0) {
+        // Synchronous fallback: stalls until the GPU has finished this frame
+        input.create(height, width, CV_8UC4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, input.data);
+        renderer->readbackLatencyFrames = 0;
+    } else {
+        readbackRingQueue(ring, renderer->frameIndex);
+        const unsigned char* pixels = readbackRingAcquire(ring, renderer->frameIndex, nullptr);
+        if (pixels == nullptr) {
+            return;
+        }
+        // The mapping belongs to this thread's context, so the worker gets a copy
+        cv::Mat(height, width, CV_8UC4, const_cast<unsigned char*>(pixels)).copyTo(input);
+        readbackRingRelease(ring);
+        renderer->readbackLatencyFrames = ring.latencyFrames;
+    }
     
-    return result;
+    // Rows stay bottom-up; the orientation travels with the frame instead
+    frame.orientation = captureOrientation(renderer);
+    renderer->inputFrames.publish();
+    wakeWorker(renderer);
 }
 
-// Helper function to read texture from GPU to CPU
-cv::Mat readTextureToMat(GLuint textureId, int width, int height) {
-    // Create buffer for RGBA data
-    std::vector<unsigned char> pixels(width * height * 4);
+// Helper function to upload an edge frame to the output texture, recording its size and upload time
+void uploadEdgeFrame(RendererState* renderer, const EdgeFrame& frame) {
+    const cv::Mat& pixels = frame.pixels;
+    // Packed bytes must not be blended with their neighbours
+    GLint filter = renderer->linearMagnification && frame.format != EDGE_FORMAT_PACKED ? GL_LINEAR : GL_NEAREST;
+    int64_t start = monotonicNanos();
+    if (frame.format == EDGE_FORMAT_RGBA) {
+        streamTextureUpload(renderer->output, pixels.cols, pixels.rows, GL_RGBA, pixels.data, 4, filter);
+    } else {
+        streamTextureUpload(renderer->output, pixels.cols, pixels.rows, GL_LUMINANCE, pixels.data, 1, filter);
+    }
+    int64_t end = monotonicNanos();
+    stageRecord(renderer->stageStats, STAGE_UPLOAD, start, end);
+    
+    renderer->outputFormat = frame.format;
+    renderer->outputWidth = frame.width;
+    renderer->outputOrientation = frame.orientation;
+    renderer->uploadBytes += static_cast<int64_t>(pixels.total() * pixels.elemSize());
+    renderer->uploadNanos += end - start;
+    renderer->uploadCount++;
+}
+
+// Helper function to read texture from GPU to CPU into `pixels`, which is
+// only reallocated when the size changes. Rows come back bottom-up as OpenGL
+// stores them, and `orientation` says so; pass both to orientUpright when
+// upright pixels are really needed.
+void readTextureToMat(GLuint textureId, int width, int height, cv::Mat& pixels, FrameOrientation* orientation) {
+    pixels.create(height, width, CV_8UC4);
     
     // Create framebuffer
     GLuint fbo;
@@ -269,19 +745,17 @@ cv::Mat readTextureToMat(GLuint textureId, int width, int height) {
     // Check framebuffer status
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
         // Read pixels
-        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data);
     }
     
     // Clean up
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glDeleteFramebuffers(1, &fbo);
     
-    // Create OpenCV Mat from pixels (flip vertically as OpenGL has origin at bottom-left)
-    cv::Mat mat(height, width, CV_8UC4, pixels.data());
-    cv::Mat flipped;
-    cv::flip(mat, flipped, 0);
-    
-    return flipped.clone();
+    if (orientation != nullptr) {
+        *orientation = FrameOrientation();
+        orientation->bottomUp = true;  // OpenGL has origin at bottom-left
+    }
 }
 
 // Helper function to upload Mat to GPU texture
@@ -290,252 +764,628 @@ void uploadMatToTexture(GLuint textureId, const cv::Mat& mat) {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mat.cols, mat.rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, mat.data);
 }
 
-extern "C" JNIEXPORT void JNICALL
-Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeOnDrawFrame(JNIEnv *env, jobject thiz, jlong rendererPtr, jboolean processEdges) {
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeOnDrawFrame(JNIEnv *env, jclass clazz, jlong rendererPtr, jboolean processEdges) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     
     if (renderer->cameraTextureId == 0) {
         return;
     }
     
+    int64_t frameStart = monotonicNanos();
+    
     // Clear screen
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     
     GLuint textureToRender = renderer->cameraTextureId;
     GLenum textureTarget = GL_TEXTURE_EXTERNAL_OES;
+    EdgeFormat edgeFormat = EDGE_FORMAT_RGBA;  // Layout of textureToRender when it holds edges
+    FrameOrientation orientation = captureOrientation(renderer);  // Of textureToRender
     
     // If edge detection is enabled, process the frame
-    if (processEdges && renderer->width > 0 && renderer->height > 0) {
-        // Step 1: Render camera texture to FBO to get it as regular 2D texture
-        glBindFramebuffer(GL_FRAMEBUFFER, renderer->fbo);
+    if (processEdges && renderer->edgeBackend == EDGE_BACKEND_GPU && renderer->gpuCannyReady) {
+        // Full-GPU Canny: camera texture to edge texture with no glReadPixels or upload
+        GpuCannyParams& params = renderer->gpuCannyParams;
+        params.lowThreshold = cvFloor(renderer->edgeParams.lowThreshold);
+        params.highThreshold = cvFloor(renderer->edgeParams.highThreshold);
+        
+        GLuint edges = 0;
+        bool resized = renderer->gpuCanny.width != renderer->cameraWidth || renderer->gpuCanny.height != renderer->cameraHeight;
+        int64_t start = monotonicNanos();
+        if (gpuCannyResize(renderer->gpuCanny, renderer->cameraWidth, renderer->cameraHeight)) {
+            if (resized) {
+                // Counted only once the targets exist; a failed resize allocates nothing that stays
+                renderer->textureAllocations += GpuCanny::kTargetCount;
+            }
+            edges = gpuCannyRun(renderer->gpuCanny, renderer->cameraTextureId, params);
+        }
+        stageRecord(renderer->stageStats, STAGE_GPU_CANNY, start, monotonicNanos());
+        glViewport(0, 0, renderer->width, renderer->height);
         
-        // Make sure output texture has correct size
-        glBindTexture(GL_TEXTURE_2D, renderer->outputTextureId);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, renderer->cameraWidth, renderer->cameraHeight, 
-                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        if (edges != 0) {
+            textureToRender = edges;
+            textureTarget = GL_TEXTURE_2D;
+            renderer->processedFrames++;
+        }
+    } else if (processEdges && (renderer->lumaInput || renderer->submittedInput)) {
+        // Camera luma frames and submitted RGBA frames are processed off this
+        // thread; show the latest edge map
+        TripleBuffer<EdgeFrame>& edges = renderer->lumaInput ? renderer->lumaEdges : renderer->edgeFrames;
+        if (edges.update()) {
+            uploadEdgeFrame(renderer, edges.front());
+        }
         
-        // Attach texture to FBO
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 
-                              renderer->outputTextureId, 0);
+        if (streamTextureCurrent(renderer->output) != 0) {
+            textureToRender = streamTextureCurrent(renderer->output);
+            textureTarget = GL_TEXTURE_2D;
+            edgeFormat = renderer->outputFormat;
+            orientation = renderer->outputOrientation;
+        }
+    } else if (processEdges && renderer->width > 0 && renderer->height > 0) {
+        // Step 1: Render camera texture to FBO to get it as regular 2D texture,
+        // on every frame unless the scene has been static
+        bool probe = renderer->staticFrames == 0 || renderer->frameIndex % kStaticProbeInterval == 0;
+        int64_t fboStart = monotonicNanos();
+        ensureReadbackTarget(renderer);
+        glBindFramebuffer(GL_FRAMEBUFFER, renderer->fbo);
+        if (!probe) {
+            renderer->readbacksSkipped++;
+        }
         
         // Check FBO status
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        if (probe && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
             // Render camera texture to FBO
             glViewport(0, 0, renderer->cameraWidth, renderer->cameraHeight);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
             
-            glUseProgram(renderer->program);
-            
-            GLint posLoc = glGetAttribLocation(renderer->program, "aPosition");
-            GLint texLoc = glGetAttribLocation(renderer->program, "aTexCoord");
-            GLint texUniform = glGetUniformLocation(renderer->program, "uTexture");
-            GLint rotLoc = glGetUniformLocation(renderer->program, "uRotation");
-            GLint frontLoc = glGetUniformLocation(renderer->program, "uIsFrontCamera");
-            
-            float verts[] = {
-                -1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
-                 1.0f, -1.0f, 0.0f,  1.0f, 0.0f,
-                -1.0f,  1.0f, 0.0f,  0.0f, 1.0f,
-                 1.0f,  1.0f, 0.0f,  1.0f, 1.0f
-            };
-            
-            glEnableVertexAttribArray(posLoc);
-            glEnableVertexAttribArray(texLoc);
-            glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), verts);
-            glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), verts + 3);
-            
-            glUniform1f(rotLoc, 0.0f);  // No rotation in FBO pass
-            glUniform1i(frontLoc, 0);
-            
+            // No rotation in FBO pass: the readback pass keeps its identity transform
+            glUseProgram(renderer->readbackPass.program);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_EXTERNAL_OES, renderer->cameraTextureId);
-            glUniform1i(texUniform, 0);
-            
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            renderPassDraw(renderer->readbackPass, renderer->vertexBuffer);
             
-            glDisableVertexAttribArray(posLoc);
-            glDisableVertexAttribArray(texLoc);
+            int64_t readbackStart = monotonicNanos();
+            stageRecord(renderer->stageStats, STAGE_FBO_RENDER, fboStart, readbackStart);
             
-            // Step 2: Read pixels from FBO
-            std::vector<unsigned char> pixels(renderer->cameraWidth * renderer->cameraHeight * 4);
-            glReadPixels(0, 0, renderer->cameraWidth, renderer->cameraHeight, 
-                        GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-            
-            // Step 3: Process with OpenCV
-            cv::Mat frameMat(renderer->cameraHeight, renderer->cameraWidth, CV_8UC4, pixels.data());
-            cv::Mat flipped;
-            cv::flip(frameMat, flipped, 0);  // Flip vertically (OpenGL origin is bottom-left)
-            
-            // Apply Canny edge detection
-            cv::Mat processed = processFrameWithCanny(flipped);
-            
-            // Step 4: Upload processed frame back to texture
-            cv::flip(processed, frameMat, 0);  // Flip back for OpenGL
-            glBindTexture(GL_TEXTURE_2D, renderer->outputTextureId);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, renderer->cameraWidth, renderer->cameraHeight,
-                        0, GL_RGBA, GL_UNSIGNED_BYTE, frameMat.data);
+            // Step 2: Read pixels from FBO (a frame late when asynchronous) and
+            // hand them to the worker
+            readbackToWorker(renderer);
+            stageRecord(renderer->stageStats, STAGE_READBACK, readbackStart, monotonicNanos());
+        }
+        
+        // Step 3: The worker runs Canny (result stays in GL row order)
+        // Step 4: Upload the newest finished edge frame, if any, to the output texture
+        if (renderer->edgeFrames.update()) {
+            uploadEdgeFrame(renderer, renderer->edgeFrames.front());
         }
         
         // Unbind FBO
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         
-        // Use processed texture for final render
-        textureToRender = renderer->outputTextureId;
-        textureTarget = GL_TEXTURE_2D;
+        // Use processed texture for final render (the camera until the first edge frame)
+        if (streamTextureCurrent(renderer->output) != 0) {
+            textureToRender = streamTextureCurrent(renderer->output);
+            textureTarget = GL_TEXTURE_2D;
+            edgeFormat = renderer->outputFormat;
+            orientation = renderer->outputOrientation;
+        }
         
         // Restore viewport
         glViewport(0, 0, renderer->width, renderer->height);
     }
     
     // Draw quad with camera texture
-    glUseProgram(textureTarget == GL_TEXTURE_EXTERNAL_OES ? renderer->program : renderer->program2D);
-    
-    // Simple quad vertices (full screen)
-    float vertices[] = {
-        -1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
-         1.0f, -1.0f, 0.0f,  1.0f, 0.0f,
-        -1.0f,  1.0f, 0.0f,  0.0f, 1.0f,
-         1.0f,  1.0f, 0.0f,  1.0f, 1.0f
-    };
-    
-    GLuint currentProgram = textureTarget == GL_TEXTURE_EXTERNAL_OES ? renderer->program : renderer->program2D;
-    
-    GLint positionLoc = glGetAttribLocation(currentProgram, "aPosition");
-    GLint texCoordLoc = glGetAttribLocation(currentProgram, "aTexCoord");
-    GLint textureLoc = glGetUniformLocation(currentProgram, "uTexture");
-    GLint rotationLoc = glGetUniformLocation(currentProgram, "uRotation");
-    GLint isFrontCameraLoc = glGetUniformLocation(currentProgram, "uIsFrontCamera");
-    
-    glEnableVertexAttribArray(positionLoc);
-    glEnableVertexAttribArray(texCoordLoc);
-    
-    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), vertices);
-    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), vertices + 3);
-    
-    // Set rotation and front camera uniforms
-    glUniform1f(rotationLoc, static_cast<GLfloat>(renderer->cameraRotation));
-    glUniform1i(isFrontCameraLoc, renderer->isFrontCamera ? 1 : 0);
-    
-    // Bind camera texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(textureTarget, textureToRender);
-    glUniform1i(textureLoc, 0);
+    int64_t drawStart = monotonicNanos();
+    RenderPass& pass = textureTarget == GL_TEXTURE_EXTERNAL_OES ? renderer->cameraPass : renderer->edgePass;
+    
+    // Bind camera texture, or the edge texture with its layout and edge color
+    if (textureTarget == GL_TEXTURE_EXTERNAL_OES) {
+        glUseProgram(pass.program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(textureTarget, textureToRender);
+    } else {
+        uint32_t argb = renderer->edgeColor;
+        const float color[4] = {((argb >> 16) & 0xFF) / 255.0f, ((argb >> 8) & 0xFF) / 255.0f,
+                                (argb & 0xFF) / 255.0f, (argb >> 24) / 255.0f};
+        edgeProgramUse(renderer->edgeProgram, textureToRender, edgeFormat == EDGE_FORMAT_PACKED,
+                       renderer->outputWidth, color);
+    }
     
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    // Orient the frame as it was captured (edge frames may be a few frames old);
+    // the matrix is only re-uploaded when the rotation or camera changes
+    renderPassSetOrientation(pass, orientation.rotation, orientation.mirrored, !orientation.bottomUp);
+    renderPassDraw(pass, renderer->vertexBuffer);
+    stageRecord(renderer->stageStats, STAGE_DRAW, drawStart, monotonicNanos());
     
-    glDisableVertexAttribArray(positionLoc);
-    glDisableVertexAttribArray(texCoordLoc);
+    // Publish the frame counters for the stats reporter; FPS is computed there
+    renderer->frameIndex++;
+    FrameCounters counters;
+    counters.timestampNanos = monotonicNanos();
+    counters.framesDrawn = renderer->frameIndex;
+    counters.framesProcessed = renderer->processedFrames;
+    renderer->frameCounters.write(counters);
     
-    // Update FPS
-    renderer->frameCount++;
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - renderer->lastFpsTime).count();
     
     if (elapsed >= 1000) {
-        renderer->currentFps = (renderer->frameCount * 1000) / elapsed;
-        renderer->frameCount = 0;
         renderer->lastFpsTime = now;
         
-        // Call Java callback
-        if (renderer->fpsCallback != nullptr) {
-            JNIEnv* jniEnv;
-            jint result = renderer->jvm->GetEnv(reinterpret_cast<void**>(&jniEnv), JNI_VERSION_1_6);
-            if (result == JNI_OK) {
-                jclass callbackClass = jniEnv->GetObjectClass(renderer->fpsCallback);
-                jmethodID onFpsUpdateMethod = jniEnv->GetMethodID(callbackClass, "onFpsUpdate", "(I)V");
-                if (onFpsUpdateMethod != nullptr) {
-                    jniEnv->CallVoidMethod(renderer->fpsCallback, onFpsUpdateMethod, renderer->currentFps);
-                }
-            } else if (result == JNI_EDETACHED) {
-                // Attach thread if needed
-                jniEnv = nullptr;
-                if (renderer->jvm->AttachCurrentThread(&jniEnv, nullptr) == JNI_OK) {
-                    jclass callbackClass = jniEnv->GetObjectClass(renderer->fpsCallback);
-                    jmethodID onFpsUpdateMethod = jniEnv->GetMethodID(callbackClass, "onFpsUpdate", "(I)V");
-                    if (onFpsUpdateMethod != nullptr) {
-                        jniEnv->CallVoidMethod(renderer->fpsCallback, onFpsUpdateMethod, renderer->currentFps);
-                    }
-                    renderer->jvm->DetachCurrentThread();
-                }
-            }
+        // Average size and CPU-side cost of the edge uploads since the last update
+        if (renderer->uploadCount > 0) {
+            renderer->uploadBytesPerFrame = static_cast<int>(renderer->uploadBytes / renderer->uploadCount);
+            renderer->uploadNanosPerFrame = static_cast<int>(renderer->uploadNanos / renderer->uploadCount);
+            renderer->uploadFormat = renderer->outputFormat;
+        } else {
+            renderer->uploadBytesPerFrame = 0;
+            renderer->uploadNanosPerFrame = 0;
         }
+        renderer->uploadBytes = 0;
+        renderer->uploadNanos = 0;
+        renderer->uploadCount = 0;
+        
+        int frameAllocations = renderer->framePool.allocations();
+        renderer->frameAllocationsPerSecond = ((frameAllocations - renderer->lastFrameAllocations) * 1000) / elapsed;
+        renderer->lastFrameAllocations = frameAllocations;
+        
+        int allocations = renderer->textureAllocations + renderer->output.allocations;
+        renderer->textureAllocationsPerSecond = ((allocations - renderer->lastTextureAllocations) * 1000) / elapsed;
+        renderer->lastTextureAllocations = allocations;
     }
     
+    int64_t swapStart = monotonicNanos();
     eglSwapBuffers(renderer->display, renderer->surface);
+    int64_t frameEnd = monotonicNanos();
+    stageRecord(renderer->stageStats, STAGE_SWAP, swapStart, frameEnd);
+    stageRecord(renderer->stageStats, STAGE_FRAME, frameStart, frameEnd);
 }
 
-extern "C" JNIEXPORT void JNICALL
-Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeSetCameraRotation(JNIEnv *env, jobject thiz, jlong rendererPtr, jint rotation, jboolean isFrontCamera) {
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetCameraRotation(jlong rendererPtr, jint rotation, jboolean isFrontCamera) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     renderer->cameraRotation = rotation;
     renderer->isFrontCamera = isFrontCamera;
 }
 
-extern "C" JNIEXPORT void JNICALL
+static void JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeSetFpsCallback(JNIEnv *env, jobject thiz, jlong rendererPtr, jobject callback) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
-    
-    if (renderer->fpsCallback != nullptr) {
-        env->DeleteGlobalRef(renderer->fpsCallback);
+    setReporterCallback(env, renderer, renderer->fpsCallback, callback);
+}
+
+// Delivers a stats record (StatsField layout) to `callback` every `intervalMs`
+// on the reporter thread; also sets how often the FPS callback runs
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeSetStatsCallback(JNIEnv *env, jobject thiz, jlong rendererPtr, jobject callback, jint intervalMs) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    {
+        std::lock_guard<std::mutex> lock(renderer->reporterMutex);
+        renderer->reportIntervalMs = std::max(10, static_cast<int>(intervalMs));
+    }
+    setReporterCallback(env, renderer, renderer->statsCallback, callback);
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetEdgeBackend(jlong rendererPtr, jint backend) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    renderer->edgeBackend = backend == EDGE_BACKEND_GPU ? EDGE_BACKEND_GPU : EDGE_BACKEND_CPU;
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetAsyncReadback(jlong rendererPtr, jboolean enabled) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    renderer->asyncReadback = enabled;
+}
+
+static jint JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeGetReadbackLatency(jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    return renderer->readbackLatencyFrames;
+}
+
+static jint JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeGetTextureAllocationsPerSecond(jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    return renderer->textureAllocationsPerSecond;
+}
+
+static jint JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeGetFrameAllocationsPerSecond(jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    return renderer->frameAllocationsPerSecond;
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetEdgeFormat(jlong rendererPtr, jint format) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    if (format >= EDGE_FORMAT_RGBA && format <= EDGE_FORMAT_PACKED) {
+        renderer->edgeFormat = format;
+    }
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetEdgeColor(jlong rendererPtr, jint argb) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    renderer->edgeColor = static_cast<uint32_t>(argb);
+}
+
+// Returns {edge format, upload bytes per frame, upload nanoseconds per frame}
+static jintArray JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeGetUploadStats(JNIEnv *env, jobject thiz, jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    jint stats[3] = {renderer->uploadFormat, renderer->uploadBytesPerFrame, renderer->uploadNanosPerFrame};
+    jintArray result = env->NewIntArray(3);
+    if (result != nullptr) {
+        env->SetIntArrayRegion(result, 0, 3, stats);
+    }
+    return result;
+}
+
+// Returns STAGE_COUNT * STAGE_FIELD_COUNT longs: per stage, in Stage order,
+// {count, p50, p90, p99, max, last} in nanoseconds. With `reset`, the next
+// call only reports samples recorded after this one.
+static jlongArray JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeGetStageStats(JNIEnv *env, jobject thiz, jlong rendererPtr, jboolean reset) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    const jsize size = STAGE_COUNT * STAGE_FIELD_COUNT;
+    int64_t packed[size];
+    {
+        std::lock_guard<std::mutex> lock(renderer->stageBaselineMutex);
+        stageStatsPack(renderer->stageStats, renderer->stageBaselineTaken ? &renderer->stageBaseline : nullptr,
+                       packed);
+        if (reset) {
+            stageBaselineTake(renderer->stageStats, renderer->stageBaseline);
+            renderer->stageBaselineTaken = true;
+        }
     }
     
-    if (callback != nullptr) {
-        renderer->fpsCallback = env->NewGlobalRef(callback);
+    jlongArray result = env->NewLongArray(size);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, size, reinterpret_cast<const jlong*>(packed));
+    }
+    return result;
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeSetTracing(JNIEnv *env, jobject thiz, jlong rendererPtr, jboolean enabled) {
+    if (enabled) {
+        traceEnable();
     } else {
-        renderer->fpsCallback = nullptr;
+        traceDisable();
+    }
+}
+
+// Writes the spans recorded since tracing was enabled as Chrome trace JSON
+static jboolean JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeDumpTrace(JNIEnv *env, jobject thiz, jlong rendererPtr, jstring path) {
+    if (path == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        return JNI_FALSE;
+    }
+    bool written = traceWriteChromeJson(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return written ? JNI_TRUE : JNI_FALSE;
+}
+
+// Returns {published, consumed, overwritten, dropped} of the submitted frame ring
+static jlongArray JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeGetSubmittedFrameCounters(JNIEnv *env, jobject thiz, jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    FrameRingCounters counters = renderer->submittedFrames.counters();
+    jlong values[4] = {static_cast<jlong>(counters.published), static_cast<jlong>(counters.consumed),
+                       static_cast<jlong>(counters.overwritten), static_cast<jlong>(counters.dropped)};
+    jlongArray result = env->NewLongArray(4);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Sets the CPU kernel's time budget per input frame; 0 turns the quality
+// governor off and returns to full quality. Unless higherQuality is set, the
+// governor steps no higher than the default level, so headroom never changes
+// the edges drawn.
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetFrameBudget(JNIEnv *env, jclass clazz, jlong rendererPtr, jfloat budgetMs, jboolean higherQuality) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    std::lock_guard<std::mutex> lock(renderer->governorMutex);
+    int64_t now = monotonicNanos();
+    governorSetBestLevel(renderer->governor, higherQuality ? 0 : kDefaultQualityLevel, now);
+    governorSetBudget(renderer->governor, static_cast<int64_t>(std::max(0.0f, budgetMs) * 1e6), now);
+}
+
+// Sets the least factor the CPU kernel shrinks frames by (1, 2 or 4) and how
+// the display magnifies the smaller edge maps
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetProcessingScale(jlong rendererPtr, jint scale, jboolean linearMagnification) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    if (scale == 1 || scale == 2 || scale == 4) {
+        renderer->processingScale = scale;
     }
+    renderer->linearMagnification = linearMagnification == JNI_TRUE;
+}
+
+// Skips the CPU kernel on frames whose blocks all changed by at most
+// `threshold` luma levels since the last processed one, processing at least
+// every `refreshMs`; a threshold of 0 turns the gate off
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_nativeSetMotionGate(JNIEnv *env, jclass clazz, jlong rendererPtr, jint threshold, jint refreshMs) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    std::lock_guard<std::mutex> lock(renderer->motionMutex);
+    motionGateConfigure(renderer->motionGate, threshold, static_cast<int64_t>(std::max(0, refreshMs)) * 1000000);
+    renderer->staticFrames = 0;
 }
 
-extern "C" JNIEXPORT void JNICALL
+// Returns the governor's recent level changes, oldest first, as
+// {timestampNanos, fromLevel, toLevel, costNanos} per change
+static jlongArray JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeGetQualityTransitions(JNIEnv *env, jobject thiz, jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    QualityTransition transitions[QualityGovernor::kHistorySize];
+    int count;
+    {
+        std::lock_guard<std::mutex> lock(renderer->governorMutex);
+        count = governorHistory(renderer->governor, transitions, QualityGovernor::kHistorySize);
+    }
+    jlong values[QualityGovernor::kHistorySize * 4];
+    for (int i = 0; i < count; i++) {
+        values[i * 4] = transitions[i].timestampNanos;
+        values[i * 4 + 1] = transitions[i].fromLevel;
+        values[i * 4 + 2] = transitions[i].toLevel;
+        values[i * 4 + 3] = transitions[i].costNanos;
+    }
+    jlongArray result = env->NewLongArray(count * 4);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, count * 4, values);
+    }
+    return result;
+}
+
+// Starts recording every input frame the kernel sees to `path`
+static jboolean JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeStartRecording(JNIEnv *env, jobject thiz, jlong rendererPtr, jstring path, jint maxFrames) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    if (path == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        return JNI_FALSE;
+    }
+    bool started = renderer->frameRecorder.start(pathChars, maxFrames);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+// Finishes the recording; returns {frames written, frames dropped}
+static jintArray JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeStopRecording(JNIEnv *env, jobject thiz, jlong rendererPtr) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    renderer->frameRecorder.stop();
+    
+    jint counts[2] = {renderer->frameRecorder.framesWritten(), renderer->frameRecorder.framesDropped()};
+    jintArray result = env->NewIntArray(2);
+    if (result != nullptr) {
+        env->SetIntArrayRegion(result, 0, 2, counts);
+    }
+    return result;
+}
+
+// Helper function to size and describe the submitted frame slot the caller fills next
+CameraFrame& nextSubmittedFrame(RendererState* renderer, int width, int height) {
+    CameraFrame& frame = *renderer->submittedFrames.beginWrite();  // Latest-wins always has one
+    frame.pixels.create(height, width, CV_8UC4);  // From the pool, and only on a size change
+    frame.orientation = captureOrientation(renderer);
+    frame.orientation.bottomUp = false;  // Frames from Java are top-down
+    return frame;
+}
+
+// Helper function to hand the filled slot to the worker
+void publishSubmittedFrame(RendererState* renderer) {
+    renderer->submittedFrames.endWrite();
+    renderer->submittedInput = true;
+    wakeWorker(renderer);
+}
+
+// Helper function to get the direct ByteBuffer over the slot the caller fills
+// next, creating it when the slot's memory changed. The memory stays lent
+// until the buffer comes back, so recreating the slot for a frame of another
+// size never frees it under Java.
+jobject submitBuffer(JNIEnv* env, RendererState* renderer) {
+    int slot = renderer->submittedFrames.writeSlot();
+    const cv::Mat& pixels = renderer->submittedFrames.beginWrite()->pixels;
+    lendFrame(renderer->lentFrames, pixels);
+    jobject& buffer = renderer->submitBuffers[slot];
+    jlong bytes = static_cast<jlong>(pixels.total() * pixels.elemSize());
+    if (buffer != nullptr && (env->GetDirectBufferAddress(buffer) != pixels.data ||
+                              env->GetDirectBufferCapacity(buffer) != bytes)) {
+        env->DeleteGlobalRef(buffer);
+        buffer = nullptr;
+    }
+    if (buffer == nullptr) {
+        jobject local = env->NewDirectByteBuffer(pixels.data, bytes);
+        if (local == nullptr) {
+            return nullptr;
+        }
+        buffer = env->NewGlobalRef(local);
+        env->DeleteLocalRef(local);
+    }
+    return env->NewLocalRef(buffer);
+}
+
+// Submits an RGBA frame from a Java array. The array is read in place and
+// copied once, into the pooled slot the worker picks up; no lock is held.
+static void JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeProcessFrame(
     JNIEnv *env, jobject thiz, jlong rendererPtr, jbyteArray frameData, jint width, jint height) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     
-    if (frameData == nullptr || width <= 0 || height <= 0) {
+    if (frameData == nullptr || width <= 0 || height <= 0 ||
+        env->GetArrayLength(frameData) < static_cast<jlong>(width) * height * 4) {
         return;
     }
     
-    jsize length = env->GetArrayLength(frameData);
-    jbyte* data = env->GetByteArrayElements(frameData, nullptr);
-    
+    CameraFrame& frame = nextSubmittedFrame(renderer, width, height);
+    void* data = env->GetPrimitiveArrayCritical(frameData, nullptr);
     if (data != nullptr) {
-        std::lock_guard<std::mutex> lock(renderer->frameMutex);
-        
-        // Create OpenCV Mat from byte array (RGBA format)
-        cv::Mat frame(height, width, CV_8UC4, data);
-        renderer->currentFrame = frame.clone();
-        renderer->frameReady = true;
-        
-        env->ReleaseByteArrayElements(frameData, data, JNI_ABORT);
+        std::memcpy(frame.pixels.data, data, frame.pixels.total() * frame.pixels.elemSize());
+        env->ReleasePrimitiveArrayCritical(frameData, data, JNI_ABORT);
+        publishSubmittedFrame(renderer);
+    }
+}
+
+// Returns a direct ByteBuffer over native memory to fill with a width x height
+// RGBA frame and pass to nativeProcessFrameBuffer
+static jobject JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeAcquireFrameBuffer(
+    JNIEnv *env, jobject thiz, jlong rendererPtr, jint width, jint height) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    if (width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    nextSubmittedFrame(renderer, width, height);
+    return submitBuffer(env, renderer);
+}
+
+// Submits an RGBA frame from a direct ByteBuffer. A buffer handed out by
+// nativeAcquireFrameBuffer (or returned by a previous call) is swapped into
+// the pipeline as is, and rejected if passed with a size other than the one
+// it was acquired for; any other direct buffer, or a handed-out one whose
+// slot has since been resized, is copied once. Returns the buffer to fill
+// next.
+static jobject JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeProcessFrameBuffer(
+    JNIEnv *env, jobject thiz, jlong rendererPtr, jobject frameBuffer, jint width, jint height) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    
+    const uchar* data = frameBuffer != nullptr ? static_cast<const uchar*>(env->GetDirectBufferAddress(frameBuffer)) : nullptr;
+    jlong bytes = static_cast<jlong>(width) * height * 4;
+    if (data == nullptr || width <= 0 || height <= 0 || env->GetDirectBufferCapacity(frameBuffer) < bytes) {
+        return nullptr;
+    }
+    
+    if (!fillFrame(renderer->submittedFrames.beginWrite()->pixels, data, height, width, CV_8UC4)) {
+        return nullptr;  // The slot's own buffer, passed with a different size
+    }
+    returnFrame(renderer->lentFrames, data);  // Swapped in or copied: Java lets go of it
+    nextSubmittedFrame(renderer, width, height);  // Already sized; sets the orientation
+    publishSubmittedFrame(renderer);
+    
+    nextSubmittedFrame(renderer, width, height);
+    return submitBuffer(env, renderer);
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeProcessYuvFrame(
+    JNIEnv *env, jobject thiz, jlong rendererPtr, jobject yPlane, jint width, jint height,
+    jint rowStride, jint pixelStride) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    
+    if (yPlane == nullptr || width <= 0 || height <= 0 || pixelStride <= 0 ||
+        rowStride < (width - 1) * pixelStride + 1) {
+        return;
+    }
+    
+    // Y plane of a YUV_420_888 Image, read in place through its strides
+    const uchar* data = static_cast<const uchar*>(env->GetDirectBufferAddress(yPlane));
+    jlong capacity = env->GetDirectBufferCapacity(yPlane);
+    jlong required = static_cast<jlong>(height - 1) * rowStride + static_cast<jlong>(width - 1) * pixelStride + 1;
+    if (data == nullptr || capacity < required) {
+        return;
+    }
+    
+    if (processLumaEdges(renderer, data, width, height, rowStride, pixelStride)) {
+        publishLumaEdges(renderer);
+    }
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeProcessNv21Frame(
+    JNIEnv *env, jobject thiz, jlong rendererPtr, jbyteArray frameData, jint width, jint height) {
+    RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
+    
+    if (frameData == nullptr || width <= 0 || height <= 0 ||
+        env->GetArrayLength(frameData) < width * height) {
+        return;
+    }
+    
+    // NV21 and I420 both start with a tightly packed Y plane. It is copied
+    // into a pooled Mat first, so the kernel (which takes locks and runs
+    // parallel_for_) never runs with the array pinned.
+    cv::Mat& luma = renderer->nv21Luma;
+    luma.create(height, width, CV_8UC1);  // From the pool, and only on a size change
+    env->GetByteArrayRegion(frameData, 0, width * height, reinterpret_cast<jbyte*>(luma.data));
+    if (processLumaEdges(renderer, luma.data, width, height, width, 1)) {
+        publishLumaEdges(renderer);
     }
 }
 
-extern "C" JNIEXPORT void JNICALL
+static void JNICALL
 Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeRelease(JNIEnv *env, jobject thiz, jlong rendererPtr) {
     RendererState* renderer = reinterpret_cast<RendererState*>(rendererPtr);
     
+    {
+        std::lock_guard<std::mutex> lock(renderer->workerMutex);
+        renderer->workerStop = true;
+    }
+    renderer->workerWake.notify_one();
+    if (renderer->worker.joinable()) {
+        renderer->worker.join();
+    }
+    renderer->frameRecorder.stop();
+    
+    {
+        std::lock_guard<std::mutex> lock(renderer->reporterMutex);
+        renderer->reporterStop = true;
+    }
+    renderer->reporterWake.notify_one();
+    if (renderer->reporter.joinable()) {
+        renderer->reporter.join();
+    }
     if (renderer->fpsCallback != nullptr) {
         env->DeleteGlobalRef(renderer->fpsCallback);
     }
+    if (renderer->statsCallback != nullptr) {
+        env->DeleteGlobalRef(renderer->statsCallback);
+    }
+    for (int i = 0; i < 3; i++) {
+        if (renderer->submitBuffers[i] != nullptr) {
+            env->DeleteGlobalRef(renderer->submitBuffers[i]);
+        }
+    }
+    
+    readbackRingDestroy(renderer->readbackRing);
+    gpuCannyDestroy(renderer->gpuCanny);
     
     if (renderer->fbo != 0) {
         glDeleteFramebuffers(1, &renderer->fbo);
     }
     
-    if (renderer->outputTextureId != 0) {
-        glDeleteTextures(1, &renderer->outputTextureId);
+    if (renderer->fboTextureId != 0) {
+        glDeleteTextures(1, &renderer->fboTextureId);
     }
     
+    streamTextureDestroy(renderer->output);
+    
     if (renderer->program != 0) {
         glDeleteProgram(renderer->program);
     }
     
-    if (renderer->program2D != 0) {
-        glDeleteProgram(renderer->program2D);
+    if (renderer->readbackProgram != 0) {
+        glDeleteProgram(renderer->readbackProgram);
+    }
+    
+    if (renderer->vertexBuffer != 0) {
+        glDeleteBuffers(1, &renderer->vertexBuffer);
     }
     
+    edgeProgramDestroy(renderer->edgeProgram);
+    
     if (renderer->surface != EGL_NO_SURFACE) {
         eglDestroySurface(renderer->display, renderer->surface);
     }
@@ -555,3 +1405,362 @@ Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_nativeRele
     delete renderer;
 }
 
+
+// NativeBridge: edge detection on still images, outside the renderer
+
+// Kernel scratch of each thread calling NativeBridge, kept between images
+static thread_local CannyWorkspace g_imageWorkspace;
+
+// Copies of the Java arrays nativeProcessImage works on, kept between images
+static thread_local cv::Mat g_imageInput;
+static thread_local cv::Mat g_imageOutput;
+
+// Helper function to run the still-image kernel and return how long it took
+jlong processImageTimed(const uchar* input, int width, int height, int inputStride, uchar* output) {
+    int64_t start = monotonicNanos();
+    processStillImage(input, width, height, inputStride, output, width * 4, EdgeParams(), &g_imageWorkspace);
+    return static_cast<jlong>(monotonicNanos() - start);
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_NativeBridge_initOpenCV(JNIEnv *env, jobject thiz) {
+    cv::setUseOptimized(true);
+    
+    // One small image starts OpenCV's worker threads and sizes this thread's
+    // workspace, so the first real image isn't charged for either
+    std::vector<uchar> image(64 * 64 * 4, 0);
+    std::vector<uchar> edges(image.size());
+    processImageTimed(image.data(), 64, 64, 64 * 4, edges.data());
+}
+
+// Processes an RGBA image between Java arrays. The kernel runs on copies, so
+// neither array is pinned while it does and the collector never waits on it.
+static jlong JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeProcessImage(
+    JNIEnv *env, jobject thiz, jbyteArray inputData, jint width, jint height, jbyteArray outputData) {
+    if (inputData == nullptr || outputData == nullptr || width <= 0 || height <= 0 ||
+        env->IsSameObject(inputData, outputData)) {
+        return -1;
+    }
+    jlong bytes = static_cast<jlong>(width) * height * 4;
+    if (env->GetArrayLength(inputData) < bytes || env->GetArrayLength(outputData) < bytes) {
+        return -1;
+    }
+    
+    g_imageInput.create(height, width, CV_8UC4);  // Reallocated only on a size change
+    g_imageOutput.create(height, width, CV_8UC4);
+    env->GetByteArrayRegion(inputData, 0, static_cast<jsize>(bytes), reinterpret_cast<jbyte*>(g_imageInput.data));
+    jlong nanos = processImageTimed(g_imageInput.data, width, height, width * 4, g_imageOutput.data);
+    env->SetByteArrayRegion(outputData, 0, static_cast<jsize>(bytes), reinterpret_cast<const jbyte*>(g_imageOutput.data));
+    return nanos;
+}
+
+// Processes an RGBA image between direct ByteBuffers, in place in their memory
+static jlong JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeProcessImageBuffer(
+    JNIEnv *env, jobject thiz, jobject inputBuffer, jint width, jint height, jint rowStride,
+    jobject outputBuffer) {
+    if (inputBuffer == nullptr || outputBuffer == nullptr || width <= 0 || height <= 0 ||
+        rowStride < width * 4) {
+        return -1;
+    }
+    const uchar* input = static_cast<const uchar*>(env->GetDirectBufferAddress(inputBuffer));
+    uchar* output = static_cast<uchar*>(env->GetDirectBufferAddress(outputBuffer));
+    jlong inputBytes = static_cast<jlong>(height - 1) * rowStride + static_cast<jlong>(width) * 4;
+    jlong outputBytes = static_cast<jlong>(width) * height * 4;
+    if (input == nullptr || output == nullptr ||
+        env->GetDirectBufferCapacity(inputBuffer) < inputBytes ||
+        env->GetDirectBufferCapacity(outputBuffer) < outputBytes ||
+        (output < input + inputBytes && input < output + outputBytes)) {
+        return -1;
+    }
+    return processImageTimed(input, width, height, rowStride, output);
+}
+
+// Workers for batches of still images, started on the first batch
+ImagePool& imagePool() {
+    static ImagePool pool;
+    return pool;
+}
+
+// Helper function to describe a batch of direct RGBA buffers as pool jobs.
+// Images whose buffers are missing or too small get a null input, which the
+// pool reports as failed.
+std::vector<ImageJob> imageJobs(JNIEnv* env, jobjectArray inputs, jobjectArray outputs,
+                                jintArray widths, jintArray heights, jintArray rowStrides) {
+    jsize count = env->GetArrayLength(inputs);
+    if (env->GetArrayLength(outputs) < count || env->GetArrayLength(widths) < count ||
+        env->GetArrayLength(heights) < count ||
+        (rowStrides != nullptr && env->GetArrayLength(rowStrides) < count)) {
+        return std::vector<ImageJob>();
+    }
+    std::vector<jint> width(count), height(count), rowStride(count, 0);
+    env->GetIntArrayRegion(widths, 0, count, width.data());
+    env->GetIntArrayRegion(heights, 0, count, height.data());
+    if (rowStrides != nullptr) {
+        env->GetIntArrayRegion(rowStrides, 0, count, rowStride.data());
+    }
+    
+    std::vector<ImageJob> jobs(count);
+    for (jsize i = 0; i < count; i++) {
+        ImageJob& job = jobs[i];
+        job.width = width[i];
+        job.height = height[i];
+        job.inputStride = rowStride[i] > 0 ? rowStride[i] : width[i] * 4;
+        job.outputStride = width[i] * 4;
+        if (job.width <= 0 || job.height <= 0 || job.inputStride < job.width * 4) {
+            continue;
+        }
+        
+        // The buffers stay reachable through the arrays, so their addresses
+        // outlive the local references
+        jobject input = env->GetObjectArrayElement(inputs, i);
+        jobject output = env->GetObjectArrayElement(outputs, i);
+        if (input != nullptr && output != nullptr) {
+            jlong inputBytes = static_cast<jlong>(job.height - 1) * job.inputStride + static_cast<jlong>(job.width) * 4;
+            jlong outputBytes = static_cast<jlong>(job.outputStride) * job.height;
+            uchar* inputData = static_cast<uchar*>(env->GetDirectBufferAddress(input));
+            uchar* outputData = static_cast<uchar*>(env->GetDirectBufferAddress(output));
+            if (inputData != nullptr && outputData != nullptr &&
+                env->GetDirectBufferCapacity(input) >= inputBytes &&
+                env->GetDirectBufferCapacity(output) >= outputBytes &&
+                (outputData >= inputData + inputBytes || inputData >= outputData + outputBytes)) {
+                job.input = inputData;
+                job.output = outputData;
+            }
+        }
+        env->DeleteLocalRef(input);
+        env->DeleteLocalRef(output);
+    }
+    return jobs;
+}
+
+// Processes a batch of images on the pool in one call. Completions are
+// reported to `callback` on the calling thread, in the order they happen,
+// while the pool works on the rest. Returns each image's processing time.
+static jlongArray JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeProcessImages(
+    JNIEnv *env, jobject thiz, jobjectArray inputs, jobjectArray outputs, jintArray widths,
+    jintArray heights, jintArray rowStrides, jobject callback) {
+    if (inputs == nullptr || outputs == nullptr || widths == nullptr || heights == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<ImageBatch> batch =
+        imagePool().submit(imageJobs(env, inputs, outputs, widths, heights, rowStrides));
+    
+    for (int completed = 1; completed <= batch->size(); completed++) {
+        int index = batch->waitCompleted(completed);
+        if (callback != nullptr && !env->ExceptionCheck()) {
+            env->CallVoidMethod(callback, g_jni.onImageProcessed, index,
+                                static_cast<jlong>(batch->imageNanos(index)));
+        }
+    }
+    batch->wait();  // Even after a failed callback: the pool still uses the buffers
+    if (env->ExceptionCheck()) {
+        return nullptr;  // The callback's exception propagates to the caller
+    }
+    
+    std::vector<jlong> nanos(batch->size());
+    batch->copyImageNanos(reinterpret_cast<int64_t*>(nanos.data()));
+    jlongArray result = env->NewLongArray(batch->size());
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, batch->size(), nanos.data());
+    }
+    return result;
+}
+
+// Queues a batch of images on the pool and returns a handle for polling it
+static jlong JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeSubmitImages(
+    JNIEnv *env, jobject thiz, jobjectArray inputs, jobjectArray outputs, jintArray widths,
+    jintArray heights, jintArray rowStrides) {
+    if (inputs == nullptr || outputs == nullptr || widths == nullptr || heights == nullptr) {
+        return 0;
+    }
+    auto batch = new std::shared_ptr<ImageBatch>(
+        imagePool().submit(imageJobs(env, inputs, outputs, widths, heights, rowStrides)));
+    return reinterpret_cast<jlong>(batch);
+}
+
+// Copies the batch's per-image times into `nanos`, after waiting for all of
+// them if asked, and returns how many images are done
+static jint JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeBatchPoll(
+    JNIEnv *env, jobject thiz, jlong batchPtr, jlongArray nanos, jboolean wait) {
+    ImageBatch& batch = **reinterpret_cast<std::shared_ptr<ImageBatch>*>(batchPtr);
+    if (wait) {
+        batch.wait();
+    }
+    int completed = batch.completed();
+    if (nanos != nullptr && env->GetArrayLength(nanos) >= batch.size()) {
+        std::vector<jlong> times(batch.size());
+        batch.copyImageNanos(reinterpret_cast<int64_t*>(times.data()));
+        env->SetLongArrayRegion(nanos, 0, batch.size(), times.data());
+    }
+    return completed;
+}
+
+static void JNICALL
+Java_com_opencv_edgedetector_NativeBridge_nativeBatchRelease(JNIEnv *env, jobject thiz, jlong batchPtr) {
+    auto batch = reinterpret_cast<std::shared_ptr<ImageBatch>*>(batchPtr);
+    (*batch)->wait();
+    delete batch;
+}
+
+// Helper function to register a class's native methods
+static bool registerNatives(JNIEnv* env, const char* className, const JNINativeMethod* methods, int count) {
+    jclass clazz = env->FindClass(className);
+    if (clazz == nullptr) {
+        return false;
+    }
+    bool registered = env->RegisterNatives(clazz, methods, count) == JNI_OK;
+    env->DeleteLocalRef(clazz);
+    return registered;
+}
+
+// Native methods of OpenGLSurfaceView.OpenGLRenderer, registered explicitly
+// instead of looked up by symbol name. The frame submission entries use the
+// env only for pixels: a short array copy, a direct buffer's address, or the
+// buffers they hand out to be filled. The Java callbacks run on the reporter
+// thread.
+#define RENDERER_METHOD(name, signature) \
+    {#name, signature, reinterpret_cast<void*>(Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024OpenGLRenderer_##name)}
+
+static const JNINativeMethod kRendererMethods[] = {
+    RENDERER_METHOD(nativeSetTracing, "(JZ)V"),
+    RENDERER_METHOD(nativeInit, "()J"),
+    RENDERER_METHOD(nativeOnSurfaceCreated, "(JI)V"),
+    RENDERER_METHOD(nativeOnSurfaceChanged, "(JII)V"),
+    RENDERER_METHOD(nativeSetFpsCallback, "(JLcom/opencv/edgedetector/gl/FpsCallback;)V"),
+    RENDERER_METHOD(nativeSetStatsCallback, "(JLcom/opencv/edgedetector/gl/StatsCallback;I)V"),
+    RENDERER_METHOD(nativeGetUploadStats, "(J)[I"),
+    RENDERER_METHOD(nativeGetStageStats, "(JZ)[J"),
+    RENDERER_METHOD(nativeDumpTrace, "(JLjava/lang/String;)Z"),
+    RENDERER_METHOD(nativeGetSubmittedFrameCounters, "(J)[J"),
+    RENDERER_METHOD(nativeGetQualityTransitions, "(J)[J"),
+    RENDERER_METHOD(nativeStartRecording, "(JLjava/lang/String;I)Z"),
+    RENDERER_METHOD(nativeStopRecording, "(J)[I"),
+    RENDERER_METHOD(nativeProcessFrame, "(J[BII)V"),
+    RENDERER_METHOD(nativeAcquireFrameBuffer, "(JII)Ljava/nio/ByteBuffer;"),
+    RENDERER_METHOD(nativeProcessFrameBuffer, "(JLjava/nio/ByteBuffer;II)Ljava/nio/ByteBuffer;"),
+    RENDERER_METHOD(nativeProcessYuvFrame, "(JLjava/nio/ByteBuffer;IIII)V"),
+    RENDERER_METHOD(nativeProcessNv21Frame, "(J[BII)V"),
+    RENDERER_METHOD(nativeRelease, "(J)V"),
+};
+
+#undef RENDERER_METHOD
+
+// Adapter for a @CriticalNative entry on a runtime that ignores the
+// annotation and passes the JNIEnv and jclass anyway: drops both
+template <auto Fn>
+struct WithEnv;
+
+template <typename R, typename... Args, R (*Fn)(Args...)>
+struct WithEnv<Fn> {
+    static R JNICALL call(JNIEnv*, jclass, Args... args) {
+        return Fn(args...);
+    }
+};
+
+// Static natives of OpenGLSurfaceView.RendererNatives, called on every frame
+// or setting change:
+//   - @CriticalNative: take only primitives, with no JNIEnv or jclass, and
+//     only touch atomics. Android 7 ignores the annotation, so below Android 8
+//     they are registered through WithEnv instead.
+//   - @FastNative (nativeSetFrameBudget, nativeSetMotionGate): take a short
+//     lock, and keep the JNIEnv and jclass.
+//   - nativeOnDrawFrame is static and env-free but not annotated. An annotated
+//     call holds off the garbage collector until it returns, and this one
+//     waits on glReadPixels and eglSwapBuffers.
+#define NATIVES_PREFIX(name) Java_com_opencv_edgedetector_gl_OpenGLSurfaceView_00024RendererNatives_##name
+#define STATIC_METHOD(name, signature) {#name, signature, reinterpret_cast<void*>(NATIVES_PREFIX(name))}
+#define CRITICAL_METHOD(name, signature) \
+    {#name, signature, critical ? reinterpret_cast<void*>(NATIVES_PREFIX(name)) \
+                                : reinterpret_cast<void*>(&WithEnv<NATIVES_PREFIX(name)>::call)}
+
+// Helper function to register RendererNatives, with the @CriticalNative
+// entries as such when the runtime honours the annotation
+static bool registerRendererNatives(JNIEnv* env, bool critical) {
+    const JNINativeMethod methods[] = {
+        STATIC_METHOD(nativeOnDrawFrame, "(JZ)V"),
+        CRITICAL_METHOD(nativeSetCameraRotation, "(JIZ)V"),
+        CRITICAL_METHOD(nativeSetEdgeBackend, "(JI)V"),
+        CRITICAL_METHOD(nativeSetAsyncReadback, "(JZ)V"),
+        CRITICAL_METHOD(nativeSetEdgeFormat, "(JI)V"),
+        CRITICAL_METHOD(nativeSetEdgeColor, "(JI)V"),
+        CRITICAL_METHOD(nativeSetProcessingScale, "(JIZ)V"),
+        CRITICAL_METHOD(nativeGetReadbackLatency, "(J)I"),
+        CRITICAL_METHOD(nativeGetTextureAllocationsPerSecond, "(J)I"),
+        CRITICAL_METHOD(nativeGetFrameAllocationsPerSecond, "(J)I"),
+        STATIC_METHOD(nativeSetFrameBudget, "(JFZ)V"),
+        STATIC_METHOD(nativeSetMotionGate, "(JII)V"),
+    };
+    return registerNatives(env, "com/opencv/edgedetector/gl/OpenGLSurfaceView$RendererNatives", methods,
+                           sizeof(methods) / sizeof(methods[0]));
+}
+
+#undef CRITICAL_METHOD
+#undef STATIC_METHOD
+#undef NATIVES_PREFIX
+
+#define BRIDGE_METHOD(name, signature) \
+    {#name, signature, reinterpret_cast<void*>(Java_com_opencv_edgedetector_NativeBridge_##name)}
+
+static const JNINativeMethod kBridgeMethods[] = {
+    BRIDGE_METHOD(initOpenCV, "()V"),
+    BRIDGE_METHOD(nativeProcessImage, "([BII[B)J"),
+    BRIDGE_METHOD(nativeProcessImageBuffer, "(Ljava/nio/ByteBuffer;IIILjava/nio/ByteBuffer;)J"),
+    BRIDGE_METHOD(nativeProcessImages,
+                  "([Ljava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;[I[I[I"
+                  "Lcom/opencv/edgedetector/NativeBridge$ImageCallback;)[J"),
+    BRIDGE_METHOD(nativeSubmitImages, "([Ljava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;[I[I[I)J"),
+    BRIDGE_METHOD(nativeBatchPoll, "(J[JZ)I"),
+    BRIDGE_METHOD(nativeBatchRelease, "(J)V"),
+};
+
+#undef BRIDGE_METHOD
+
+// Helper function to look up a class and keep a global reference to it
+static jclass findGlobalClass(JNIEnv* env, const char* className) {
+    jclass clazz = env->FindClass(className);
+    if (clazz == nullptr) {
+        return nullptr;
+    }
+    jclass global = static_cast<jclass>(env->NewGlobalRef(clazz));
+    env->DeleteLocalRef(clazz);
+    return global;
+}
+
+// Registers every native method and resolves the callbacks once, so no
+// native call pays for a symbol or method lookup. A missing class or
+// method fails the load instead of the first call.
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    
+    if (!registerNatives(env, "com/opencv/edgedetector/gl/OpenGLSurfaceView$OpenGLRenderer", kRendererMethods,
+                         sizeof(kRendererMethods) / sizeof(kRendererMethods[0])) ||
+        !registerRendererNatives(env, android_get_device_api_level() >= __ANDROID_API_O__) ||
+        !registerNatives(env, "com/opencv/edgedetector/NativeBridge", kBridgeMethods,
+                         sizeof(kBridgeMethods) / sizeof(kBridgeMethods[0]))) {
+        return JNI_ERR;
+    }
+    
+    g_jni.vm = vm;
+    g_jni.fpsCallbackClass = findGlobalClass(env, "com/opencv/edgedetector/gl/FpsCallback");
+    g_jni.imageCallbackClass = findGlobalClass(env, "com/opencv/edgedetector/NativeBridge$ImageCallback");
+    g_jni.statsCallbackClass = findGlobalClass(env, "com/opencv/edgedetector/gl/StatsCallback");
+    if (g_jni.fpsCallbackClass == nullptr || g_jni.imageCallbackClass == nullptr ||
+        g_jni.statsCallbackClass == nullptr) {
+        return JNI_ERR;
+    }
+    g_jni.onFpsUpdate = env->GetMethodID(g_jni.fpsCallbackClass, "onFpsUpdate", "(II)V");
+    g_jni.onImageProcessed = env->GetMethodID(g_jni.imageCallbackClass, "onImageProcessed", "(IJ)V");
+    g_jni.onStats = env->GetMethodID(g_jni.statsCallbackClass, "onStats", "([J)V");
+    if (g_jni.onFpsUpdate == nullptr || g_jni.onImageProcessed == nullptr || g_jni.onStats == nullptr) {
+        return JNI_ERR;
+    }
+    return JNI_VERSION_1_6;
+}
@@ -24,6 +24,7 @@ class MainActivity : AppCompatActivity() {
     
     companion object {
         private const val CAMERA_PERMISSION_REQUEST_CODE = 100
+        private const val FRAME_BUDGET_MS = 25f
     }
     
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -55,11 +56,26 @@ class MainActivity : AppCompatActivity() {
             }
         }
         
-        // Update FPS counter
-        glSurfaceView.setFpsCallback(object : com.opencv.edgedetector.gl.FpsCallback {
-            override fun onFpsUpdate(fps: Int) {
+        // Keep edge processing within a 30 fps frame, trading quality for time when throttled
+        glSurfaceView.setFrameBudget(FRAME_BUDGET_MS)
+        
+        // Update FPS counter from the stats reporter, off the render thread
+        glSurfaceView.setStatsCallback(object : com.opencv.edgedetector.gl.StatsCallback {
+            override fun onStats(stats: LongArray) {
+                val upload = glSurfaceView.getUploadStats()
+                val displayFps = stats[OpenGLSurfaceView.STATS_DISPLAY_FPS]
+                val processingFps = stats[OpenGLSurfaceView.STATS_PROCESSING_FPS]
+                val quality = stats[OpenGLSurfaceView.STATS_QUALITY_LEVEL]
+                // Frame time percentiles over the last second
+                val frame = OpenGLSurfaceView.STATS_STAGES +
+                    OpenGLSurfaceView.STAGE_FRAME * OpenGLSurfaceView.STAGE_FIELD_COUNT
+                val p50 = stats[frame + OpenGLSurfaceView.STAGE_STAT_P50] / 1000
+                val p99 = stats[frame + OpenGLSurfaceView.STAGE_STAT_P99] / 1000
                 runOnUiThread {
-                    fpsTextView.text = "FPS: $fps"
+                    fpsTextView.text = "FPS: $displayFps (edges: $processingFps)\n" +
+                        "Upload: ${upload[1] / 1024} KB, ${upload[2] / 1000} us\n" +
+                        "Frame: p50 $p50 us, p99 $p99 us\n" +
+                        "Quality: level $quality"
                 }
             }
         })
@@ -1,28 +1,193 @@
 package com.opencv.edgedetector
 
+import java.nio.ByteBuffer
+
 object NativeBridge {
     init {
         System.loadLibrary("opencv_edge_detector")
     }
     
     /**
-     * Process image using OpenCV Canny edge detection
-     * @param inputData Input image data (RGBA bytes)
+     * Process image using OpenCV Canny edge detection. The image is copied
+     * in and the edges copied out, so neither array stays pinned while the
+     * kernel runs; the ByteBuffer version avoids both copies.
+     * @param inputData Input image data (RGBA bytes, rows top to bottom)
      * @param width Image width
      * @param height Image height
-     * @param outputData Output buffer for processed image
-     * @return Processing time in milliseconds
+     * @param outputData Output buffer for processed image (RGBA, width * height * 4 bytes)
+     * @return Processing time in nanoseconds, or -1 if a buffer is too small
      */
-    external fun processImage(
+    fun processImage(
         inputData: ByteArray,
         width: Int,
         height: Int,
         outputData: ByteArray
-    ): Long
+    ): Long {
+        return nativeProcessImage(inputData, width, height, outputData)
+    }
+    
+    /**
+     * Same as the ByteArray version for direct buffers, e.g. a Bitmap copied
+     * with copyPixelsToBuffer. The image is read and written in place in the
+     * buffers' memory, from their start regardless of position.
+     * @param input Input image (RGBA, rows [rowStride] bytes apart)
+     * @param width Image width
+     * @param height Image height
+     * @param output Output buffer for processed image (RGBA, width * height * 4 bytes)
+     * @param rowStride Bytes between input rows, e.g. Bitmap.rowBytes
+     * @return Processing time in nanoseconds, or -1 if a buffer is too small
+     */
+    fun processImage(
+        input: ByteBuffer,
+        width: Int,
+        height: Int,
+        output: ByteBuffer,
+        rowStride: Int = width * 4
+    ): Long {
+        require(input.isDirect && output.isDirect) { "processImage needs direct ByteBuffers" }
+        return nativeProcessImageBuffer(input, width, height, rowStride, output)
+    }
+    
+    /**
+     * Receives the images of a [processImages] batch as they finish
+     */
+    fun interface ImageCallback {
+        fun onImageProcessed(index: Int, nanos: Long)
+    }
+    
+    /**
+     * Processes a batch of images concurrently on a native worker pool sized
+     * to the big cores, in a single JNI call. Buffers are direct and used in
+     * place, as in [processImage]; image i is widths[i] x heights[i] pixels.
+     * @param inputs Input images (RGBA)
+     * @param outputs Output buffers, width * height * 4 bytes each
+     * @param widths Image widths
+     * @param heights Image heights
+     * @param rowStrides Bytes between input rows per image, null for tightly packed rows
+     * @param callback Called on this thread as each image finishes, in completion order
+     * @return Processing time of each image in nanoseconds, -1 for images whose buffers are too small
+     */
+    fun processImages(
+        inputs: Array<ByteBuffer>,
+        outputs: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray? = null,
+        callback: ImageCallback? = null
+    ): LongArray {
+        requireBatch(inputs, outputs, widths, heights, rowStrides)
+        return nativeProcessImages(inputs, outputs, widths, heights, rowStrides, callback)
+    }
+    
+    /**
+     * Same as [processImages] but returns at once; poll the returned batch
+     * for completions and close it when done.
+     */
+    fun submitImages(
+        inputs: Array<ByteBuffer>,
+        outputs: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray? = null
+    ): ImageBatch {
+        requireBatch(inputs, outputs, widths, heights, rowStrides)
+        return ImageBatch(nativeSubmitImages(inputs, outputs, widths, heights, rowStrides), inputs, outputs)
+    }
     
     /**
-     * Initialize OpenCV
+     * Images queued by [submitImages]. Holds on to their buffers until
+     * [close], which waits for any image still being processed.
+     */
+    class ImageBatch internal constructor(
+        private var handle: Long,
+        private val inputs: Array<ByteBuffer>,
+        private val outputs: Array<ByteBuffer>
+    ) : AutoCloseable {
+        val size: Int
+            get() = inputs.size
+        
+        /**
+         * Copies each image's processing time in nanoseconds into [nanos]
+         * (-1 while pending or for invalid images) and returns the number
+         * of images done.
+         */
+        fun poll(nanos: LongArray): Int {
+            check(handle != 0L) { "batch closed" }
+            return nativeBatchPoll(handle, nanos, false)
+        }
+        
+        /**
+         * Waits for every image and returns their processing times
+         */
+        fun await(): LongArray {
+            check(handle != 0L) { "batch closed" }
+            val nanos = LongArray(size)
+            nativeBatchPoll(handle, nanos, true)
+            return nanos
+        }
+        
+        override fun close() {
+            if (handle != 0L) {
+                nativeBatchRelease(handle)
+                handle = 0L
+            }
+        }
+    }
+    
+    private fun requireBatch(
+        inputs: Array<ByteBuffer>,
+        outputs: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?
+    ) {
+        val count = inputs.size
+        require(outputs.size == count && widths.size == count && heights.size == count &&
+                (rowStrides == null || rowStrides.size == count)) { "batch arrays differ in length" }
+        require(inputs.all { it.isDirect } && outputs.all { it.isDirect }) { "processImages needs direct ByteBuffers" }
+    }
+    
+    /**
+     * Initialize OpenCV: starts its worker threads, so the first image
+     * processed doesn't pay for it
      */
     external fun initOpenCV()
+    
+    // Native methods, registered by JNI_OnLoad (kBridgeMethods in
+    // native_renderer.cpp): a signature change must be made there too
+    private external fun nativeProcessImage(
+        inputData: ByteArray,
+        width: Int,
+        height: Int,
+        outputData: ByteArray
+    ): Long
+    
+    private external fun nativeProcessImageBuffer(
+        input: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowStride: Int,
+        output: ByteBuffer
+    ): Long
+    
+    private external fun nativeProcessImages(
+        inputs: Array<ByteBuffer>,
+        outputs: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?,
+        callback: ImageCallback?
+    ): LongArray
+    
+    private external fun nativeSubmitImages(
+        inputs: Array<ByteBuffer>,
+        outputs: Array<ByteBuffer>,
+        widths: IntArray,
+        heights: IntArray,
+        rowStrides: IntArray?
+    ): Long
+    
+    private external fun nativeBatchPoll(batch: Long, nanos: LongArray, wait: Boolean): Int
+    
+    private external fun nativeBatchRelease(batch: Long)
 }
-
@@ -1,6 +1,12 @@
 package com.opencv.edgedetector.gl
 
 interface FpsCallback {
-    fun onFpsUpdate(fps: Int)
+    /**
+     * Called on the renderer's stats reporter thread, never the render thread,
+     * once a second or at the [StatsCallback] interval.
+     * @param displayFps frames drawn per second by the render thread
+     * @param processingFps edge frames completed per second by the active
+     *        backend; lower than [displayFps] when processing cannot keep up
+     */
+    fun onFpsUpdate(displayFps: Int, processingFps: Int)
 }
-
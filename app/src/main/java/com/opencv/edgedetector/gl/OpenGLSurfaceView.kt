@@ -6,7 +6,13 @@ import android.opengl.GLSurfaceView
 import android.util.AttributeSet
 import android.view.Surface
 import android.opengl.GLES20
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.nio.ByteBuffer
+import javax.microedition.khronos.egl.EGL10
 import javax.microedition.khronos.egl.EGLConfig
+import javax.microedition.khronos.egl.EGLContext
+import javax.microedition.khronos.egl.EGLDisplay
 import javax.microedition.khronos.opengles.GL10
 
 class OpenGLSurfaceView : GLSurfaceView {
@@ -24,7 +30,7 @@ class OpenGLSurfaceView : GLSurfaceView {
     }
     
     private fun initialize(context: Context) {
-        setEGLContextClientVersion(2)
+        setEGLContextFactory(ContextFactory())
         renderer = OpenGLRenderer(context, this)
         setRenderer(renderer)
         renderMode = RENDERMODE_CONTINUOUSLY
@@ -42,18 +48,324 @@ class OpenGLSurfaceView : GLSurfaceView {
         }
     }
     
+    /**
+     * Delivers a stats record every [intervalMs] on a native reporter thread:
+     * display and processing FPS, frame totals, dropped frames and every
+     * stage's latency over the interval (see the `STATS_` constants). Also
+     * sets how often the [FpsCallback] runs. Pass null to stop the records.
+     */
+    fun setStatsCallback(callback: StatsCallback?, intervalMs: Int = 1000) {
+        if (::renderer.isInitialized) {
+            renderer.setStatsCallback(callback, intervalMs)
+        }
+    }
+    
     fun setCameraRotation(rotation: Int, isFrontCamera: Boolean) {
         if (::renderer.isInitialized) {
             renderer.setCameraRotation(rotation, isFrontCamera)
         }
     }
     
+    /**
+     * Selects where edge detection runs: [EDGE_BACKEND_CPU] (OpenCV on read-back
+     * frames) or [EDGE_BACKEND_GPU] (GLSL passes, no readback). The GPU backend
+     * needs OpenGL ES 3; without it the CPU backend stays in use.
+     */
+    fun setEdgeBackend(backend: Int) {
+        if (::renderer.isInitialized) {
+            renderer.setEdgeBackend(backend)
+        }
+    }
+    
+    fun setAsyncReadback(enabled: Boolean) {
+        if (::renderer.isInitialized) {
+            renderer.setAsyncReadback(enabled)
+        }
+    }
+    
+    /**
+     * How many frames the displayed edge frame lags the camera frame
+     * (0 with synchronous readback).
+     */
+    fun getReadbackLatencyFrames(): Int {
+        return if (::renderer.isInitialized) renderer.getReadbackLatencyFrames() else 0
+    }
+    
+    /**
+     * Texture storage allocations during the last second. Stays at 0 once the
+     * camera size is stable; anything else means textures are being recreated.
+     */
+    fun getTextureAllocationsPerSecond(): Int {
+        return if (::renderer.isInitialized) renderer.getTextureAllocationsPerSecond() else 0
+    }
+    
+    /**
+     * Heap allocations for frame buffers during the last second. Frames come
+     * from a native pool, so this stays at 0 once processing has warmed up.
+     */
+    fun getFrameAllocationsPerSecond(): Int {
+        return if (::renderer.isInitialized) renderer.getFrameAllocationsPerSecond() else 0
+    }
+    
+    /**
+     * Selects how CPU edge maps are uploaded: [EDGE_FORMAT_RGBA] (4 bytes per
+     * pixel), [EDGE_FORMAT_GRAY] (1 byte) or [EDGE_FORMAT_PACKED] (1 bit,
+     * expanded by the fragment shader). All three look the same on screen.
+     */
+    fun setEdgeFormat(format: Int) {
+        if (::renderer.isInitialized) {
+            renderer.setEdgeFormat(format)
+        }
+    }
+    
+    /**
+     * Color edges are drawn in, as an ARGB int (e.g. android.graphics.Color.GREEN).
+     */
+    fun setEdgeColor(color: Int) {
+        if (::renderer.isInitialized) {
+            renderer.setEdgeColor(color)
+        }
+    }
+    
+    /**
+     * Edge uploads over the last second as {format, bytes per frame,
+     * nanoseconds per frame}; bytes and time are 0 when nothing is uploaded
+     * (GPU backend).
+     */
+    fun getUploadStats(): IntArray {
+        return if (::renderer.isInitialized) renderer.getUploadStats() else IntArray(3)
+    }
+    
+    /**
+     * Latency of every pipeline stage in one array: for each stage, in
+     * [STAGE_FRAME]..[STAGE_SWAP] order, [STAGE_FIELD_COUNT] longs
+     * {sample count, p50, p90, p99, max, last}, times in nanoseconds. Read a
+     * value as `stats[stage * STAGE_FIELD_COUNT + field]`. Percentiles come from
+     * log-scale histograms and are accurate to about 9%. GL stages measure CPU
+     * submission time, not GPU execution.
+     *
+     * With [reset], the next call only covers what happened after this one.
+     */
+    fun getStageStats(reset: Boolean = false): LongArray {
+        return if (::renderer.isInitialized) renderer.getStageStats(reset) else LongArray(STAGE_COUNT * STAGE_FIELD_COUNT)
+    }
+    
+    /**
+     * Starts or stops recording a timeline of every pipeline stage on every
+     * native thread. Starting clears the previous recording. The buffer is
+     * fixed-size (65536 spans, a few minutes of frames); later spans are dropped.
+     */
+    fun setTracing(enabled: Boolean) {
+        if (::renderer.isInitialized) {
+            renderer.setTracing(enabled)
+        }
+    }
+    
+    /**
+     * Writes the recorded timeline to [path] as Chrome trace-event JSON, which
+     * the Perfetto UI (ui.perfetto.dev) opens. Returns false if nothing could
+     * be written. Works while tracing is still running.
+     */
+    fun dumpTrace(path: String): Boolean {
+        return ::renderer.isInitialized && renderer.dumpTrace(path)
+    }
+    
+    /**
+     * Records every frame that goes through edge detection to [path], with
+     * room for [maxFrames] frames. The recording replays on a workstation with
+     * `edge_replay`. Frames are written on a background thread; if the disk
+     * can't keep up they are dropped rather than slowing down processing.
+     * Returns false if the file can't be created.
+     */
+    fun startRecording(path: String, maxFrames: Int = 900): Boolean {
+        return ::renderer.isInitialized && renderer.startRecording(path, maxFrames)
+    }
+    
+    /**
+     * Finishes the recording started by [startRecording] and returns the
+     * number of frames written and dropped, in that order.
+     */
+    fun stopRecording(): IntArray {
+        return if (::renderer.isInitialized) renderer.stopRecording() else IntArray(2)
+    }
+    
+    /**
+     * Counts of the frames submitted with processFrame/processFrameBuffer
+     * since the renderer started: published, consumed by the worker, and
+     * overwritten by a newer frame before the worker got to them (the
+     * fourth, dropped, stays 0 since the newest frame always wins).
+     */
+    fun getSubmittedFrameCounters(): LongArray {
+        return if (::renderer.isInitialized) renderer.getSubmittedFrameCounters() else LongArray(4)
+    }
+    
+    /**
+     * Lets the quality governor hold the CPU edge kernel to [budgetMs] per
+     * camera frame. Over budget it steps down through lower processing
+     * resolutions and skipped frames; with headroom it steps back up to the
+     * default quality, or with [higherQuality] as far as Gaussian blur and L2
+     * gradients, which change the edges drawn. 0 turns it off and restores
+     * the default quality. The GPU backend is not governed.
+     */
+    fun setFrameBudget(budgetMs: Float, higherQuality: Boolean = false) {
+        if (::renderer.isInitialized) {
+            renderer.setFrameBudget(budgetMs, higherQuality)
+        }
+    }
+    
+    /**
+     * The governor's recent quality level changes, oldest first, as
+     * [QUALITY_TRANSITION_FIELD_COUNT] longs each: timestamp (ns), previous
+     * level, new level and the measured cost per frame (ns) behind the change.
+     * Level 0 is the best quality; the current level is in the stats record.
+     */
+    fun getQualityTransitions(): LongArray {
+        return if (::renderer.isInitialized) renderer.getQualityTransitions() else LongArray(0)
+    }
+    
+    /**
+     * Runs the CPU edge kernel on the frame shrunk by [scale] (1, 2 or 4 per
+     * side) and lets the GPU magnify the smaller edge map to the view, with
+     * [linearMagnification] or nearest sampling. Previews rarely need
+     * full-resolution edges, and 1/2 does about a quarter of the work. The
+     * quality governor may shrink further, never less.
+     */
+    fun setProcessingScale(scale: Int, linearMagnification: Boolean = true) {
+        if (::renderer.isInitialized) {
+            renderer.setProcessingScale(scale, linearMagnification)
+        }
+    }
+    
+    /**
+     * Skips edge detection on camera frames that look like the last processed
+     * one, for fixed cameras watching mostly static scenes: the previous edge
+     * texture stays on screen and nothing is uploaded, and while the scene
+     * stays static only every few frames are read back to look for motion. A
+     * frame counts as changed when the mean luma of any 32x32 block moved by
+     * more than [threshold] (0..255; 4 ignores sensor noise). At least one
+     * frame per [refreshMs] is processed regardless. 0 turns gating off.
+     * Skipped frames are counted in [STATS_FRAMES_STATIC] and
+     * [STATS_READBACKS_SKIPPED]. The GPU backend is not gated.
+     */
+    fun setMotionGating(threshold: Int, refreshMs: Int = 1000) {
+        if (::renderer.isInitialized) {
+            renderer.setMotionGating(threshold, refreshMs)
+        }
+    }
+    
+    /**
+     * Prefers an OpenGL ES 3 context, which enables asynchronous PBO readback,
+     * and falls back to ES 2 on devices without it.
+     */
+    private class ContextFactory : GLSurfaceView.EGLContextFactory {
+        override fun createContext(egl: EGL10, display: EGLDisplay, config: EGLConfig): EGLContext {
+            for (version in intArrayOf(3, 2)) {
+                val attribs = intArrayOf(EGL_CONTEXT_CLIENT_VERSION, version, EGL10.EGL_NONE)
+                val context = egl.eglCreateContext(display, config, EGL10.EGL_NO_CONTEXT, attribs)
+                if (context != null && context != EGL10.EGL_NO_CONTEXT) {
+                    return context
+                }
+            }
+            return EGL10.EGL_NO_CONTEXT
+        }
+        
+        override fun destroyContext(egl: EGL10, display: EGLDisplay, context: EGLContext) {
+            egl.eglDestroyContext(display, context)
+        }
+    }
+    
     companion object {
+        const val EDGE_BACKEND_CPU = 0
+        const val EDGE_BACKEND_GPU = 1
+        
+        const val EDGE_FORMAT_RGBA = 0
+        const val EDGE_FORMAT_GRAY = 1
+        const val EDGE_FORMAT_PACKED = 2
+        
+        // Stages reported by getStageStats, as in core/stage_stats.h
+        const val STAGE_FRAME = 0
+        const val STAGE_FBO_RENDER = 1
+        const val STAGE_READBACK = 2
+        const val STAGE_CANNY = 3
+        const val STAGE_CANNY_GRADIENT = 4
+        const val STAGE_CANNY_HYSTERESIS = 5
+        const val STAGE_CANNY_OUTPUT = 6
+        const val STAGE_LUMA_CANNY = 7
+        const val STAGE_GPU_CANNY = 8
+        const val STAGE_UPLOAD = 9
+        const val STAGE_DRAW = 10
+        const val STAGE_SWAP = 11
+        const val STAGE_COUNT = 12
+        
+        // Fields per stage
+        const val STAGE_STAT_COUNT = 0
+        const val STAGE_STAT_P50 = 1
+        const val STAGE_STAT_P90 = 2
+        const val STAGE_STAT_P99 = 3
+        const val STAGE_STAT_MAX = 4
+        const val STAGE_STAT_LAST = 5
+        const val STAGE_FIELD_COUNT = 6
+        
+        // Fields of a StatsCallback record. Stage latencies start at
+        // STATS_STAGES, laid out as in getStageStats:
+        // stats[STATS_STAGES + stage * STAGE_FIELD_COUNT + field]
+        const val STATS_TIMESTAMP_NANOS = 0
+        const val STATS_INTERVAL_NANOS = 1
+        const val STATS_DISPLAY_FPS = 2
+        const val STATS_PROCESSING_FPS = 3
+        const val STATS_FRAMES_DRAWN = 4
+        const val STATS_FRAMES_PROCESSED = 5
+        const val STATS_SUBMITTED_OVERWRITTEN = 6
+        const val STATS_RECORDER_DROPPED = 7
+        const val STATS_QUALITY_LEVEL = 8
+        const val STATS_QUALITY_COST_NANOS = 9
+        const val STATS_QUALITY_TRANSITIONS = 10
+        const val STATS_FRAMES_SKIPPED = 11
+        const val STATS_FRAMES_STATIC = 12
+        const val STATS_READBACKS_SKIPPED = 13
+        const val STATS_STAGES = 14
+        const val STATS_FIELD_COUNT = STATS_STAGES + STAGE_COUNT * STAGE_FIELD_COUNT
+        
+        // Quality governor levels, best first, and the getQualityTransitions layout
+        const val QUALITY_LEVEL_COUNT = 8
+        const val QUALITY_LEVEL_DEFAULT = 3
+        const val QUALITY_TRANSITION_FIELD_COUNT = 4
+        
+        private const val EGL_CONTEXT_CLIENT_VERSION = 0x3098
+        
         init {
             System.loadLibrary("opencv_edge_detector")
         }
     }
     
+    /**
+     * Natives the renderer calls on every frame or setting change, as static
+     * methods that take only primitives so ART can skip most of the JNI
+     * transition. The @CriticalNative ones get no JNIEnv or class either and
+     * only touch atomics; the @FastNative ones take a short native lock. Below
+     * Android 8 the annotations are ignored and JNI_OnLoad registers adapters
+     * instead. nativeOnDrawFrame is left unannotated: an annotated call holds
+     * off garbage collection until it returns, and a frame waits on readback
+     * and buffer swaps. Registered by JNI_OnLoad (registerRendererNatives in
+     * native_renderer.cpp): a signature change must be made there too.
+     */
+    private object RendererNatives {
+        @JvmStatic external fun nativeOnDrawFrame(renderer: Long, processEdges: Boolean)
+        
+        @CriticalNative @JvmStatic external fun nativeSetCameraRotation(renderer: Long, rotation: Int, isFrontCamera: Boolean)
+        @CriticalNative @JvmStatic external fun nativeSetEdgeBackend(renderer: Long, backend: Int)
+        @CriticalNative @JvmStatic external fun nativeSetAsyncReadback(renderer: Long, enabled: Boolean)
+        @CriticalNative @JvmStatic external fun nativeSetEdgeFormat(renderer: Long, format: Int)
+        @CriticalNative @JvmStatic external fun nativeSetEdgeColor(renderer: Long, color: Int)
+        @CriticalNative @JvmStatic external fun nativeSetProcessingScale(renderer: Long, scale: Int, linearMagnification: Boolean)
+        @CriticalNative @JvmStatic external fun nativeGetReadbackLatency(renderer: Long): Int
+        @CriticalNative @JvmStatic external fun nativeGetTextureAllocationsPerSecond(renderer: Long): Int
+        @CriticalNative @JvmStatic external fun nativeGetFrameAllocationsPerSecond(renderer: Long): Int
+        
+        @FastNative @JvmStatic external fun nativeSetFrameBudget(renderer: Long, budgetMs: Float, higherQuality: Boolean)
+        @FastNative @JvmStatic external fun nativeSetMotionGate(renderer: Long, threshold: Int, refreshMs: Int)
+    }
+    
     inner class OpenGLRenderer(
         private val context: Context,
         private val glSurfaceView: OpenGLSurfaceView
@@ -108,7 +420,7 @@ class OpenGLSurfaceView : GLSurfaceView {
             cameraSurfaceTexture?.updateTexImage()
             
             // Render frame
-            nativeOnDrawFrame(nativeRenderer, processingMode)
+            RendererNatives.nativeOnDrawFrame(nativeRenderer, processingMode)
         }
         
         override fun onFrameAvailable(surfaceTexture: SurfaceTexture?) {
@@ -133,10 +445,66 @@ class OpenGLSurfaceView : GLSurfaceView {
             nativeSetFpsCallback(nativeRenderer, callback)
         }
         
+        fun setStatsCallback(callback: StatsCallback?, intervalMs: Int) {
+            nativeSetStatsCallback(nativeRenderer, callback, intervalMs)
+        }
+        
         fun setCameraRotation(rotation: Int, isFront: Boolean) {
             cameraRotation = rotation
             isFrontCamera = isFront
-            nativeSetCameraRotation(nativeRenderer, rotation, isFront)
+            RendererNatives.nativeSetCameraRotation(nativeRenderer, rotation, isFront)
+        }
+        
+        fun setEdgeBackend(backend: Int) {
+            RendererNatives.nativeSetEdgeBackend(nativeRenderer, backend)
+        }
+        
+        fun setAsyncReadback(enabled: Boolean) {
+            RendererNatives.nativeSetAsyncReadback(nativeRenderer, enabled)
+        }
+        
+        fun getReadbackLatencyFrames(): Int {
+            return RendererNatives.nativeGetReadbackLatency(nativeRenderer)
+        }
+        
+        fun getTextureAllocationsPerSecond(): Int {
+            return RendererNatives.nativeGetTextureAllocationsPerSecond(nativeRenderer)
+        }
+        
+        fun getFrameAllocationsPerSecond(): Int {
+            return RendererNatives.nativeGetFrameAllocationsPerSecond(nativeRenderer)
+        }
+        
+        fun setEdgeFormat(format: Int) {
+            RendererNatives.nativeSetEdgeFormat(nativeRenderer, format)
+        }
+        
+        fun setEdgeColor(color: Int) {
+            RendererNatives.nativeSetEdgeColor(nativeRenderer, color)
+        }
+        
+        fun getUploadStats(): IntArray {
+            return nativeGetUploadStats(nativeRenderer)
+        }
+        
+        fun getStageStats(reset: Boolean): LongArray {
+            return nativeGetStageStats(nativeRenderer, reset)
+        }
+        
+        fun setTracing(enabled: Boolean) {
+            nativeSetTracing(nativeRenderer, enabled)
+        }
+        
+        fun dumpTrace(path: String): Boolean {
+            return nativeDumpTrace(nativeRenderer, path)
+        }
+        
+        fun startRecording(path: String, maxFrames: Int): Boolean {
+            return nativeStartRecording(nativeRenderer, path, maxFrames)
+        }
+        
+        fun stopRecording(): IntArray {
+            return nativeStopRecording(nativeRenderer)
         }
         
         protected fun finalize() {
@@ -145,18 +513,93 @@ class OpenGLSurfaceView : GLSurfaceView {
             nativeRelease(nativeRenderer)
         }
         
+        /**
+         * Runs edge detection on a top-down RGBA frame on the renderer's
+         * worker. The array is copied once, without taking a lock. Once
+         * frames arrive this way the renderer stops reading back the camera
+         * texture.
+         */
         fun processFrame(frameData: ByteArray, width: Int, height: Int) {
             nativeProcessFrame(nativeRenderer, frameData, width, height)
         }
         
-        // Native methods
+        /**
+         * Returns a direct buffer over native frame memory to fill with a
+         * width x height RGBA frame and pass to [processFrameBuffer].
+         */
+        fun acquireFrameBuffer(width: Int, height: Int): ByteBuffer? {
+            return nativeAcquireFrameBuffer(nativeRenderer, width, height)
+        }
+        
+        /**
+         * Like [processFrame] for a direct buffer. A buffer from
+         * [acquireFrameBuffer], or returned by the previous call, is handed to
+         * the worker without any copy; other direct buffers are copied once.
+         * Returns the buffer to fill next. A submitted buffer must not be
+         * touched again, and buffers are only valid for the size they were
+         * acquired for: passed with another size, the frame is rejected and
+         * null returned. Call from one thread.
+         */
+        fun processFrameBuffer(frameBuffer: ByteBuffer, width: Int, height: Int): ByteBuffer? {
+            return nativeProcessFrameBuffer(nativeRenderer, frameBuffer, width, height)
+        }
+        
+        fun getSubmittedFrameCounters(): LongArray {
+            return nativeGetSubmittedFrameCounters(nativeRenderer)
+        }
+        
+        fun setFrameBudget(budgetMs: Float, higherQuality: Boolean) {
+            RendererNatives.nativeSetFrameBudget(nativeRenderer, budgetMs, higherQuality)
+        }
+        
+        fun getQualityTransitions(): LongArray {
+            return nativeGetQualityTransitions(nativeRenderer)
+        }
+        
+        fun setProcessingScale(scale: Int, linearMagnification: Boolean) {
+            RendererNatives.nativeSetProcessingScale(nativeRenderer, scale, linearMagnification)
+        }
+        
+        fun setMotionGating(threshold: Int, refreshMs: Int) {
+            RendererNatives.nativeSetMotionGate(nativeRenderer, threshold, refreshMs)
+        }
+        
+        /**
+         * Runs edge detection directly on the Y plane of a YUV_420_888 image
+         * (a direct buffer, e.g. Image.planes[0].buffer). Once frames arrive
+         * this way the renderer stops reading back the camera texture.
+         */
+        fun processYuvFrame(yPlane: ByteBuffer, width: Int, height: Int, rowStride: Int, pixelStride: Int) {
+            nativeProcessYuvFrame(nativeRenderer, yPlane, width, height, rowStride, pixelStride)
+        }
+        
+        /**
+         * Runs edge detection on the Y plane of an NV21 or I420 frame.
+         */
+        fun processNv21Frame(frameData: ByteArray, width: Int, height: Int) {
+            nativeProcessNv21Frame(nativeRenderer, frameData, width, height)
+        }
+        
+        // Native methods, registered by JNI_OnLoad (kRendererMethods in
+        // native_renderer.cpp): a signature change must be made there too
         private external fun nativeInit(): Long
         private external fun nativeOnSurfaceCreated(renderer: Long, textureId: Int)
         private external fun nativeOnSurfaceChanged(renderer: Long, width: Int, height: Int)
-        private external fun nativeOnDrawFrame(renderer: Long, processEdges: Boolean)
         private external fun nativeSetFpsCallback(renderer: Long, callback: FpsCallback)
-        private external fun nativeSetCameraRotation(renderer: Long, rotation: Int, isFrontCamera: Boolean)
+        private external fun nativeSetStatsCallback(renderer: Long, callback: StatsCallback?, intervalMs: Int)
+        private external fun nativeGetUploadStats(renderer: Long): IntArray
+        private external fun nativeGetStageStats(renderer: Long, reset: Boolean): LongArray
+        private external fun nativeSetTracing(renderer: Long, enabled: Boolean)
+        private external fun nativeDumpTrace(renderer: Long, path: String): Boolean
+        private external fun nativeStartRecording(renderer: Long, path: String, maxFrames: Int): Boolean
+        private external fun nativeStopRecording(renderer: Long): IntArray
         private external fun nativeProcessFrame(renderer: Long, frameData: ByteArray, width: Int, height: Int)
+        private external fun nativeAcquireFrameBuffer(renderer: Long, width: Int, height: Int): ByteBuffer?
+        private external fun nativeProcessFrameBuffer(renderer: Long, frameBuffer: ByteBuffer, width: Int, height: Int): ByteBuffer?
+        private external fun nativeGetSubmittedFrameCounters(renderer: Long): LongArray
+        private external fun nativeGetQualityTransitions(renderer: Long): LongArray
+        private external fun nativeProcessYuvFrame(renderer: Long, yPlane: ByteBuffer, width: Int, height: Int, rowStride: Int, pixelStride: Int)
+        private external fun nativeProcessNv21Frame(renderer: Long, frameData: ByteArray, width: Int, height: Int)
         private external fun nativeRelease(renderer: Long)
     }
 }
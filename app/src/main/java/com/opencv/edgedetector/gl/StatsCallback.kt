@@ -0,0 +1,12 @@
+package com.opencv.edgedetector.gl
+
+interface StatsCallback {
+    /**
+     * Called on the renderer's stats reporter thread at the interval given to
+     * [OpenGLSurfaceView.setStatsCallback].
+     * @param stats one record, read with the `STATS_` constants of
+     *        [OpenGLSurfaceView]; the array is reused for the next record, so
+     *        copy what you keep
+     */
+    fun onStats(stats: LongArray)
+}